@@ -0,0 +1,150 @@
+/******************************************************
+-     Date:  2026.10.20 09:30
+-     File:  bench_macro.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "benchmark.hpp"
+#include "programs.hpp"
+#include "../src/vm/aot.hpp"
+#include "../src/vm/optimizer.hpp"
+#include "../src/vm/task.hpp"
+#include <filesystem>
+#include <map>
+
+using namespace benchprog;
+
+namespace {
+
+/**
+ * 运行完整程序，参数为程序规模
+ * @param build 构造程序
+ * @param verified 是否走校验后的无检查路径
+ * @param optimized 是否先经过优化器
+ * @param per_step 参数为循环步数时按步数统计吞吐
+ */
+template<typename Build>
+lmbench::Function program(Build build, bool verified, bool optimized = false, bool per_step = true) {
+    return [build, verified, optimized, per_step](lmbench::State& state) {
+        BenchVM vm;
+        std::vector<Instruction> entry = build(vm, state.range(0));
+        if (optimized) Optimizer::optimizeVM(vm, entry);
+        if (verified) vm.verify(entry);
+        for ([[maybe_unused]] auto _ : state) {
+            if (verified) vm.runVerified(entry);
+            else vm.run(entry);
+        }
+        lmbench::DoNotOptimize(vm.registers[0]);
+        if (per_step) state.SetItemsProcessed(state.iterations() * state.range(0));
+    };
+}
+
+/**
+ * 同一程序经 AOT 编译后执行，模块按名字缓存，只在首次运行时编译
+ * 树内没有 JIT，与解释器的 checked/verified/optimized 三档对比
+ * @param build 构造程序
+ * @param name 模块名
+ * @param per_step 参数为循环步数时按步数统计吞吐
+ */
+template<typename Build>
+lmbench::Function aotProgram(Build build, std::string name, bool per_step = true) {
+    return [build, name, per_step](lmbench::State& state) {
+        static std::map<std::string, std::string> modules;
+        BenchVM vm;
+        std::vector<Instruction> entry = build(vm, state.range(0));
+        Optimizer::optimizeVM(vm, entry);
+        vm.verify(entry);
+        const std::string key = name + "/" + std::to_string(state.range(0));
+        auto it = modules.find(key);
+        if (it == modules.end()) {
+            const std::string path = (std::filesystem::temp_directory_path() / ("lmvm_bench_aot_" + name + ".so")).string();
+            try {
+                AotCompiler::compile(vm, entry, path);
+            } catch (const std::exception& e) {
+                state.SkipWithError(e.what());
+                return;
+            }
+            it = modules.emplace(key, path).first;
+        }
+        AotModule module(it->second);
+        module.bind(vm, entry);
+        for ([[maybe_unused]] auto _ : state) module.run();
+        lmbench::DoNotOptimize(vm.registers[0]);
+        if (per_step) state.SetItemsProcessed(state.iterations() * state.range(0));
+    };
+}
+
+/**
+ * 同一程序在 VmTask 中按时间片运行，参数为程序规模与每片燃料
+ * 与 verified 对比得到切换栈与挂起/恢复的开销；燃料足够一片跑完时只剩建任务的固定开销
+ * @param build 构造程序
+ */
+template<typename Build>
+lmbench::Function slicedProgram(Build build) {
+    return [build](lmbench::State& state) {
+        BenchVM vm;
+        std::vector<Instruction> entry = build(vm, state.range(0));
+        vm.verify(entry);
+        int64_t slices = 0;
+        for ([[maybe_unused]] auto _ : state) {
+            VmTask task(vm, entry);
+            while (task.resume(state.range(1)) == VmTask::State::Suspended) ++slices;
+        }
+        lmbench::DoNotOptimize(vm.registers[0]);
+        lmbench::DoNotOptimize(slices);
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    };
+}
+
+// 跳转块自递归每层占用一个 C++ 栈帧，循环次数控制在 1000 左右
+const bool kProgramsRegistered = [] {
+    lmbench::Register("macro/fib/checked", program(fib, false, false, false))->Arg(20);
+    lmbench::Register("macro/fib/verified", program(fib, true, false, false))->Arg(20);
+    lmbench::Register("macro/fib/optimized", program(fib, true, true, false))->Arg(20);
+    lmbench::Register("macro/fib/aot", aotProgram(fib, "fib", false))->Arg(20);
+    lmbench::Register("macro/loop/checked", program(countLoop, false))->Arg(1000);
+    lmbench::Register("macro/loop/verified", program(countLoop, true))->Arg(1000);
+    lmbench::Register("macro/loop/aot", aotProgram(countLoop, "loop"))->Arg(1000);
+    lmbench::Register("macro/loop/sliced", slicedProgram(countLoop))->Args({1000, 64})->Args({1000, 1 << 20});
+    // 未优化时每层递归嵌套一次 execute；TAILCALL 复用帧，深度不受栈限制
+    lmbench::Register("macro/recursion/verified", program(countRecursion, true))->Arg(1000);
+    lmbench::Register("macro/recursion/optimized", program(countRecursion, true, true))->Arg(1000)->Arg(1000000);
+    lmbench::Register("macro/recursion/aot", aotProgram(countRecursion, "recursion"))->Arg(1000)->Arg(1000000);
+    lmbench::Register("macro/helpers/verified", program(helperCalls, true))->Arg(1000);
+    lmbench::Register("macro/helpers/optimized", program(helperCalls, true, true))->Arg(1000);
+    lmbench::Register("macro/dispatch/switch", program(dispatchDense, true))->Arg(1000);
+    lmbench::Register("macro/dispatch/sparse", program(dispatchSparse, true))->Arg(1000);
+    lmbench::Register("macro/dispatch/ifchain", program(dispatchIfChain, true))->Arg(1000);
+    lmbench::Register("macro/dispatch/aot", aotProgram(dispatchDense, "dispatch"))->Arg(1000);
+    lmbench::Register("macro/branches/ifrr", program(branchyIfrr, true))->Arg(1000);
+    lmbench::Register("macro/branches/fused", program(branchyFused, true))->Arg(1000);
+    lmbench::Register("macro/branches/optimized", program(branchyIfrr, true, true))->Arg(1000);
+    lmbench::Register("macro/cells/movm", program(cellsMovm, true))->Arg(1000);
+    lmbench::Register("macro/cells/indexed", program(cellsIndexed, true))->Arg(1000);
+    lmbench::Register("macro/cells/aot", aotProgram(cellsIndexed, "cells"))->Arg(1000);
+    lmbench::Register("macro/nbody/checked", program(nbody, false))->Arg(1000);
+    lmbench::Register("macro/nbody/verified", program(nbody, true))->Arg(1000);
+    lmbench::Register("macro/nbody/optimized", program(nbody, true, true))->Arg(1000);
+    lmbench::Register("macro/nbody/aot", aotProgram(nbody, "nbody"))->Arg(1000);
+    return true;
+}();
+
+// 逐段拼接构造长字符串
+void stringBuild(lmbench::State& state) {
+    const int64_t pieces = state.range(0);
+    LmString piece("lamina, ");
+    for ([[maybe_unused]] auto _ : state) {
+        auto* text = new LmString("");
+        for (int64_t i = 0; i < pieces; ++i) {
+            LmString* next = text->concat(&piece);
+            delete text;
+            text = next;
+        }
+        lmbench::DoNotOptimize(text);
+        delete text;
+    }
+    state.SetItemsProcessed(state.iterations() * pieces);
+}
+LM_BENCHMARK("macro/string_build", stringBuild)->Arg(256);
+
+} // namespace
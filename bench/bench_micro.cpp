@@ -0,0 +1,648 @@
+/******************************************************
+-     Date:  2026.10.20 09:30
+-     File:  bench_micro.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "benchmark.hpp"
+#include "programs.hpp"
+#include "../src/program_image.hpp"
+#include "../src/snapshot.hpp"
+#include "../src/vm/array_ops.hpp"
+#include "../src/vm/handler.hpp"
+#include "../src/vm/hash_map.hpp"
+#include "../src/vmcall/console_io.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <io.h>
+#define LMBENCH_ISATTY(fd) _isatty(fd)
+#else
+#include <unistd.h>
+#define LMBENCH_ISATTY(fd) isatty(fd)
+#endif
+
+using namespace benchprog;
+
+namespace {
+
+constexpr int64_t kBlockLen = 1000; // 每个程序重复的指令条数
+
+/**
+ * 单条指令重复 kBlockLen 次的分发开销
+ * @param op 被测指令
+ * @param verified 是否走校验后的无检查路径
+ */
+lmbench::Function dispatch(Instruction op, bool verified) {
+    return [op, verified](lmbench::State& state) {
+        BenchVM vm;
+        std::vector<Instruction> program(kBlockLen, op);
+        // 被测程序用到的函数与跳转块均为空
+        vm.newFunc({make(OpCode::RET)});
+        vm.newCall({});
+        vm.registers[1] = 7;
+        vm.registers[2] = 3;
+        if (verified) vm.verify(program);
+        for ([[maybe_unused]] auto _ : state) {
+            if (verified) vm.runVerified(program);
+            else vm.run(program);
+        }
+        lmbench::DoNotOptimize(vm.registers[1]);
+        state.SetItemsProcessed(state.iterations() * kBlockLen);
+    };
+}
+
+struct DispatchCase {
+    const char* name;
+    Instruction instr;
+};
+
+Instruction ifrr(Cmp cmp) {
+    return branch(1, 2, cmp, 0);
+}
+
+// r1 = 7, r2 = 3，所有被测指令都不会触发陷阱
+const DispatchCase kDispatchCases[] = {
+    {"MOVRI", make(OpCode::MOVRI, 1, 0, 7)},
+    {"MOVRR", make(OpCode::MOVRR, 1, 2)},
+    {"ADDR", make(OpCode::ADDR, 1, 2)},
+    {"ADDI", make(OpCode::ADDI, 1, 0, 1)},
+    {"SUBI", make(OpCode::SUBI, 1, 0, 1)},
+    {"MULI", make(OpCode::MULI, 1, 0, 3)},
+    {"SHLI", make(OpCode::SHLI, 1, 0, 1)},
+    {"DIVR", make(OpCode::DIVR, 1, 2)},
+    {"DIVI", make(OpCode::DIVI, 1, 0, 3)},
+    {"DIVIQ", make(OpCode::DIVIQ, 1, 0, 3)},
+    {"CALL", make(OpCode::CALL, 0, 0, 0)},
+    {"IFRR_taken", ifrr(GT)},
+    {"IFRR_not_taken", ifrr(LT)},
+};
+
+const bool kDispatchRegistered = [] {
+    for (const auto& c : kDispatchCases) {
+        lmbench::Register(std::string("dispatch/checked/") + c.name, dispatch(c.instr, false));
+        lmbench::Register(std::string("dispatch/verified/") + c.name, dispatch(c.instr, true));
+    }
+    return true;
+}();
+
+// 指令编码与解码
+void encodeDecode(lmbench::State& state) {
+    std::vector<Instruction> program;
+    for (const auto& c : kDispatchCases) program.push_back(c.instr);
+    size_t bytes = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        for (const auto& instr : program) {
+            std::vector<uint8_t> encoded = instr.encode();
+            Instruction decoded;
+            decoded.decode(encoded);
+            bytes += encoded.size();
+            lmbench::DoNotOptimize(decoded);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(program.size()));
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+LM_BENCHMARK("codec/encode_decode", encodeDecode);
+
+// 函数调用时的寄存器保存与恢复
+void localState(lmbench::State& state) {
+    alignas(32) int64_t registers[NUM_REGS]{};
+    LocalState local;
+    for ([[maybe_unused]] auto _ : state) {
+        local.saveAllRegisters(registers);
+        registers[1]++;
+        local.restoreAllRegisters(registers);
+        lmbench::DoNotOptimize(registers);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+LM_BENCHMARK("local_state/save_restore", localState);
+
+void taggedRoundTrip(lmbench::State& state) {
+    int64_t sum = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        for (int64_t i = 0; i < 1024; ++i) {
+            TaggedVal val = TaggedUtil::encode_Smi(i);
+            if (!TaggedUtil::is_HeapObject(val)) sum += TaggedUtil::decode_Smi(val);
+        }
+        lmbench::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * 1024);
+}
+LM_BENCHMARK("tagged/smi_round_trip", taggedRoundTrip);
+
+void arrayPush(lmbench::State& state) {
+    const int64_t count = state.range(0);
+    for ([[maybe_unused]] auto _ : state) {
+        auto* array = new LmArray();
+        for (int64_t i = 0; i < count; ++i) array->push(TaggedUtil::encode_Smi(i));
+        lmbench::DoNotOptimize(array);
+        delete array;
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+LM_BENCHMARK("models/array_push", arrayPush)->Arg(16)->Arg(1024);
+
+// 批量数组内核，每个用例分别测 AVX2 与标量路径（未编译 AVX2 时两者相同）
+struct ArrayKernelCase {
+    const char* name;
+    int64_t (*run)(std::vector<TaggedVal>& dst, const std::vector<TaggedVal>& src, bool simd); // 归约结果防止被优化掉
+};
+
+const ArrayKernelCase kArrayKernelCases[] = {
+    {"fill", [](std::vector<TaggedVal>& dst, const std::vector<TaggedVal>&, bool simd) -> int64_t {
+        ArrayOps::fill(dst.data(), dst.size(), 7, simd);
+        return 0;
+    }},
+    {"add_scalar", [](std::vector<TaggedVal>& dst, const std::vector<TaggedVal>&, bool simd) -> int64_t {
+        ArrayOps::arithScalar(ArrayOps::Arith::Add, dst.data(), dst.size(), 3, simd);
+        return 0;
+    }},
+    {"mul_array", [](std::vector<TaggedVal>& dst, const std::vector<TaggedVal>& src, bool simd) -> int64_t {
+        ArrayOps::arithArray(ArrayOps::Arith::Mul, dst.data(), src.data(), dst.size(), simd);
+        return 0;
+    }},
+    {"sum", [](std::vector<TaggedVal>& dst, const std::vector<TaggedVal>&, bool simd) -> int64_t {
+        return ArrayOps::reduce(ArrayOps::Reduce::Sum, dst.data(), dst.size(), simd);
+    }},
+    {"max", [](std::vector<TaggedVal>& dst, const std::vector<TaggedVal>&, bool simd) -> int64_t {
+        return ArrayOps::reduce(ArrayOps::Reduce::Max, dst.data(), dst.size(), simd);
+    }},
+    {"find_missing", [](std::vector<TaggedVal>& dst, const std::vector<TaggedVal>&, bool simd) -> int64_t {
+        return ArrayOps::find(dst.data(), dst.size(), -1, simd);
+    }},
+    {"compare_equal", [](std::vector<TaggedVal>& dst, const std::vector<TaggedVal>& src, bool simd) -> int64_t {
+        return ArrayOps::mismatch(dst.data(), dst.size(), src.data(), src.size(), simd);
+    }},
+};
+
+lmbench::Function arrayKernel(const ArrayKernelCase& c, bool simd) {
+    return [&c, simd](lmbench::State& state) {
+        const auto count = static_cast<size_t>(state.range(0));
+        std::vector<TaggedVal> dst(count), src(count);
+        for (size_t i = 0; i < count; ++i) dst[i] = src[i] = TaggedUtil::encode_Smi(static_cast<int64_t>(i % 1000));
+        int64_t result = 0;
+        for ([[maybe_unused]] auto _ : state) {
+            result += c.run(dst, src, simd);
+            lmbench::DoNotOptimize(result); // 同时阻止把只读的内核提到循环外
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(count * sizeof(TaggedVal)));
+    };
+}
+
+const bool kArrayKernelsRegistered = [] {
+    for (const auto& c : kArrayKernelCases) {
+        lmbench::Register(std::string("array/avx2/") + c.name, arrayKernel(c, true))->Range(1000, 10000000, 10);
+        lmbench::Register(std::string("array/scalar/") + c.name, arrayKernel(c, false))->Range(1000, 10000000, 10);
+    }
+    return true;
+}();
+
+// 经解释器执行的单条数组指令，r1、r2 为两个等长数组
+void arrayOpcode(lmbench::State& state, OpCode op) {
+    const int64_t count = state.range(0);
+    BenchVM vm;
+    for (uint8_t reg = 1; reg <= 2; ++reg) {
+        auto* arr = new LmArray();
+        arr->resize(static_cast<size_t>(count), TaggedUtil::encode_Smi(reg));
+        vm.registers[reg] = static_cast<int64_t>(vm.allocOnHeap(arr));
+    }
+    const std::vector<Instruction> program{make(op, 1, 2)};
+    vm.verify(program);
+    for ([[maybe_unused]] auto _ : state) vm.runVerified(program);
+    lmbench::DoNotOptimize(vm.registers[1]);
+    state.SetItemsProcessed(state.iterations() * count);
+}
+void arrayOpcodeAdd(lmbench::State& state) { arrayOpcode(state, OpCode::AADDA); }
+LM_BENCHMARK("array/opcode/AADDA", arrayOpcodeAdd)->Range(1000, 10000000, 10);
+
+void arrayOpcodeCopy(lmbench::State& state) { arrayOpcode(state, OpCode::ACOPY); }
+LM_BENCHMARK("array/opcode/ACOPY", arrayOpcodeCopy)->Range(1000, 10000000, 10);
+
+// 由 data 段中的 int64 数据新建数组：NEW 逐字节展开为 Smi，NEWT 整块复制为紧凑数组
+void typedMaterialize(lmbench::State& state, OpCode op) {
+    const auto count = static_cast<size_t>(state.range(0));
+    Instruction instr = make(op, 0, 0, op == OpCode::NEWT ? 2 : 0);
+    instr.data.resize(count * sizeof(int64_t));
+    for (size_t i = 0; i < instr.data.size(); ++i) instr.data[i] = static_cast<int8_t>(i);
+    const std::vector<Instruction> program{instr};
+    BenchVM vm;
+    vm.verify(program);
+    for ([[maybe_unused]] auto _ : state) {
+        vm.runVerified(program);
+        vm.freeOnHeap(static_cast<size_t>(vm.registers[1]));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(instr.data.size()));
+}
+void typedMaterializeNew(lmbench::State& state) { typedMaterialize(state, OpCode::NEW); }
+LM_BENCHMARK("array/typed/materialize_NEW", typedMaterializeNew)->Arg(1024)->Arg(1 << 16);
+
+void typedMaterializeNewt(lmbench::State& state) { typedMaterialize(state, OpCode::NEWT); }
+LM_BENCHMARK("array/typed/materialize_NEWT", typedMaterializeNewt)->Arg(1024)->Arg(1 << 16);
+
+// 同样的数据放在常量池中，LDC 只取堆地址，不分配也不复制
+void typedMaterializeLdc(lmbench::State& state) {
+    const auto count = static_cast<size_t>(state.range(0));
+    auto* arr = new LmTypedArray(HeapObjType::Int64Array, count);
+    for (size_t i = 0; i < arr->get_size(); ++i) arr->data()[i] = static_cast<uint8_t>(i);
+    auto pool = std::make_shared<ConstantPool>();
+    pool->add(arr);
+    BenchVM vm;
+    vm.setConstants(pool);
+    const std::vector<Instruction> program{make(OpCode::LDC, 1, 0, 0)};
+    vm.verify(program);
+    for ([[maybe_unused]] auto _ : state) vm.runVerified(program);
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(arr->get_size()));
+}
+LM_BENCHMARK("array/typed/materialize_LDC", typedMaterializeLdc)->Arg(1024)->Arg(1 << 16);
+
+// 哈希表：LmMap 与 std::unordered_map 在相同的整数键上对比，键打散后仍在 Smi 范围内
+constexpr int64_t kMapLookups = 1000; // 每轮查找次数
+
+int64_t mapKey(int64_t i) { return i * 0x9E3779B1LL; }
+
+struct LmMapTable {
+    LmMap map;
+    void put(int64_t key, int64_t value) { map.put(TaggedUtil::encode_Smi(key), value); }
+    int64_t get(int64_t key) const {
+        const int64_t* value = map.find(TaggedUtil::encode_Smi(key));
+        return value ? *value : -1;
+    }
+};
+
+struct StdTable {
+    std::unordered_map<int64_t, int64_t> map;
+    void put(int64_t key, int64_t value) { map[key] = value; }
+    int64_t get(int64_t key) const {
+        const auto it = map.find(key);
+        return it != map.end() ? it->second : -1;
+    }
+};
+
+template<typename Table>
+void mapInsert(lmbench::State& state) {
+    const int64_t count = state.range(0);
+    for ([[maybe_unused]] auto _ : state) {
+        auto table = std::make_unique<Table>();
+        for (int64_t i = 0; i < count; ++i) table->put(mapKey(i), i);
+        int64_t probe = table->get(mapKey(count / 2));
+        lmbench::DoNotOptimize(probe);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+// miss 为 true 时查找不存在的键；下标用 xorshift 打乱，大表的查找基本都是缓存未命中
+template<typename Table, bool kMiss>
+void mapLookup(lmbench::State& state) {
+    const int64_t count = state.range(0);
+    auto table = std::make_unique<Table>();
+    for (int64_t i = 0; i < count; ++i) table->put(mapKey(i), i);
+    uint64_t x = 88172645463325252ULL;
+    int64_t result = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        for (int64_t n = 0; n < kMapLookups; ++n) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            const auto i = static_cast<int64_t>(x % static_cast<uint64_t>(count));
+            result += table->get(mapKey(kMiss ? i + count : i));
+        }
+        lmbench::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations() * kMapLookups);
+}
+
+void mapInsertLm(lmbench::State& state) { mapInsert<LmMapTable>(state); }
+LM_BENCHMARK("map/lmmap/insert", mapInsertLm)->Arg(1000)->Arg(1000000)->Arg(10000000);
+void mapInsertStd(lmbench::State& state) { mapInsert<StdTable>(state); }
+LM_BENCHMARK("map/unordered_map/insert", mapInsertStd)->Arg(1000)->Arg(1000000)->Arg(10000000);
+
+void mapHitLm(lmbench::State& state) { mapLookup<LmMapTable, false>(state); }
+LM_BENCHMARK("map/lmmap/lookup_hit", mapHitLm)->Arg(1000)->Arg(1000000)->Arg(10000000);
+void mapHitStd(lmbench::State& state) { mapLookup<StdTable, false>(state); }
+LM_BENCHMARK("map/unordered_map/lookup_hit", mapHitStd)->Arg(1000)->Arg(1000000)->Arg(10000000);
+
+void mapMissLm(lmbench::State& state) { mapLookup<LmMapTable, true>(state); }
+LM_BENCHMARK("map/lmmap/lookup_miss", mapMissLm)->Arg(1000)->Arg(1000000)->Arg(10000000);
+void mapMissStd(lmbench::State& state) { mapLookup<StdTable, true>(state); }
+LM_BENCHMARK("map/unordered_map/lookup_miss", mapMissStd)->Arg(1000)->Arg(1000000)->Arg(10000000);
+
+// 字符串键：LmMap 复用 LmString 缓存的哈希，std::unordered_map<std::string> 每次查找都要重新哈希
+void mapStringLm(lmbench::State& state) {
+    const int64_t count = state.range(0);
+    std::vector<std::unique_ptr<LmString>> keys;
+    LmMap map;
+    for (int64_t i = 0; i < count; ++i) {
+        keys.push_back(std::make_unique<LmString>(("key/" + std::to_string(mapKey(i))).c_str()));
+        keys.back()->make_ref(); // 由 unique_ptr 释放，表中的引用不会减到 0
+        map.put(TaggedUtil::encode_HeapObject(keys.back().get()), i);
+    }
+    int64_t result = 0;
+    size_t at = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        for (int64_t n = 0; n < kMapLookups; ++n) {
+            at = (at + 7919) % keys.size();
+            result += *map.find(TaggedUtil::encode_HeapObject(keys[at].get()));
+        }
+        lmbench::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations() * kMapLookups);
+}
+LM_BENCHMARK("map/lmmap/lookup_string", mapStringLm)->Arg(1000)->Arg(1000000);
+
+void mapStringStd(lmbench::State& state) {
+    const int64_t count = state.range(0);
+    std::vector<std::string> keys;
+    std::unordered_map<std::string, int64_t> map;
+    for (int64_t i = 0; i < count; ++i) {
+        keys.push_back("key/" + std::to_string(mapKey(i)));
+        map[keys.back()] = i;
+    }
+    int64_t result = 0;
+    size_t at = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        for (int64_t n = 0; n < kMapLookups; ++n) {
+            at = (at + 7919) % keys.size();
+            result += map.find(keys[at])->second;
+        }
+        lmbench::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations() * kMapLookups);
+}
+LM_BENCHMARK("map/unordered_map/lookup_string", mapStringStd)->Arg(1000)->Arg(1000000);
+
+// GETFIELD 的内联缓存：每轮换一种 Shape 的记录，Shape 种数超过 FieldCache::WAYS 后缓存不断被替换
+void recordGetField(lmbench::State& state) {
+    const int64_t shapes = state.range(0);
+    BenchVM vm;
+    std::vector<int64_t> records;
+    for (int64_t s = 0; s < shapes; ++s) {
+        // 先放一个各不相同的字段，被读的字段 1 在每种 Shape 中偏移都是 1
+        const std::vector<Instruction> setup{make(OpCode::NEWR, 1, 0, 2), make(OpCode::MOVRI, 2, 0, s),
+                                             make(OpCode::SETFIELD, 2, 1, 100 + s), make(OpCode::SETFIELD, 2, 1, 1)};
+        vm.run(setup);
+        records.push_back(vm.registers[1]);
+    }
+    const std::vector<Instruction> program(kBlockLen, make(OpCode::GETFIELD, 2, 1, 1));
+    vm.verify(program);
+    size_t at = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        vm.registers[1] = records[at++ % records.size()];
+        vm.runVerified(program);
+    }
+    lmbench::DoNotOptimize(vm.registers[2]);
+    state.SetItemsProcessed(state.iterations() * kBlockLen);
+}
+LM_BENCHMARK("record/getfield", recordGetField)->Arg(1)->Arg(4)->Arg(16);
+
+// 直接调用与经函数对象的间接调用；CALLR 的参数为轮换的函数对象个数，超过 1 时调用点缓存每轮都不命中
+void callDirect(lmbench::State& state) {
+    BenchVM vm;
+    const auto func = static_cast<int64_t>(vm.newFunc({make(OpCode::ADDI, 0, 0, 1), make(OpCode::RET)}));
+    const std::vector<Instruction> program(kBlockLen, make(OpCode::CALL, 0, 0, func));
+    vm.verify(program);
+    for ([[maybe_unused]] auto _ : state) vm.runVerified(program);
+    lmbench::DoNotOptimize(vm.registers[0]);
+    state.SetItemsProcessed(state.iterations() * kBlockLen);
+}
+LM_BENCHMARK("call/CALL", callDirect);
+
+void callIndirect(lmbench::State& state) {
+    const int64_t targets = state.range(0);
+    BenchVM vm;
+    const auto func = static_cast<int64_t>(vm.newFunc({make(OpCode::ADDI, 0, 0, 1), make(OpCode::RET)}));
+    std::vector<int64_t> functions;
+    for (int64_t t = 0; t < targets; ++t) {
+        vm.run({make(OpCode::NEWF, 1, 0, func)});
+        functions.push_back(vm.registers[1]);
+    }
+    const std::vector<Instruction> program(kBlockLen, make(OpCode::CALLR, 0, 1, 0));
+    vm.verify(program);
+    size_t at = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        vm.registers[1] = functions[at++ % functions.size()];
+        vm.runVerified(program);
+    }
+    lmbench::DoNotOptimize(vm.registers[0]);
+    state.SetItemsProcessed(state.iterations() * kBlockLen);
+}
+LM_BENCHMARK("call/CALLR", callIndirect)->Arg(1)->Arg(2);
+
+void stringConcat(lmbench::State& state) {
+    const std::string text(static_cast<size_t>(state.range(0)), 'x');
+    LmString left(text.c_str());
+    LmString right(text.c_str());
+    for ([[maybe_unused]] auto _ : state) {
+        LmString* joined = left.concat(&right);
+        lmbench::DoNotOptimize(joined);
+        delete joined;
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * 2);
+}
+LM_BENCHMARK("models/string_concat", stringConcat)->Arg(16)->Arg(4096);
+
+/**
+ * 生成临时文件，退出时删除
+ */
+class TempFile {
+public:
+    explicit TempFile(size_t size) {
+        path_ = (std::filesystem::temp_directory_path() / "lmvm_bench_read.bin").string();
+        std::ofstream out(path_, std::ios::binary);
+        std::vector<char> block(1 << 16, 'a');
+        for (size_t written = 0; written < size; written += block.size()) {
+            out.write(block.data(), static_cast<std::streamsize>(block.size()));
+        }
+    }
+    ~TempFile() {
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+    }
+    [[nodiscard]] const std::string& path() const { return path_; }
+private:
+    std::string path_;
+};
+
+constexpr size_t kFileSize = 16 << 20;
+
+// 同步顺序读取整个文件，参数为每次读取的块大小
+void fileReadSync(lmbench::State& state) {
+    static TempFile file(kFileSize);
+    const auto chunk = static_cast<size_t>(state.range(0));
+    std::vector<uint8_t> buffer(chunk);
+    FileTable table;
+    int64_t total = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        const int64_t fd = table.open(file.path().c_str(), FileTable::MODE_READ);
+        if (fd < 0) {
+            state.SkipWithError("cannot open temp file");
+            return;
+        }
+        int64_t n;
+        while ((n = table.read(fd, buffer.data(), chunk)) > 0) total += n;
+        table.close(fd);
+    }
+    state.SetBytesProcessed(total);
+}
+LM_BENCHMARK("io/file_read_sync", fileReadSync)->Arg(4096)->Arg(1 << 20);
+
+// 异步读取，同时保持 4 个请求在途
+void fileReadAsync(lmbench::State& state) {
+    static TempFile file(kFileSize);
+    const auto chunk = static_cast<size_t>(state.range(0));
+    constexpr size_t kInFlight = 4;
+    std::vector<LmBuffer*> buffers;
+    for (size_t i = 0; i < kInFlight; ++i) buffers.push_back(new LmBuffer(chunk));
+    FileTable table;
+    int64_t total = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        const int64_t fd = table.open(file.path().c_str(), FileTable::MODE_READ);
+        if (fd < 0) {
+            state.SkipWithError("cannot open temp file");
+            break;
+        }
+        for (size_t offset = 0; offset < kFileSize; offset += chunk * kInFlight) {
+            int64_t requests[kInFlight];
+            for (size_t i = 0; i < kInFlight; ++i) {
+                requests[i] = table.submitRead(fd, buffers[i], chunk, static_cast<int64_t>(offset + i * chunk));
+            }
+            for (int64_t request : requests) {
+                const int64_t n = table.await(request);
+                if (n > 0) total += n;
+            }
+        }
+        table.close(fd);
+    }
+    for (LmBuffer* buffer : buffers) buffer->del_ref();
+    state.SetBytesProcessed(total);
+}
+LM_BENCHMARK("io/file_read_async", fileReadAsync)->Arg(1 << 16)->Arg(1 << 20);
+
+// 启动开销用的 fib 程序
+ProgramImage::Program startupProgram() {
+    BenchVM scratch;
+    ProgramImage::Program program;
+    program.entry = fib(scratch, 20);
+    program.functions.push_back({
+        make(OpCode::MOVRR, 0, 2),
+        make(OpCode::MOVRI, 3, 0, 2),
+        branch(2, 3, GE, 0),
+        make(OpCode::RET),
+    });
+    program.blocks.push_back({
+        make(OpCode::SUBI, 2, 0, 1),
+        make(OpCode::CALL, 0, 0, 0),
+        make(OpCode::MOVRR, 4, 0),
+        make(OpCode::SUBI, 2, 0, 1),
+        make(OpCode::CALL, 0, 0, 0),
+        make(OpCode::ADDR, 0, 4),
+    });
+    return program;
+}
+
+// 启动开销：读取镜像、解码、装载、校验，参数为 1 时代码段压缩
+void startupLoadImage(lmbench::State& state) {
+    const std::string path = (std::filesystem::temp_directory_path() / "lmvm_bench_startup.lmc").string();
+    ProgramImage::write(path, startupProgram(), state.range(0) != 0);
+    for ([[maybe_unused]] auto _ : state) {
+        RegisterVM vm;
+        ProgramImage::Program program = ProgramImage::load(path);
+        ProgramImage::install(program, vm);
+        vm.verify(program.entry);
+        lmbench::DoNotOptimize(vm.registers[0]);
+    }
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+LM_BENCHMARK("startup/load_image", startupLoadImage)->Arg(0)->Arg(1);
+
+// 启动开销：200 个函数中只调用 1 个，参数为 1 时按需加载函数
+void startupLazyImage(lmbench::State& state) {
+    const std::string path = (std::filesystem::temp_directory_path() / "lmvm_bench_lazy.lmc").string();
+    {
+        ProgramImage::Program program;
+        program.entry = {make(OpCode::MOVRI, 2, 0, 1), make(OpCode::CALL, 0, 0, 0)};
+        for (int f = 0; f < 200; ++f) {
+            std::vector<Instruction> body(500, make(OpCode::ADDI, 0, 0, f));
+            body.push_back(make(OpCode::RET));
+            program.functions.push_back(std::move(body));
+        }
+        ProgramImage::write(path, program);
+    }
+    const bool lazy = state.range(0) != 0;
+    for ([[maybe_unused]] auto _ : state) {
+        RegisterVM vm;
+        std::vector<Instruction> entry;
+        if (lazy) {
+            entry = ProgramImage::installLazy(path, vm);
+        } else {
+            ProgramImage::Program program = ProgramImage::load(path);
+            ProgramImage::install(program, vm);
+            entry = std::move(program.entry);
+        }
+        vm.verify(entry);
+        vm.runVerified(entry);
+        lmbench::DoNotOptimize(vm.registers[0]);
+    }
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+LM_BENCHMARK("startup/lazy_functions", startupLazyImage)->Arg(0)->Arg(1);
+
+// 启动开销：映射快照并恢复已校验的状态
+void startupRestoreSnapshot(lmbench::State& state) {
+    const std::string path = (std::filesystem::temp_directory_path() / "lmvm_bench_startup.lmss").string();
+    {
+        RegisterVM vm;
+        Handler::vmCallTable(vm);
+        ProgramImage::Program program = startupProgram();
+        ProgramImage::install(program, vm);
+        vm.verify(program.entry);
+        Snapshot::save(path, vm, program.entry, false);
+    }
+    for ([[maybe_unused]] auto _ : state) {
+        RegisterVM vm;
+        Handler::vmCallTable(vm);
+        std::vector<Instruction> entry;
+        FileLoader::MappedFile file(path);
+        Snapshot::restore(file, vm, entry);
+        lmbench::DoNotOptimize(vm.registers[0]);
+    }
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+LM_BENCHMARK("startup/restore_snapshot", startupRestoreSnapshot);
+
+// 标准输入只能读一遍，需要重定向输入：lmvm_bench --benchmark_filter=io/stdin < file
+void stdinLines(lmbench::State& state) {
+    if (LMBENCH_ISATTY(0)) {
+        state.SkipWithError("stdin is a terminal, redirect a file to measure");
+        return;
+    }
+    std::vector<uint8_t> buffer(1 << 20);
+    int64_t total = 0;
+    size_t lines = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        size_t n;
+        size_t chunk_lines = 0;
+        while ((n = StdinStream::instance().readLines(buffer.data(), buffer.size(), chunk_lines)) > 0) {
+            total += static_cast<int64_t>(n);
+            lines += chunk_lines;
+        }
+    }
+    if (total == 0) {
+        state.SkipWithError("stdin is empty");
+        return;
+    }
+    state.SetBytesProcessed(total);
+    state.SetItemsProcessed(static_cast<int64_t>(lines));
+}
+LM_BENCHMARK("io/stdin_read_lines", stdinLines)->Iterations(1);
+
+} // namespace
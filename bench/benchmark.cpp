@@ -0,0 +1,235 @@
+/******************************************************
+-     Date:  2026.10.20 09:30
+-     File:  benchmark.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "benchmark.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <thread>
+
+namespace lmbench {
+
+namespace {
+    double realNow() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    double cpuNow() {
+        return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+    }
+
+    std::vector<std::unique_ptr<Benchmark>>& registry() {
+        static std::vector<std::unique_ptr<Benchmark>> benchmarks;
+        return benchmarks;
+    }
+
+    struct Result {
+        std::string name;
+        int64_t iterations = 0;
+        double real_ns = 0; // 每轮耗时
+        double cpu_ns = 0;
+        double items_per_second = 0;
+        double bytes_per_second = 0;
+        std::string label;
+        std::string error;
+    };
+
+    std::string jsonEscape(const std::string& s) {
+        std::string out;
+        for (char c : s) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    void printConsole(std::ostream& out, const Result& r) {
+        out << std::left << std::setw(44) << r.name << std::right;
+        if (!r.error.empty()) {
+            out << " ERROR: " << r.error << "\n";
+            return;
+        }
+        out << std::setw(14) << std::fixed << std::setprecision(1) << r.real_ns << " ns"
+            << std::setw(14) << r.cpu_ns << " ns" << std::setw(12) << r.iterations;
+        if (r.bytes_per_second > 0) out << "  " << std::setprecision(1) << r.bytes_per_second / 1e6 << " MB/s";
+        if (r.items_per_second > 0) out << "  " << std::setprecision(2) << r.items_per_second / 1e6 << "M items/s";
+        if (!r.label.empty()) out << "  " << r.label;
+        out << "\n";
+    }
+
+    void printJson(std::ostream& out, const std::vector<Result>& results, const char* executable) {
+        std::time_t now = std::time(nullptr);
+        char date[64];
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+        out << "{\n  \"context\": {\n"
+            << "    \"date\": \"" << date << "\",\n"
+            << "    \"executable\": \"" << jsonEscape(executable) << "\",\n"
+            << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+            << "    \"library_build_type\": \"release\"\n"
+#else
+            << "    \"library_build_type\": \"debug\"\n"
+#endif
+            << "  },\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            out << (i ? ",\n" : "\n") << "    {\n"
+                << "      \"name\": \"" << jsonEscape(r.name) << "\",\n"
+                << "      \"run_name\": \"" << jsonEscape(r.name) << "\",\n"
+                << "      \"run_type\": \"iteration\",\n";
+            if (!r.error.empty()) {
+                out << "      \"error_occurred\": true,\n"
+                    << "      \"error_message\": \"" << jsonEscape(r.error) << "\"\n    }";
+                continue;
+            }
+            out << "      \"iterations\": " << r.iterations << ",\n"
+                << std::setprecision(6) << std::fixed
+                << "      \"real_time\": " << r.real_ns << ",\n"
+                << "      \"cpu_time\": " << r.cpu_ns << ",\n"
+                << "      \"time_unit\": \"ns\"";
+            if (r.bytes_per_second > 0) out << ",\n      \"bytes_per_second\": " << r.bytes_per_second;
+            if (r.items_per_second > 0) out << ",\n      \"items_per_second\": " << r.items_per_second;
+            if (!r.label.empty()) out << ",\n      \"label\": \"" << jsonEscape(r.label) << "\"";
+            out << "\n    }";
+        }
+        out << "\n  ]\n}\n";
+    }
+}
+
+void State::start() {
+    real_elapsed_ = 0;
+    cpu_elapsed_ = 0;
+    ResumeTiming();
+}
+
+bool State::finish() {
+    PauseTiming();
+    return false;
+}
+
+void State::PauseTiming() {
+    if (!running_) return;
+    real_elapsed_ += realNow() - real_start_;
+    cpu_elapsed_ += cpuNow() - cpu_start_;
+    running_ = false;
+}
+
+void State::ResumeTiming() {
+    if (running_) return;
+    real_start_ = realNow();
+    cpu_start_ = cpuNow();
+    running_ = true;
+}
+
+Benchmark* Register(const std::string& name, Function fn) {
+    auto bench = std::make_unique<Benchmark>();
+    bench->name = name;
+    bench->fn = std::move(fn);
+    registry().push_back(std::move(bench));
+    return registry().back().get();
+}
+
+struct Runner {
+    static Result runOne(const Benchmark& bench, const std::vector<int64_t>& args, double min_time) {
+        Result result;
+        result.name = bench.name;
+        for (int64_t arg : args) result.name += "/" + std::to_string(arg);
+
+        int64_t iterations = bench.fixed_iterations > 0 ? bench.fixed_iterations : 1;
+        while (true) {
+            State state(iterations, args);
+            bench.fn(state);
+            if (!state.error_.empty()) {
+                result.error = state.error_;
+                return result;
+            }
+            const bool done = bench.fixed_iterations > 0 || state.real_elapsed_ >= min_time
+                              || iterations >= 1000000000;
+            if (done) {
+                result.iterations = iterations;
+                result.real_ns = state.real_elapsed_ * 1e9 / static_cast<double>(iterations);
+                result.cpu_ns = state.cpu_elapsed_ * 1e9 / static_cast<double>(iterations);
+                if (state.real_elapsed_ > 0) {
+                    result.items_per_second = static_cast<double>(state.items_) / state.real_elapsed_;
+                    result.bytes_per_second = static_cast<double>(state.bytes_) / state.real_elapsed_;
+                }
+                result.label = state.label_;
+                return result;
+            }
+            // 按上一轮耗时估算达到最短时间所需的轮数
+            double scale = state.real_elapsed_ > 0 ? min_time * 1.4 / state.real_elapsed_ : 10.0;
+            scale = std::clamp(scale, 2.0, 10.0);
+            iterations = static_cast<int64_t>(static_cast<double>(iterations) * scale);
+        }
+    }
+};
+
+int RunAll(int argc, char* argv[]) {
+    std::string filter = ".*";
+    std::string format = "console";
+    std::string out_path;
+    double min_time = 0.5;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&](const std::string& key) -> const char* {
+            return arg.rfind(key, 0) == 0 ? arg.c_str() + key.size() : nullptr;
+        };
+        if (const char* v = value("--benchmark_filter=")) filter = v;
+        else if (const char* v = value("--benchmark_format=")) format = v;
+        else if (const char* v = value("--benchmark_out=")) out_path = v;
+        else if (const char* v = value("--benchmark_min_time=")) min_time = std::atof(v);
+        else if (arg == "--benchmark_list_tests") format = "list";
+        else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--benchmark_filter=<regex>] [--benchmark_format=console|json]"
+                         " [--benchmark_out=<file>] [--benchmark_min_time=<seconds>] [--benchmark_list_tests]\n";
+            return 1;
+        }
+    }
+
+    const std::regex pattern(filter);
+    std::vector<Result> results;
+    for (const auto& bench : registry()) {
+        std::vector<std::vector<int64_t>> arg_sets = bench->args;
+        if (arg_sets.empty()) arg_sets.emplace_back();
+        for (const auto& args : arg_sets) {
+            std::string name = bench->name;
+            for (int64_t arg : args) name += "/" + std::to_string(arg);
+            if (!std::regex_search(name, pattern)) continue;
+            if (format == "list") {
+                std::cout << name << "\n";
+                continue;
+            }
+            Result result = Runner::runOne(*bench, args, min_time);
+            if (format == "console") printConsole(std::cout, result);
+            results.push_back(std::move(result));
+        }
+    }
+
+    if (format == "json") printJson(std::cout, results, argv[0]);
+    if (!out_path.empty()) {
+        std::ofstream out(out_path);
+        if (!out) {
+            std::cerr << "failed to open " << out_path << "\n";
+            return 1;
+        }
+        printJson(out, results, argv[0]);
+    }
+    return 0;
+}
+
+} // namespace lmbench
+
+int main(int argc, char* argv[]) {
+    return lmbench::RunAll(argc, argv);
+}
@@ -0,0 +1,140 @@
+/******************************************************
+-     Date:  2026.10.20 09:30
+-     File:  benchmark.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * 仿 Google Benchmark 接口的基准测试框架，不依赖第三方库
+ * 输出格式与 --benchmark_format=json 兼容，便于沿用已有的回归比对脚本
+ */
+namespace lmbench {
+
+class State {
+public:
+    State(int64_t max_iterations, std::vector<int64_t> args)
+        : max_iterations_(max_iterations), args_(std::move(args)) {}
+
+    // 支持 for (auto _ : state) 写法
+    struct Iterator {
+        State* state;
+        int64_t remaining;
+        bool operator!=(const Iterator&) const { return remaining > 0 || state->finish(); }
+        void operator++() { --remaining; }
+        int operator*() const { return 0; }
+    };
+    Iterator begin() { start(); return {this, max_iterations_}; }
+    Iterator end() { return {this, 0}; }
+
+    /**
+     * 获取第 i 个参数
+     * @param i
+     * @return int64_t
+     */
+    [[nodiscard]] int64_t range(size_t i = 0) const { return i < args_.size() ? args_[i] : 0; }
+
+    [[nodiscard]] int64_t iterations() const { return max_iterations_; }
+
+    void SetItemsProcessed(int64_t items) { items_ = items; }
+    void SetBytesProcessed(int64_t bytes) { bytes_ = bytes; }
+    void SetLabel(const std::string& label) { label_ = label; }
+    void SkipWithError(const std::string& error) { error_ = error; }
+
+    /**
+     * 暂停计时（用于每轮的准备工作）
+     * @return void
+     */
+    void PauseTiming();
+    void ResumeTiming();
+
+private:
+    friend struct Runner;
+
+    int64_t max_iterations_;
+    std::vector<int64_t> args_;
+    int64_t items_ = 0;
+    int64_t bytes_ = 0;
+    std::string label_;
+    std::string error_;
+
+    double real_elapsed_ = 0; // 秒
+    double cpu_elapsed_ = 0;  // 秒
+    double real_start_ = 0;
+    double cpu_start_ = 0;
+    bool running_ = false;
+
+    void start();
+    bool finish();
+};
+
+using Function = std::function<void(State&)>;
+
+// 注册项，支持 ->Arg(n)->Args({a, b})->Iterations(n) 链式调用
+struct Benchmark {
+    std::string name;
+    Function fn;
+    std::vector<std::vector<int64_t>> args;
+    int64_t fixed_iterations = 0;
+
+    Benchmark* Arg(int64_t arg) {
+        args.push_back({arg});
+        return this;
+    }
+    Benchmark* Args(std::vector<int64_t> arg_set) {
+        args.push_back(std::move(arg_set));
+        return this;
+    }
+    Benchmark* Range(int64_t lo, int64_t hi, int64_t mult = 8) {
+        for (int64_t v = lo; v < hi; v *= mult) args.push_back({v});
+        args.push_back({hi});
+        return this;
+    }
+    Benchmark* Iterations(int64_t n) {
+        fixed_iterations = n;
+        return this;
+    }
+};
+
+/**
+ * 注册基准测试
+ * @param name
+ * @param fn
+ * @return Benchmark*
+ */
+Benchmark* Register(const std::string& name, Function fn);
+
+/**
+ * 运行所有匹配的基准测试
+ * 支持 --benchmark_filter= --benchmark_format=console|json --benchmark_out= --benchmark_min_time=
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int RunAll(int argc, char* argv[]);
+
+/**
+ * 阻止编译器优化掉结果
+ */
+template<typename T>
+inline void DoNotOptimize(T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : "+m"(value) : : "memory");
+#else
+    static volatile T* sink;
+    sink = &value;
+#endif
+}
+
+} // namespace lmbench
+
+#define LMBENCH_CONCAT_(a, b) a##b
+#define LMBENCH_CONCAT(a, b) LMBENCH_CONCAT_(a, b)
+#define LM_BENCHMARK(name, fn) \
+    static ::lmbench::Benchmark* LMBENCH_CONCAT(lmbench_reg_, __LINE__) = ::lmbench::Register(name, fn)
@@ -0,0 +1,377 @@
+/******************************************************
+-     Date:  2026.10.20 09:30
+-     File:  programs.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include "../src/vm/vm.hpp"
+#include "../src/vm/switch_table.hpp"
+#include <vector>
+
+/**
+ * 基准测试共用的字节码程序
+ */
+namespace benchprog {
+
+using Instruction = OpCodeImpl::Instruction;
+using OpCode = OpCodeImpl::OpCode;
+
+/**
+ * 允许回填函数体的虚拟机，用于构造自递归的函数与跳转块
+ */
+class BenchVM : public RegisterVM {
+public:
+    void setFunc(size_t index, std::vector<Instruction> program) { FuncLists[index] = std::move(program); }
+    void setCall(size_t index, std::vector<Instruction> program) { CallLists[index] = std::move(program); }
+};
+
+// IFRR 比较码
+enum Cmp : int8_t { EQ = 0, NE = 1, GT = 2, LT = 3, GE = 4, LE = 5 };
+
+inline Instruction make(OpCode op, uint8_t rd = 0, uint8_t rs = 0, int64_t imm = 0, int64_t mem = 0) {
+    Instruction instr;
+    instr.op = op;
+    instr.rd = rd;
+    instr.rs = rs;
+    instr.imm = imm;
+    instr.mem = mem;
+    return instr;
+}
+
+inline Instruction branch(uint8_t rd, uint8_t rs, Cmp cmp, int64_t target) {
+    Instruction instr = make(OpCode::IFRR, rd, rs, target);
+    instr.data = {cmp};
+    return instr;
+}
+
+/**
+ * 递归斐波那契，r2 为参数，结果在 r0
+ * @param vm
+ * @param n
+ * @return std::vector<Instruction>
+ */
+inline std::vector<Instruction> fib(BenchVM& vm, int64_t n) {
+    const auto func = static_cast<int64_t>(vm.newFunc({}));
+    // n >= 2 时进入：r0 = fib(n-1) + fib(n-2)
+    const auto recurse = static_cast<int64_t>(vm.newCall({
+        make(OpCode::SUBI, 2, 0, 1),
+        make(OpCode::CALL, 0, 0, func),
+        make(OpCode::MOVRR, 4, 0),
+        make(OpCode::SUBI, 2, 0, 1),
+        make(OpCode::CALL, 0, 0, func),
+        make(OpCode::ADDR, 0, 4),
+    }));
+    vm.setFunc(static_cast<size_t>(func), {
+        make(OpCode::MOVRR, 0, 2),
+        make(OpCode::MOVRI, 3, 0, 2),
+        branch(2, 3, GE, recurse),
+        make(OpCode::RET),
+    });
+    return {make(OpCode::MOVRI, 2, 0, n), make(OpCode::CALL, 0, 0, func)};
+}
+
+/**
+ * 计数循环（跳转块自递归），r3 = 1 + 2 + ... + n
+ * @param vm
+ * @param n
+ * @return std::vector<Instruction>
+ */
+inline std::vector<Instruction> countLoop(BenchVM& vm, int64_t n) {
+    const auto body = static_cast<int64_t>(vm.newCall({}));
+    vm.setCall(static_cast<size_t>(body), {
+        make(OpCode::ADDR, 3, 2),
+        make(OpCode::SUBI, 2, 0, 1),
+        branch(2, 4, GT, body),
+    });
+    return {
+        make(OpCode::MOVRI, 2, 0, n),
+        make(OpCode::MOVRI, 3, 0, 0),
+        make(OpCode::MOVRI, 4, 0, 0),
+        branch(2, 4, GT, body),
+    };
+}
+
+/**
+ * 计数递归（函数在末尾调用自身），r0 = 1 + 2 + ... + n；优化器把末尾的 CALL + RET 改写为 TAILCALL
+ * @param vm
+ * @param n
+ * @return std::vector<Instruction>
+ */
+inline std::vector<Instruction> countRecursion(BenchVM& vm, int64_t n) {
+    const auto func = static_cast<int64_t>(vm.newFunc({}));
+    const auto done = static_cast<int64_t>(vm.newCall({make(OpCode::RET)}));
+    Instruction leave = branch(2, 4, LE, done);
+    leave.size = 19000; // 跳转块返回后函数也返回
+    vm.setFunc(static_cast<size_t>(func), {
+        make(OpCode::ADDR, 0, 2),
+        make(OpCode::SUBI, 2, 0, 1),
+        leave,
+        make(OpCode::CALL, 0, 0, func),
+        make(OpCode::RET),
+    });
+    return {
+        make(OpCode::MOVRI, 0, 0, 0),
+        make(OpCode::MOVRI, 2, 0, n),
+        make(OpCode::MOVRI, 4, 0, 0),
+        make(OpCode::CALL, 0, 0, func),
+    };
+}
+
+/**
+ * 循环中调用小函数，r0 = 1^2 + 2^2 + ... + n^2；循环在函数内，优化器可以把 square 内联进循环体
+ * @param vm
+ * @param n
+ * @return std::vector<Instruction>
+ */
+inline std::vector<Instruction> helperCalls(BenchVM& vm, int64_t n) {
+    const auto square = static_cast<int64_t>(vm.newFunc({
+        make(OpCode::MOVRR, 5, 2),
+        make(OpCode::MULR, 5, 5),
+        make(OpCode::MOVRR, 0, 5),
+        make(OpCode::RET),
+    }));
+    const auto body = static_cast<int64_t>(vm.newCall({}));
+    vm.setCall(static_cast<size_t>(body), {
+        make(OpCode::CALL, 0, 0, square),
+        make(OpCode::ADDR, 3, 0),
+        make(OpCode::SUBI, 2, 0, 1),
+        branch(2, 4, GT, body),
+    });
+    const auto sum = static_cast<int64_t>(vm.newFunc({
+        make(OpCode::MOVRI, 3, 0, 0),
+        make(OpCode::MOVRI, 4, 0, 0),
+        branch(2, 4, GT, body),
+        make(OpCode::MOVRR, 0, 3),
+        make(OpCode::RET),
+    }));
+    return {make(OpCode::MOVRI, 2, 0, n), make(OpCode::CALL, 0, 0, sum)};
+}
+
+// 256 路分派的方式
+enum class Dispatch { Dense, Sparse, IfChain };
+
+/**
+ * 虚拟机里的小解释器：每步取一条“客户指令” op = r2 * 37 % 256，分派到 256 个处理块之一，r3 累加处理结果
+ * Dense 用分支值 0~255 的 SWITCH（平铺跳转表），Sparse 用分支值 op * 7 的 SWITCH（二分查找），
+ * IfChain 用 256 条 IFRR 依次比较
+ * @param vm
+ * @param n
+ * @param kind
+ * @return std::vector<Instruction>
+ */
+inline std::vector<Instruction> dispatchLoop(BenchVM& vm, int64_t n, Dispatch kind) {
+    constexpr int32_t OPS = 256;
+    const int32_t stride = kind == Dispatch::Sparse ? 7 : 1;
+    std::vector<SwitchTable::Case> cases;
+    std::vector<Instruction> chain;
+    for (int32_t op = 0; op < OPS; ++op) {
+        const auto handler = static_cast<int32_t>(vm.newCall({make(OpCode::ADDI, 3, 0, op * 3 + 1)}));
+        cases.emplace_back(op * stride, handler);
+        chain.push_back(make(OpCode::MOVRI, 6, 0, op));
+        chain.push_back(branch(5, 6, EQ, handler));
+        chain.back().size = 19000; // 命中后跳出比较链
+    }
+    const auto body = static_cast<int64_t>(vm.newCall({}));
+    std::vector<Instruction> step = {
+        make(OpCode::MOVRR, 5, 2),
+        make(OpCode::MULI, 5, 0, 37),
+        make(OpCode::MOVRR, 6, 5),
+        make(OpCode::DIVI, 6, 0, OPS),
+        make(OpCode::MULI, 6, 0, OPS),
+        make(OpCode::SUBR, 5, 6),
+    };
+    if (kind == Dispatch::IfChain) {
+        const auto dispatch = static_cast<int64_t>(vm.newCall(chain));
+        step.push_back(branch(5, 5, EQ, dispatch));
+    } else {
+        if (stride != 1) step.push_back(make(OpCode::MULI, 5, 0, stride));
+        Instruction sw = make(OpCode::SWITCH, 5, 0, -1);
+        sw.data = SwitchTable::encode(cases);
+        step.push_back(sw);
+    }
+    step.push_back(make(OpCode::SUBI, 2, 0, 1));
+    step.push_back(branch(2, 4, GT, body));
+    vm.setCall(static_cast<size_t>(body), step);
+    return {
+        make(OpCode::MOVRI, 2, 0, n),
+        make(OpCode::MOVRI, 3, 0, 0),
+        make(OpCode::MOVRI, 4, 0, 0),
+        branch(2, 4, GT, body),
+        make(OpCode::MOVRR, 0, 3),
+    };
+}
+
+inline std::vector<Instruction> dispatchDense(BenchVM& vm, int64_t n) { return dispatchLoop(vm, n, Dispatch::Dense); }
+inline std::vector<Instruction> dispatchSparse(BenchVM& vm, int64_t n) { return dispatchLoop(vm, n, Dispatch::Sparse); }
+inline std::vector<Instruction> dispatchIfChain(BenchVM& vm, int64_t n) { return dispatchLoop(vm, n, Dispatch::IfChain); }
+
+/**
+ * 分支密集的循环：每步把 op = r2 * 37 % 256 按 32 为一档分到 8 个桶之一，r3 累加桶号
+ * fused 为 false 时每档先把边界放进 r6 再用 IFRR 比较，为 true 时直接用 JLTI 与立即数比较，
+ * 循环本身的 IFRR 也换成 JGT
+ * @param vm
+ * @param n
+ * @param fused
+ * @return std::vector<Instruction>
+ */
+inline std::vector<Instruction> branchyLoop(BenchVM& vm, int64_t n, bool fused) {
+    constexpr int64_t BUCKETS = 8;
+    constexpr int64_t WIDTH = 32;
+    std::vector<Instruction> classify;
+    for (int64_t k = 1; k <= BUCKETS; ++k) {
+        if (k == BUCKETS) {
+            classify.push_back(make(OpCode::ADDI, 3, 0, k));
+            break;
+        }
+        const auto bucket = static_cast<int64_t>(vm.newCall({make(OpCode::ADDI, 3, 0, k)}));
+        Instruction test;
+        if (fused) {
+            test = make(OpCode::JLTI, 5, 0, bucket);
+            test.srcOffset = static_cast<int32_t>(k * WIDTH);
+        } else {
+            classify.push_back(make(OpCode::MOVRI, 6, 0, k * WIDTH));
+            test = branch(5, 6, LT, bucket);
+        }
+        test.size = 19000; // 落入本档后跳出
+        classify.push_back(test);
+    }
+    const auto dispatch = static_cast<int64_t>(vm.newCall(classify));
+    const auto body = static_cast<int64_t>(vm.newCall({}));
+    auto loop = [&](int64_t target) {
+        if (!fused) return branch(2, 4, GT, target);
+        return make(OpCode::JGT, 2, 4, target);
+    };
+    Instruction enter = fused ? make(OpCode::JEQ, 5, 5, dispatch) : branch(5, 5, EQ, dispatch);
+    vm.setCall(static_cast<size_t>(body), {
+        make(OpCode::MOVRR, 5, 2),
+        make(OpCode::MULI, 5, 0, 37),
+        make(OpCode::MOVRR, 6, 5),
+        make(OpCode::DIVI, 6, 0, 256),
+        make(OpCode::MULI, 6, 0, 256),
+        make(OpCode::SUBR, 5, 6),
+        enter,
+        make(OpCode::SUBI, 2, 0, 1),
+        loop(body),
+    });
+    return {
+        make(OpCode::MOVRI, 2, 0, n),
+        make(OpCode::MOVRI, 3, 0, 0),
+        make(OpCode::MOVRI, 4, 0, 0),
+        loop(body),
+        make(OpCode::MOVRR, 0, 3),
+    };
+}
+
+inline std::vector<Instruction> branchyIfrr(BenchVM& vm, int64_t n) { return branchyLoop(vm, n, false); }
+inline std::vector<Instruction> branchyFused(BenchVM& vm, int64_t n) { return branchyLoop(vm, n, true); }
+
+/**
+ * 四个堆上计数单元的累加循环，每步 cell[i] += r2
+ * indexed 为 false 时每个单元是一个单元素数组，用 ADDM 读取、MOVMR 写回（每次写回都新建数组）；
+ * 为 true 时四个单元放在同一个数组里，地址在 r7，用 LDX/STX 按偏移读写
+ * @param vm
+ * @param n
+ * @param indexed
+ * @return std::vector<Instruction>
+ */
+inline std::vector<Instruction> cellsLoop(BenchVM& vm, int64_t n, bool indexed) {
+    constexpr int32_t CELLS = 4;
+    auto* shared = new LmArray(CELLS);
+    std::vector<int64_t> cells;
+    for (int32_t i = 0; i < CELLS; ++i) {
+        shared->push(TaggedUtil::encode_Smi(0));
+        cells.push_back(static_cast<int64_t>(vm.allocOnHeap(new LmArray(1))));
+    }
+    const auto base = static_cast<int64_t>(vm.allocOnHeap(shared));
+    auto load = [](uint8_t rd, int32_t cell) {
+        Instruction instr = make(OpCode::LDX, rd, 7);
+        instr.srcOffset = cell;
+        return instr;
+    };
+    auto store = [](int32_t cell, uint8_t rs) {
+        Instruction instr = make(OpCode::STX, 7, rs);
+        instr.dstOffset = cell;
+        return instr;
+    };
+
+    const auto body = static_cast<int64_t>(vm.newCall({}));
+    std::vector<Instruction> step;
+    std::vector<Instruction> entry = {
+        make(OpCode::MOVRI, 2, 0, n),
+        make(OpCode::MOVRI, 4, 0, 0),
+        make(OpCode::MOVRI, 5, 0, 0),
+        make(OpCode::MOVRI, 7, 0, base),
+    };
+    for (int32_t i = 0; i < CELLS; ++i) {
+        if (indexed) {
+            entry.push_back(store(i, 5));
+            step.push_back(load(5, i));
+            step.push_back(make(OpCode::ADDR, 5, 2));
+            step.push_back(store(i, 5));
+        } else {
+            entry.push_back(make(OpCode::MOVMI, 0, 0, 0, cells[i]));
+            step.push_back(make(OpCode::MOVRR, 5, 2));
+            step.push_back(make(OpCode::ADDM, 5, 0, 0, cells[i]));
+            step.push_back(make(OpCode::MOVMR, 0, 5, 0, cells[i]));
+        }
+    }
+    step.push_back(make(OpCode::SUBI, 2, 0, 1));
+    step.push_back(branch(2, 4, GT, body));
+    vm.setCall(static_cast<size_t>(body), step);
+    entry.push_back(branch(2, 4, GT, body));
+    if (indexed) {
+        entry.push_back(load(0, 0));
+    } else {
+        entry.push_back(make(OpCode::MOVRI, 0, 0, 0));
+        entry.push_back(make(OpCode::ADDM, 0, 0, 0, cells[0]));
+    }
+    return entry;
+}
+
+inline std::vector<Instruction> cellsMovm(BenchVM& vm, int64_t n) { return cellsLoop(vm, n, false); }
+inline std::vector<Instruction> cellsIndexed(BenchVM& vm, int64_t n) { return cellsLoop(vm, n, true); }
+
+/**
+ * 三体一维定点整数模拟，x 在 r2~r4，v 在 r5~r7
+ * @param vm
+ * @param steps
+ * @return std::vector<Instruction>
+ */
+inline std::vector<Instruction> nbody(BenchVM& vm, int64_t steps) {
+    const auto body = static_cast<int64_t>(vm.newCall({}));
+    std::vector<Instruction> step;
+    // 两两之间的吸引力，与距离成正比
+    auto pair = [&](uint8_t xi, uint8_t xj, uint8_t vi, uint8_t vj) {
+        step.push_back(make(OpCode::MOVRR, 10, xj));
+        step.push_back(make(OpCode::SUBR, 10, xi));
+        step.push_back(make(OpCode::DIVI, 10, 0, 64));
+        step.push_back(make(OpCode::ADDR, vi, 10));
+        step.push_back(make(OpCode::SUBR, vj, 10));
+    };
+    pair(2, 3, 5, 6);
+    pair(2, 4, 5, 7);
+    pair(3, 4, 6, 7);
+    for (uint8_t i = 0; i < 3; ++i) {
+        // 阻尼 v = v * 15 / 16
+        step.push_back(make(OpCode::MULI, 5 + i, 0, 15));
+        step.push_back(make(OpCode::DIVI, 5 + i, 0, 16));
+        step.push_back(make(OpCode::ADDR, 2 + i, 5 + i));
+    }
+    step.push_back(make(OpCode::SUBI, 8, 0, 1));
+    step.push_back(branch(8, 9, GT, body));
+    vm.setCall(static_cast<size_t>(body), step);
+    return {
+        make(OpCode::MOVRI, 2, 0, 0),
+        make(OpCode::MOVRI, 3, 0, 1000),
+        make(OpCode::MOVRI, 4, 0, 5000),
+        make(OpCode::MOVRI, 5, 0, 10),
+        make(OpCode::MOVRI, 6, 0, 0),
+        make(OpCode::MOVRI, 7, 0, -10),
+        make(OpCode::MOVRI, 8, 0, steps),
+        make(OpCode::MOVRI, 9, 0, 0),
+        branch(8, 9, GT, body),
+    };
+}
+
+} // namespace benchprog
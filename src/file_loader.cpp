@@ -5,7 +5,69 @@
 -     This project is followed GPL-3.0 license
 ********************************************************/
 #include "file_loader.hpp"
+#include "lz_codec.hpp"
 #include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FileLoader::MappedFile::MappedFile(const std::string& filename) {
+#ifndef _WIN32
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        const auto size = static_cast<size_t>(st.st_size);
+        if (size >= MMAP_THRESHOLD) {
+            void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                data_ = static_cast<const uint8_t*>(addr);
+                size_ = size;
+                mapped_ = true;
+                ::close(fd);
+                return;
+            }
+        }
+        // 小文件映射与缺页的开销比一次 read 还大
+        fallback_.resize(size);
+        size_t done = 0;
+        while (done < size) {
+            const ssize_t n = ::read(fd, fallback_.data() + done, size - done);
+            if (n <= 0) break;
+            done += static_cast<size_t>(n);
+        }
+        ::close(fd);
+        if (done != size) {
+            throw std::runtime_error("Failed to read file: " + filename);
+        }
+        data_ = fallback_.data();
+        size_ = size;
+        return;
+    }
+    ::close(fd);
+#endif
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    fallback_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+}
+
+FileLoader::MappedFile::~MappedFile() {
+#ifndef _WIN32
+    if (mapped_) ::munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+}
 
 FileLoader::FileData FileLoader::loadFullFileData(const std::string &filename) {
     // 打开文件
@@ -25,8 +87,11 @@ FileLoader::FileData FileLoader::loadFullFileData(const std::string &filename) {
     FileData fileData;
     fileData.header = header;
 
-    // 读取代码段
-    if (header.codeSize > 0) {
+    // 读取代码段，压缩的代码段在这里整段解压
+    if (header.flags & FLAG_COMPRESSED_CODE) {
+        LzCodec::FrameReader frames(file, header.codeSize);
+        while (frames.next(fileData.codeSegment)) {}
+    } else if (header.codeSize > 0) {
         fileData.codeSegment.resize(header.codeSize);
         if (!file.read(reinterpret_cast<char *>(fileData.codeSegment.data()), header.codeSize)) {
             throw std::runtime_error("Failed to read code segment");
@@ -73,6 +138,11 @@ FileLoader::FileHeader FileLoader::readFileHeader(std::ifstream &file) {
     // 读取符号表长度
     file.read(reinterpret_cast<char *>(&header.symbolTableSize), sizeof(header.symbolTableSize));
 
+    // 读取标志位
+    if (header.version >= 3) {
+        file.read(reinterpret_cast<char *>(&header.flags), sizeof(header.flags));
+    }
+
     return header;
 }
 
@@ -91,9 +161,15 @@ bool FileLoader::validateHeader(const FileHeader &header) {
         return false;
     }
 
+    // 不认识的标志位可能改变段的含义，不能忽略
+    if (header.flags & ~FLAG_COMPRESSED_CODE) {
+        std::cerr << "Unsupported file flags: 0x" << std::hex << header.flags << std::dec << std::endl;
+        return false;
+    }
+
     // 版本兼容，文件版本低就能加载
     if (header.version < CURRENT_VERSION) {
-        std::cout << "Warning: File version (" << header.version
+        std::cerr << "Warning: File version (" << header.version
                 << ") is older than current version (" << CURRENT_VERSION
                 << "). Loading anyway." << std::endl;
     }
@@ -102,7 +178,7 @@ bool FileLoader::validateHeader(const FileHeader &header) {
 }
 
 void FileLoader::writeFileHeader(std::ofstream &file, uint64_t codeSize, uint64_t codeNum, uint64_t dataSize,
-                                 uint64_t symbolTableSize) {
+                                 uint64_t symbolTableSize, uint64_t flags) {
     // 写入魔数
     uint32_t magic = MAGIC_NUMBER;
     file.write(reinterpret_cast<const char *>(&magic), sizeof(magic));
@@ -121,4 +197,7 @@ void FileLoader::writeFileHeader(std::ofstream &file, uint64_t codeSize, uint64_
 
     // 写入符号表长度
     file.write(reinterpret_cast<const char *>(&symbolTableSize), sizeof(symbolTableSize));
+
+    // 写入标志位
+    file.write(reinterpret_cast<const char *>(&flags), sizeof(flags));
 }
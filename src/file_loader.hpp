@@ -21,8 +21,12 @@ public:
         uint64_t dataSize = 0;              // 数据段长度
         uint64_t symbolTableSize = 0;       // 符号表长度
         uint64_t codeNum = 0;               // 代码段指令数量
+        uint64_t flags = 0;                 // 段标志位，版本 3 起存在
     };
 
+    // 代码段按 LzCodec 分帧压缩，codeSize 为压缩后的长度
+    static constexpr uint64_t FLAG_COMPRESSED_CODE = 1 << 0;
+
     // 完整文件结构
     struct FileData {
         FileHeader header;
@@ -31,6 +35,26 @@ public:
         std::vector<uint8_t> symbolTableSegment;
     };
 
+    // 只读映射的文件，POSIX 上较大的文件用 mmap，小文件与其他平台整读
+    class MappedFile {
+    public:
+        static constexpr size_t MMAP_THRESHOLD = 256 * 1024;
+
+        explicit MappedFile(const std::string& filename);
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        [[nodiscard]] const uint8_t* data() const { return data_; }
+        [[nodiscard]] size_t size() const { return size_; }
+
+    private:
+        const uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+        bool mapped_ = false;
+        std::vector<uint8_t> fallback_; // 无法映射时的整读缓冲
+    };
+
     /**
     * 加载完整的文件数据（包括所有段）
     * @param filename
@@ -59,13 +83,15 @@ public:
      * @param codeNum
      * @param dataSize
      * @param symbolTableSize
+     * @param flags
      * @return void
      */
-    static void writeFileHeader(std::ofstream &file, uint64_t codeSize = 0, uint64_t codeNum = 0, uint64_t dataSize = 0, uint64_t symbolTableSize = 0);
+    static void writeFileHeader(std::ofstream &file, uint64_t codeSize = 0, uint64_t codeNum = 0, uint64_t dataSize = 0, uint64_t symbolTableSize = 0, uint64_t flags = 0);
 private:
     // 魔数定义
     static constexpr uint32_t MAGIC_NUMBER = 0x4D4C5451; // "QTLM"这个字符串的小端序
 
-    // 当前版本号
-    static constexpr uint32_t CURRENT_VERSION = 1;
+    // 当前版本号，版本 2 起带函数表与数据段（见 ProgramImage），版本 3 起文件头带标志位，
+    // 版本 4 起符号表带各程序的段内偏移，可以按需解码单个函数，版本 5 起数据段末尾带常量池
+    static constexpr uint32_t CURRENT_VERSION = 5;
 };
\ No newline at end of file
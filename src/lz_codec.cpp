@@ -0,0 +1,170 @@
+/******************************************************
+-     Date:  2026.10.21 16:30
+-     File:  lz_codec.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "lz_codec.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    constexpr size_t MIN_MATCH = 4;
+    constexpr size_t MAX_DISTANCE = 65535;
+    constexpr int HASH_BITS = 12;
+    // 末尾若干字节只作字面量，匹配查找时不必检查越界
+    constexpr size_t TAIL_LITERALS = 5;
+
+    uint32_t read32(const uint8_t* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    uint32_t hash4(uint32_t v) {
+        return (v * 2654435761U) >> (32 - HASH_BITS);
+    }
+
+    void writeLength(std::vector<uint8_t>& out, size_t extra) {
+        while (extra >= 255) {
+            out.push_back(255);
+            extra -= 255;
+        }
+        out.push_back(static_cast<uint8_t>(extra));
+    }
+
+    void emit(std::vector<uint8_t>& out, const uint8_t* literals, size_t literal_len,
+              size_t distance, size_t match_len) {
+        const size_t match_code = match_len ? match_len - MIN_MATCH : 0;
+        out.push_back(static_cast<uint8_t>((std::min<size_t>(literal_len, 15) << 4) | std::min<size_t>(match_code, 15)));
+        if (literal_len >= 15) writeLength(out, literal_len - 15);
+        out.insert(out.end(), literals, literals + literal_len);
+        if (match_len == 0) return;
+        out.push_back(static_cast<uint8_t>(distance & 0xFF));
+        out.push_back(static_cast<uint8_t>(distance >> 8));
+        if (match_code >= 15) writeLength(out, match_code - 15);
+    }
+
+    size_t readLength(const uint8_t*& p, const uint8_t* end, size_t base) {
+        if (base != 15) return base;
+        size_t len = base;
+        uint8_t byte;
+        do {
+            if (p >= end) throw std::runtime_error("corrupted LZ block");
+            byte = *p++;
+            len += byte;
+        } while (byte == 255);
+        return len;
+    }
+
+    template<typename T>
+    void append(std::vector<uint8_t>& out, T value) {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+}
+
+std::vector<uint8_t> LzCodec::compressBlock(const uint8_t* src, size_t size) {
+    std::vector<uint8_t> out;
+    out.reserve(size / 2 + 16);
+    std::vector<uint32_t> table(size_t{1} << HASH_BITS, UINT32_MAX);
+
+    size_t anchor = 0;
+    size_t pos = 0;
+    const size_t limit = size > TAIL_LITERALS + MIN_MATCH ? size - TAIL_LITERALS - MIN_MATCH : 0;
+    while (pos < limit) {
+        const uint32_t seq = read32(src + pos);
+        const uint32_t h = hash4(seq);
+        const uint32_t candidate = table[h];
+        table[h] = static_cast<uint32_t>(pos);
+        if (candidate == UINT32_MAX || pos - candidate > MAX_DISTANCE || read32(src + candidate) != seq) {
+            ++pos;
+            continue;
+        }
+        // 向后延长匹配，保留末尾字面量
+        size_t len = MIN_MATCH;
+        const size_t max_len = size - TAIL_LITERALS - pos;
+        while (len < max_len && src[candidate + len] == src[pos + len]) ++len;
+        emit(out, src + anchor, pos - anchor, pos - candidate, len);
+        pos += len;
+        anchor = pos;
+    }
+    emit(out, src + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+void LzCodec::decompressBlock(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+    const uint8_t* p = src;
+    const uint8_t* end = src + size;
+    size_t out = 0;
+    while (p < end) {
+        const uint8_t token = *p++;
+        const size_t literal_len = readLength(p, end, token >> 4);
+        if (static_cast<size_t>(end - p) < literal_len || capacity - out < literal_len) {
+            throw std::runtime_error("corrupted LZ block");
+        }
+        std::memcpy(dst + out, p, literal_len);
+        p += literal_len;
+        out += literal_len;
+        if (p == end) break; // 最后一个序列没有匹配
+
+        if (end - p < 2) throw std::runtime_error("corrupted LZ block");
+        const size_t distance = static_cast<size_t>(p[0]) | (static_cast<size_t>(p[1]) << 8);
+        p += 2;
+        const size_t match_len = readLength(p, end, token & 0x0F) + MIN_MATCH;
+        if (distance == 0 || distance > out || capacity - out < match_len) {
+            throw std::runtime_error("corrupted LZ block");
+        }
+        // 距离可能小于长度（重复模式），逐字节复制
+        const uint8_t* from = dst + out - distance;
+        for (size_t i = 0; i < match_len; ++i) dst[out + i] = from[i];
+        out += match_len;
+    }
+    if (out != capacity) throw std::runtime_error("corrupted LZ block");
+}
+
+std::vector<uint8_t> LzCodec::compressFrames(const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> out;
+    for (size_t offset = 0; offset < data.size(); offset += FRAME_SIZE) {
+        const size_t raw = std::min(FRAME_SIZE, data.size() - offset);
+        std::vector<uint8_t> packed = compressBlock(data.data() + offset, raw);
+        // 压不小时原样存放
+        const bool stored = packed.size() >= raw;
+        append<uint32_t>(out, static_cast<uint32_t>(raw));
+        append<uint32_t>(out, static_cast<uint32_t>(stored ? raw : packed.size()));
+        if (stored) out.insert(out.end(), data.begin() + static_cast<std::ptrdiff_t>(offset),
+                               data.begin() + static_cast<std::ptrdiff_t>(offset + raw));
+        else out.insert(out.end(), packed.begin(), packed.end());
+    }
+    return out;
+}
+
+bool LzCodec::FrameReader::next(std::vector<uint8_t>& out) {
+    if (remaining_ == 0) return false;
+    uint32_t sizes[2];
+    if (remaining_ < sizeof(sizes) || !in_.read(reinterpret_cast<char*>(sizes), sizeof(sizes))) {
+        throw std::runtime_error("truncated compressed segment");
+    }
+    remaining_ -= sizeof(sizes);
+    const uint32_t raw = sizes[0];
+    const uint32_t packed = sizes[1];
+    if (raw > FRAME_SIZE || packed > raw || packed > remaining_) {
+        throw std::runtime_error("corrupted compressed segment");
+    }
+    const size_t base = out.size();
+    out.resize(base + raw);
+    if (packed == raw) {
+        if (!in_.read(reinterpret_cast<char*>(out.data() + base), packed)) {
+            throw std::runtime_error("truncated compressed segment");
+        }
+    } else {
+        packed_.resize(packed);
+        if (!in_.read(reinterpret_cast<char*>(packed_.data()), packed)) {
+            throw std::runtime_error("truncated compressed segment");
+        }
+        decompressBlock(packed_.data(), packed, out.data() + base, raw);
+    }
+    remaining_ -= packed;
+    return true;
+}
@@ -0,0 +1,73 @@
+/******************************************************
+-     Date:  2026.10.21 16:30
+-     File:  lz_codec.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+/**
+ * 内置 LZ77 压缩（LZ4 块格式的简化版），用于压缩 .lmc 代码段
+ *
+ * 压缩流由若干独立帧组成，每帧 uint32 原始长度、uint32 压缩长度、压缩数据，
+ * 两个长度相等时数据按原样存放。帧之间不共享字典，可以逐帧解压
+ *
+ * 块内格式：token 高 4 位为字面量长度，低 4 位为匹配长度 - 4，取 15 时后跟若干
+ * 累加字节（遇到非 255 结束）；随后是字面量、uint16 小端匹配距离。最后一个序列只有字面量
+ */
+class LzCodec {
+public:
+    static constexpr size_t FRAME_SIZE = 64 * 1024; // 每帧原始数据上限
+
+    /**
+     * 压缩一块数据
+     * @param src
+     * @param size
+     * @return std::vector<uint8_t>
+     */
+    static std::vector<uint8_t> compressBlock(const uint8_t* src, size_t size);
+
+    /**
+     * 解压一块数据，格式错误或越界时抛出 std::runtime_error
+     * @param src
+     * @param size
+     * @param dst
+     * @param capacity 必须等于原始长度
+     * @return void
+     */
+    static void decompressBlock(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity);
+
+    /**
+     * 按帧压缩整段数据
+     * @param data
+     * @return std::vector<uint8_t>
+     */
+    static std::vector<uint8_t> compressFrames(const std::vector<uint8_t>& data);
+
+    /**
+     * 逐帧读取并解压
+     */
+    class FrameReader {
+    public:
+        /**
+         * @param in 位于压缩流开头的输入流
+         * @param packed_size 压缩流总长度
+         */
+        FrameReader(std::istream& in, uint64_t packed_size) : in_(in), remaining_(packed_size) {}
+
+        /**
+         * 解压下一帧并追加到 out
+         * @param out
+         * @return bool 没有更多帧时返回 false
+         */
+        bool next(std::vector<uint8_t>& out);
+
+    private:
+        std::istream& in_;
+        uint64_t remaining_;
+        std::vector<uint8_t> packed_; // 复用的压缩数据缓冲
+    };
+};
@@ -1,9 +1,205 @@
+#include "program_image.hpp"
+#include "snapshot.hpp"
+#include "vm/aot.hpp"
+#include "vm/handler.hpp"
+#include "vm/optimizer.hpp"
+#include "vm/verifier.hpp"
+#include "vm/vm.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+    // 执行引擎
+    enum class Engine {
+        Checked,   // run()，运行期检查
+        Verified,  // verify() 后 runVerified()
+        Optimized  // 先优化再校验执行
+    };
+
+    struct Options {
+        std::string image;
+        Engine engine = Engine::Verified;
+        size_t heap_limit = 0;
+        int repeat = 1;
+        int64_t fuel = 0;         // 每次运行的燃料，0 为不限制
+        bool stats = false;
+        std::string snapshot_out; // 装载完成后写出快照
+        std::string aot_out;      // 装载完成后编译 AOT 模块
+        std::string aot;          // 用 AOT 模块代替解释器执行
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    double microseconds(Clock::duration d) {
+        return std::chrono::duration<double, std::micro>(d).count();
+    }
+
+    void usage(const char* self) {
+        std::cerr << "usage: " << self << " [options] <image.lmc>\n"
+                  << "  --engine=checked|verified|optimized  execution engine (default: verified)\n"
+                  << "  --heap-limit=N                       max heap slots, 0 = unlimited\n"
+                  << "  --repeat=N                           run the entry program N times\n"
+                  << "  --fuel=N                             abort a run after about N instructions, 0 = unlimited\n"
+                  << "  --stats                              print timing and heap statistics to stderr\n"
+                  << "  --snapshot-out=FILE                  save the loaded VM as a snapshot for fast startup\n"
+                  << "  --aot-out=FILE                       compile the loaded program to a native module (FILE.cpp is kept)\n"
+                  << "  --aot=FILE                           run through a native module built with the same --engine\n";
+    }
+
+    /**
+     * 解析命令行，失败返回 false
+     * @param argc
+     * @param argv
+     * @param options
+     * @return bool
+     */
+    bool parseArgs(int argc, char* argv[], Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&](const char* key) -> const char* {
+                const size_t n = std::strlen(key);
+                return arg.compare(0, n, key) == 0 ? arg.c_str() + n : nullptr;
+            };
+            if (const char* v = value("--engine=")) {
+                if (std::strcmp(v, "checked") == 0) options.engine = Engine::Checked;
+                else if (std::strcmp(v, "verified") == 0) options.engine = Engine::Verified;
+                else if (std::strcmp(v, "optimized") == 0) options.engine = Engine::Optimized;
+                else return false;
+            } else if (const char* v = value("--heap-limit=")) {
+                options.heap_limit = std::stoull(v);
+            } else if (const char* v = value("--repeat=")) {
+                options.repeat = std::stoi(v);
+                if (options.repeat < 1) return false;
+            } else if (const char* v = value("--fuel=")) {
+                options.fuel = std::stoll(v);
+                if (options.fuel < 0) return false;
+            } else if (const char* v = value("--snapshot-out=")) {
+                options.snapshot_out = v;
+            } else if (const char* v = value("--aot-out=")) {
+                options.aot_out = v;
+            } else if (const char* v = value("--aot=")) {
+                options.aot = v;
+            } else if (arg == "--stats") {
+                options.stats = true;
+            } else if (!arg.empty() && arg[0] != '-' && options.image.empty()) {
+                options.image = arg;
+            } else {
+                return false;
+            }
+        }
+        // AOT 只翻译已校验的程序
+        if (options.engine == Engine::Checked && (!options.aot.empty() || !options.aot_out.empty())) return false;
+        // AOT 模块不消耗燃料
+        if (options.fuel != 0 && !options.aot.empty()) return false;
+        return !options.image.empty();
+    }
+}
+
 /**
- * @param argc 临时测试
+ * 加载 .lmc 镜像并执行入口程序
+ * @param argc
  * @param argv
- * @return
+ * @return VMCALL 2 的退出码，没有请求退出时为入口程序结束时 r0 的低 8 位
  */
 int main(int argc, char *argv[])
 {
-    return 0;
-}
\ No newline at end of file
+    Options options;
+    try {
+        if (!parseArgs(argc, argv, options)) {
+            usage(argv[0]);
+            return 2;
+        }
+    } catch (const std::exception&) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    RegisterVM vm;
+    try {
+        // 启动：读取、解码、装载、校验；快照直接恢复已校验的状态
+        const auto start = Clock::now();
+        vm.setHeapLimit(options.heap_limit);
+        Handler::vmCallTable(vm);
+        std::vector<OpCodeImpl::Instruction> entry;
+        Optimizer::Stats optimizer_stats;
+        bool optimized = false;
+        bool from_snapshot = false;
+        {
+            FileLoader::MappedFile file(options.image);
+            from_snapshot = Snapshot::isSnapshot(file);
+            if (from_snapshot) {
+                Snapshot::Info info = Snapshot::restore(file, vm, entry);
+                optimized = info.flags & Snapshot::FLAG_OPTIMIZED;
+            }
+        }
+        if (!from_snapshot) {
+            // 函数在首次 CALL 时才解码
+            entry = ProgramImage::installLazy(options.image, vm);
+        }
+        if (options.engine == Engine::Optimized && !optimized) {
+            optimizer_stats = Optimizer::optimizeVM(vm, entry);
+            optimized = true;
+            vm.verify(entry);
+        } else if (options.engine != Engine::Checked && !from_snapshot) {
+            vm.verify(entry);
+        }
+        std::unique_ptr<AotModule> aot;
+        if (!options.aot.empty()) {
+            vm.loadAllFuncs();
+            aot = std::make_unique<AotModule>(options.aot);
+            aot->bind(vm, entry);
+        }
+        const auto loaded = Clock::now();
+        if (!options.snapshot_out.empty()) {
+            vm.loadAllFuncs();
+            Snapshot::save(options.snapshot_out, vm, entry, optimized);
+        }
+        if (!options.aot_out.empty()) {
+            vm.loadAllFuncs();
+            AotCompiler::compile(vm, entry, options.aot_out);
+        }
+
+        // 每次运行从清零的寄存器开始，堆与文件描述符保留，用于预热后计时
+        double best = 0, total = 0;
+        int runs = 0;
+        for (int i = 0; i < options.repeat; ++i) {
+            std::memset(vm.registers, 0, sizeof(vm.registers));
+            vm.setFuel(options.fuel != 0 ? options.fuel : RegisterVM::UNLIMITED_FUEL);
+            const auto run_start = Clock::now();
+            if (aot) aot->run();
+            else if (options.engine == Engine::Checked) vm.run(entry);
+            else vm.runVerified(entry);
+            const double elapsed = microseconds(Clock::now() - run_start);
+            best = i == 0 ? elapsed : std::min(best, elapsed);
+            total += elapsed;
+            ++runs;
+            // 程序通过 VMCALL 2 请求退出，剩余的重复运行不再进行
+            if (vm.exitStatus()) break;
+        }
+
+        if (options.stats) {
+            std::cerr << "startup:             " << microseconds(loaded - start) << " us"
+                      << (from_snapshot ? " (snapshot)" : "") << "\n"
+                      << "run (best):          " << best << " us\n"
+                      << "run (mean):          " << total / runs << " us\n"
+                      << "runs:                " << runs << "\n"
+                      << "instructions/run:    " << (aot ? "n/a (aot)" : std::to_string(vm.instructionsRetired() / runs)) << "\n"
+                      << "functions loaded:    " << vm.funcCount() - vm.pendingFuncCount() << " / " << vm.funcCount() << "\n"
+                      << "peak heap slots:     " << vm.peakHeapSlots() << "\n"
+                      << "gc time:             0 us (reference counted heap, no collector)\n";
+            if (options.engine == Engine::Optimized && !from_snapshot) optimizer_stats.print(std::cerr);
+        }
+        return static_cast<int>((vm.exitStatus() ? *vm.exitStatus() : vm.registers[0]) & 0xFF);
+    } catch (const VerifyError& e) {
+        std::cerr << "verify error: " << e.what() << "\n";
+    } catch (const VmTrap& e) {
+        std::cerr << "trap: " << e.what() << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+    }
+    return 1;
+}
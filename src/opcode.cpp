@@ -7,6 +7,7 @@
 #include "opcode.hpp"
 #include <stdexcept>
 #include <iostream>
+#include <string>
 
 // 定义一个映射表，键为操作码，值为一个三元组表示(hasDstOffset, hasSrcOffset, hasImmediate)
 std::unordered_map<OpCodeImpl::OpCode, std::tuple<bool, bool, bool> > OpCodeImpl::opcodeFlagMap = {
@@ -49,8 +50,171 @@ std::unordered_map<OpCodeImpl::OpCode, std::tuple<bool, bool, bool> > OpCodeImpl
     {OpCode::RET, {false, false, false}},
 
     {OpCode::IFRR, {false, false, false}},
+    {OpCode::IFRI, {false, true, true}}, // 源偏移为比较的立即数，使用data字段
+
+    // 位运算指令
+    {OpCode::SHLI, {false, false, true}}, // 左移立即数位，用于乘以2的幂
+
+    // 异常处理指令
+    {OpCode::TRY, {false, false, true}}, // 安装陷阱处理块，立即数为CallLists下标
+    {OpCode::ENDTRY, {false, false, false}},
+    {OpCode::DIVIQ, {false, false, true}},
+
+    // 批量数组指令，操作数都在寄存器中
+    {OpCode::AFILL, {false, false, false}},
+    {OpCode::ACOPY, {false, false, false}},
+    {OpCode::AADDR, {false, false, false}},
+    {OpCode::AADDA, {false, false, false}},
+    {OpCode::ASUBR, {false, false, false}},
+    {OpCode::ASUBA, {false, false, false}},
+    {OpCode::AMULR, {false, false, false}},
+    {OpCode::AMULA, {false, false, false}},
+    {OpCode::ASUM, {false, false, false}},
+    {OpCode::AMIN, {false, false, false}},
+    {OpCode::AMAX, {false, false, false}},
+    {OpCode::AFIND, {false, false, false}},
+    {OpCode::ACMP, {false, false, false}},
+
+    // 紧凑数组指令，立即数为下标寄存器或元素类型
+    {OpCode::LDI8, {false, false, true}},
+    {OpCode::LDI32, {false, false, true}},
+    {OpCode::LDI64, {false, false, true}},
+    {OpCode::LDF64, {false, false, true}},
+    {OpCode::STI8, {false, false, true}},
+    {OpCode::STI32, {false, false, true}},
+    {OpCode::STI64, {false, false, true}},
+    {OpCode::STF64, {false, false, true}},
+    {OpCode::NEWT, {false, false, true}}, // 使用data字段
+    {OpCode::ADDF, {false, false, false}},
+    {OpCode::SUBF, {false, false, false}},
+    {OpCode::MULF, {false, false, false}},
+    {OpCode::DIVF, {false, false, false}},
+    {OpCode::CVT, {false, false, true}},
+    {OpCode::MNEW, {false, false, true}},
+    {OpCode::MGET, {false, false, true}},
+    {OpCode::MPUT, {false, false, true}},
+    {OpCode::MDEL, {false, false, true}},
+    {OpCode::MNEXT, {false, false, true}},
+    {OpCode::NEWR, {false, false, true}},
+    {OpCode::GETFIELD, {false, false, true}},
+    {OpCode::SETFIELD, {false, false, true}},
+    {OpCode::NEWF, {false, false, true}}, // 使用data字段
+    {OpCode::CALLR, {false, false, true}},
+    {OpCode::TAILCALL, {false, false, true}},
+    {OpCode::SWITCH, {false, false, true}}, // 使用data字段
+
+    // 融合比较跳转，立即数为跳转块下标，带 I 的形式源偏移为比较的立即数
+    {OpCode::JEQ, {false, false, true}},
+    {OpCode::JNE, {false, false, true}},
+    {OpCode::JGT, {false, false, true}},
+    {OpCode::JLT, {false, false, true}},
+    {OpCode::JGE, {false, false, true}},
+    {OpCode::JLE, {false, false, true}},
+    {OpCode::JEQI, {false, true, true}},
+    {OpCode::JNEI, {false, true, true}},
+    {OpCode::JGTI, {false, true, true}},
+    {OpCode::JLTI, {false, true, true}},
+    {OpCode::JGEI, {false, true, true}},
+    {OpCode::JLEI, {false, true, true}},
+
+    // 基址加偏移访问，偏移即元素下标
+    {OpCode::LDX, {false, true, false}},
+    {OpCode::STX, {true, false, false}},
+
+    // 常量下标
+    {OpCode::LDC, {false, false, true}},
 };
 
+const char* OpCodeImpl::name(OpCode op) {
+    switch (op) {
+        case OpCode::VMCALL: return "VMCALL";
+        case OpCode::HALT: return "HALT";
+        case OpCode::UNKNOWN: return "UNKNOWN";
+        case OpCode::MOVRI: return "MOVRI";
+        case OpCode::MOVRR: return "MOVRR";
+        case OpCode::MOVRM: return "MOVRM";
+        case OpCode::MOVMI: return "MOVMI";
+        case OpCode::MOVMR: return "MOVMR";
+        case OpCode::MOVMM: return "MOVMM";
+        case OpCode::ADDR: return "ADDR";
+        case OpCode::ADDM: return "ADDM";
+        case OpCode::ADDI: return "ADDI";
+        case OpCode::SUBR: return "SUBR";
+        case OpCode::SUBM: return "SUBM";
+        case OpCode::SUBI: return "SUBI";
+        case OpCode::MULR: return "MULR";
+        case OpCode::MULM: return "MULM";
+        case OpCode::MULI: return "MULI";
+        case OpCode::DIVR: return "DIVR";
+        case OpCode::DIVM: return "DIVM";
+        case OpCode::DIVI: return "DIVI";
+        case OpCode::NEW: return "NEW";
+        case OpCode::CALL: return "CALL";
+        case OpCode::RET: return "RET";
+        case OpCode::IFRR: return "IFRR";
+        case OpCode::IFRI: return "IFRI";
+        case OpCode::SHLI: return "SHLI";
+        case OpCode::TRY: return "TRY";
+        case OpCode::ENDTRY: return "ENDTRY";
+        case OpCode::DIVIQ: return "DIVIQ";
+        case OpCode::AFILL: return "AFILL";
+        case OpCode::ACOPY: return "ACOPY";
+        case OpCode::AADDR: return "AADDR";
+        case OpCode::AADDA: return "AADDA";
+        case OpCode::ASUBR: return "ASUBR";
+        case OpCode::ASUBA: return "ASUBA";
+        case OpCode::AMULR: return "AMULR";
+        case OpCode::AMULA: return "AMULA";
+        case OpCode::ASUM: return "ASUM";
+        case OpCode::AMIN: return "AMIN";
+        case OpCode::AMAX: return "AMAX";
+        case OpCode::AFIND: return "AFIND";
+        case OpCode::ACMP: return "ACMP";
+        case OpCode::LDI8: return "LDI8";
+        case OpCode::LDI32: return "LDI32";
+        case OpCode::LDI64: return "LDI64";
+        case OpCode::LDF64: return "LDF64";
+        case OpCode::STI8: return "STI8";
+        case OpCode::STI32: return "STI32";
+        case OpCode::STI64: return "STI64";
+        case OpCode::STF64: return "STF64";
+        case OpCode::NEWT: return "NEWT";
+        case OpCode::ADDF: return "ADDF";
+        case OpCode::SUBF: return "SUBF";
+        case OpCode::MULF: return "MULF";
+        case OpCode::DIVF: return "DIVF";
+        case OpCode::CVT: return "CVT";
+        case OpCode::MNEW: return "MNEW";
+        case OpCode::MGET: return "MGET";
+        case OpCode::MPUT: return "MPUT";
+        case OpCode::MDEL: return "MDEL";
+        case OpCode::MNEXT: return "MNEXT";
+        case OpCode::NEWR: return "NEWR";
+        case OpCode::GETFIELD: return "GETFIELD";
+        case OpCode::SETFIELD: return "SETFIELD";
+        case OpCode::NEWF: return "NEWF";
+        case OpCode::CALLR: return "CALLR";
+        case OpCode::TAILCALL: return "TAILCALL";
+        case OpCode::SWITCH: return "SWITCH";
+        case OpCode::JEQ: return "JEQ";
+        case OpCode::JNE: return "JNE";
+        case OpCode::JGT: return "JGT";
+        case OpCode::JLT: return "JLT";
+        case OpCode::JGE: return "JGE";
+        case OpCode::JLE: return "JLE";
+        case OpCode::JEQI: return "JEQI";
+        case OpCode::JNEI: return "JNEI";
+        case OpCode::JGTI: return "JGTI";
+        case OpCode::JLTI: return "JLTI";
+        case OpCode::JGEI: return "JGEI";
+        case OpCode::JLEI: return "JLEI";
+        case OpCode::LDX: return "LDX";
+        case OpCode::STX: return "STX";
+        case OpCode::LDC: return "LDC";
+    }
+    return "UNKNOWN";
+}
+
 void OpCodeImpl::Instruction::autoSetFlags() {
     auto it = opcodeFlagMap.find(op);
     if (it != opcodeFlagMap.end()) {
@@ -167,8 +331,11 @@ void OpCodeImpl::Instruction::decode(const std::vector<uint8_t> &bytes) {
     if (bytes.empty()) {
         return;
     }
+    decode(bytes.data(), bytes.size());
+}
 
-    if (bytes.size() < 2) {
+std::size_t OpCodeImpl::Instruction::decode(const uint8_t* bytes, std::size_t length) {
+    if (length < 2) {
         throw std::runtime_error("insufficient data for decoding");
     }
 
@@ -176,82 +343,64 @@ void OpCodeImpl::Instruction::decode(const std::vector<uint8_t> &bytes) {
     op = static_cast<OpCode>(bytes[0]);
     rd = (bytes[1] >> 4) & 0x0F;
     rs = bytes[1] & 0x0F;
+    imm = 0;
+    mem = 0;
 
     // 自动设置标志位
     autoSetFlags();
 
     std::size_t idx = 2;
 
-    // 只有当hasDstOffset为true时才解码目标偏移
-    if (hasDstOffset) {
-        if (idx < bytes.size()) {
-            if ((bytes[idx] >> 7) == 1) {
-                // 31位扩展格式
-                if (bytes.size() < idx + 4) {
-                    throw std::runtime_error("insufficient data for 31-bit destination offset");
-                }
-                // 解析带符号的31位值
-                dstOffset = static_cast<int32_t>(
-                    (static_cast<uint32_t>(bytes[idx] & 0x7F) << 24) |
-                    (static_cast<uint32_t>(bytes[idx + 1]) << 16) |
-                    (static_cast<uint32_t>(bytes[idx + 2]) << 8) |
-                    static_cast<uint32_t>(bytes[idx + 3]));
-                idx += 4;
-            } else {
-                // 7位模式
-                dstOffset = static_cast<int32_t>(static_cast<int8_t>(bytes[idx]));
-                idx++;
+    // 7 位短格式按符号位扩展
+    auto short7 = [](uint8_t byte) {
+        return static_cast<int8_t>(static_cast<uint8_t>(byte << 1)) >> 1;
+    };
+    // 31 位扩展格式，首字节最高位为标志位
+    auto offset31 = [&](int32_t& out, const char* what) {
+        if (idx >= length) throw std::runtime_error("invalid opcode");
+        if ((bytes[idx] >> 7) == 1) {
+            if (length < idx + 4) {
+                throw std::runtime_error(std::string("insufficient data for 31-bit ") + what + " offset");
             }
+            const uint32_t raw = (static_cast<uint32_t>(bytes[idx] & 0x7F) << 24) |
+                                 (static_cast<uint32_t>(bytes[idx + 1]) << 16) |
+                                 (static_cast<uint32_t>(bytes[idx + 2]) << 8) |
+                                 static_cast<uint32_t>(bytes[idx + 3]);
+            out = static_cast<int32_t>(raw << 1) >> 1;
+            idx += 4;
         } else {
-            throw std::runtime_error("invalid opcode");
+            out = short7(bytes[idx]);
+            idx++;
         }
-    }
+    };
+
+    // 只有当hasDstOffset为true时才解码目标偏移
+    if (hasDstOffset) offset31(dstOffset, "destination");
 
     // 只有当hasSrcOffset为true时才解码源偏移
-    if (hasSrcOffset) {
-        if (idx < bytes.size()) {
-            if ((bytes[idx] >> 7) == 1) {
-                // 31位扩展格式
-                if (bytes.size() < idx + 4) {
-                    throw std::runtime_error("insufficient data for 31-bit source offset");
-                }
-                // 解析带符号的31位值
-                srcOffset = static_cast<int32_t>(
-                    (static_cast<uint32_t>(bytes[idx] & 0x7F) << 24) |
-                    (static_cast<uint32_t>(bytes[idx + 1]) << 16) |
-                    (static_cast<uint32_t>(bytes[idx + 2]) << 8) |
-                    static_cast<uint32_t>(bytes[idx + 3]));
-                idx += 4;
-            } else {
-                // 7位模式
-                srcOffset = static_cast<int32_t>(static_cast<int8_t>(bytes[idx]));
-                idx++;
-            }
-        } else {
-            throw std::runtime_error("invalid opcode");
-        }
-    }
+    if (hasSrcOffset) offset31(srcOffset, "source");
 
     // 只有当hasImmediate为true时才解码立即数
     if (hasImmediate) {
-        if (idx < bytes.size()) {
+        if (idx < length) {
             if ((bytes[idx] >> 7) == 1) {
-                // 64位扩展格式
-                if (bytes.size() < idx + 8) {
+                // 63位扩展格式（大端模式），去掉标志位后按符号位扩展
+                if (length < idx + 8) {
                     throw std::runtime_error("insufficient data for 64-bit immediate");
                 }
-                // 解析带符号的64位值（大端模式）
-                imm = 0;
+                uint64_t raw = 0;
                 for (int i = 0; i < 8; i++) {
-                    imm = (imm << 8) | static_cast<int64_t>(bytes[idx + i]);
+                    raw = (raw << 8) | bytes[idx + i];
                 }
+                imm = static_cast<int64_t>(raw << 1) >> 1;
                 idx += 8;
             } else {
                 // 7位模式
-                imm = static_cast<int64_t>(static_cast<int8_t>(bytes[idx]));
+                imm = short7(bytes[idx]);
                 idx++;
             }
         }
     }
     size = idx;
+    return idx;
 }
@@ -29,9 +29,83 @@ public:
 
         NEW,CALL, RET,
 
-        IFRR, IFRI,
+        IFRR, IFRI, // 比较码在 data[0]，条件成立时进入 CallLists[imm]；IFRR 比较 r[rd] 与 r[rs]，IFRI 比较 r[rd] 与 srcOffset
+
+        SHLI,
+
+        TRY, ENDTRY,
+        DIVIQ, // 除数为非 0、非 -1 立即数的快速除法，由优化器改写得到
+
+        // 批量数组指令，rd/rs 寄存器中是 LmArray 的堆地址，只处理 Smi 元素
+        AFILL, ACOPY,  // 全部元素置为 Smi r[rs]；a[rd] 内容替换为 a[rs]
+        AADDR, AADDA,  // 每个元素加 r[rs]；逐元素加 a[rs]（按较短的长度）
+        ASUBR, ASUBA,
+        AMULR, AMULA,
+        ASUM, AMIN, AMAX, // r[rd] = a[rs] 的和/最小值/最大值，没有 Smi 元素时为 0
+        AFIND, // r[rd] = a[rs] 中第一个等于 r[rd] 的下标，没有时为 -1
+        ACMP,  // r[rd] = a[rd] 与 a[rs] 第一个不同元素的下标，完全相同时为 -1
+
+        // 紧凑数组（LmTypedArray），rs 中是数组地址，imm 为存放下标的寄存器，元素宽度由操作码决定
+        LDI8, LDI32, LDI64, LDF64, // r[rd] = t[rs][r[imm]]，整数按符号扩展，f64 取原始位
+        STI8, STI32, STI64, STF64, // t[rs][r[imm]] = r[rd]，整数截断
+        NEWT, // 由 data 中的原始字节新建紧凑数组，imm 为元素类型，地址写入 r1
+
+        // 浮点运算，寄存器中直接存放 IEEE 754 double 的位，不装箱
+        ADDF, SUBF, MULF, DIVF, // r[rd] = r[rd] op r[rs]，除以 0 得到 Inf/NaN，不产生陷阱
+        CVT, // r[rd] = 转换(r[rs])，imm 为 CvtMode
+
+        // 哈希表（LmMap），rs 中是表的地址；imm 低 4 位为存放键的寄存器，加上 MAP_KEY_STRING 表示键寄存器中是字符串地址
+        MNEW,  // r[rd] = 新建的空表，imm 为预计元素个数
+        MGET,  // r[rd] = m[rs][key]，键不存在时 r[rd] 不变（可先放入默认值）
+        MPUT,  // m[rs][key] = r[rd]
+        MDEL,  // 删除 m[rs][key]，r[rd] = 是否存在
+        MNEXT, // 迭代：imm 为游标寄存器（从 0 开始），r[rd] = 下一个键，游标前移；没有更多元素时游标置 -1
+               // 字符串键放在本条指令专用的堆槽位上，下一次执行同一条 MNEXT 时被替换
+
+        // 记录（LmRecord），字段按编号 imm 访问，每条指令带内联缓存
+        NEWR,     // r[rd] = 新建的空记录，imm 为预计字段数
+        GETFIELD, // r[rd] = rec[rs].field(imm)，字段不存在时 r[rd] 不变
+        SETFIELD, // rec[rs].field(imm) = r[rd]，字段不存在时添加
+
+        // 函数对象（LmFunction），可以带捕获值
+        NEWF,  // r[rd] = FuncLists[imm] 的函数对象，data 中每个字节是一个寄存器编号，按顺序捕获其中的值
+        CALLR, // 调用 r[rs] 中的函数对象，捕获值依次写入 r[imm] 起的寄存器；与 CALL 一样返回后只有 r0 可见
+
+        TAILCALL, // 复用当前帧执行 FuncLists[imm]，被调函数返回即当前帧返回；在函数中与 CALL imm; RET 等价
+
+        SWITCH, // 按 r[rd] 进入 data 中分支列表（SwitchTable 编码）对应的跳转块，没有匹配时进入 CallLists[imm]，imm 为 -1 时不跳转
+
+        // 融合比较跳转：比较条件由操作码决定（顺序与比较码一致），按 int64 比较，条件成立时进入 CallLists[imm]
+        JEQ, JNE, JGT, JLT, JGE, JLE,       // r[rd] op r[rs]
+        JEQI, JNEI, JGTI, JLTI, JGEI, JLEI, // r[rd] op srcOffset
+
+        // 基址加偏移访问堆对象的元素：数组元素按 Smi 读写，紧凑数组按元素类型读写，LmBuffer 按无符号字节读写
+        LDX, // r[rd] = heap[r[rs]][srcOffset]
+        STX, // heap[r[rd]][dstOffset] = r[rs]
+
+        LDC, // r[rd] = 常量池第 imm 个常量的堆地址，常量只读、不分配
     };
 
+    // 最后一个操作码，追加指令时同步修改（快照用它判断指令集是否变化）
+    static constexpr OpCode LAST_OPCODE = OpCode::LDC;
+
+    // CVT 的转换方式
+    enum class CvtMode : int8_t {
+        IntToF64, // int64 -> double
+        F64ToInt, // double -> int64，向零取整，NaN 为 0，超出范围时取最近的边界
+        Box,      // double -> TaggedVal（TaggedUtil::encode_Double）
+        Unbox,    // TaggedVal -> double，Smi 按数值转换，其余非 double 为 NaN
+    };
+    static constexpr int8_t CVT_MODE_COUNT = 4;
+
+    // IFRR 的比较码 0~5 为 == != > < >= <=，按 int64 比较；加上 CMP_FLOAT 后把两个寄存器按 double 比较
+    static constexpr int8_t CMP_COUNT = 6;
+    static constexpr int8_t CMP_FLOAT = CMP_COUNT;
+
+    // 哈希表指令的 imm：键寄存器编号 | MAP_KEY_STRING
+    static constexpr int64_t MAP_KEY_STRING = 0x10;
+    static constexpr int64_t MAP_KEY_REG = 0x0F;
+
     // =========================
     // 定义指令结构（用于构造字节码程序）
     // =========================
@@ -48,6 +122,7 @@ public:
         bool hasDstOffset = false;  // 是否有目标偏移
         bool hasSrcOffset = false;  // 是否有源偏移
         bool hasImmediate = false;  // 是否有立即数
+        mutable uint32_t cache = 0; // 运行期内联缓存编号，0 为尚未分配，不参与编码
         std::size_t size = 0;
 
         /**
@@ -61,6 +136,13 @@ public:
          * @return void
          */
         void decode(const std::vector<uint8_t>& bytes);
+        /**
+         * 从字节流中解码一条指令，用于顺序解码整个代码段
+         * @param bytes
+         * @param length 剩余可读字节数
+         * @return std::size_t 本条指令占用的字节数
+         */
+        std::size_t decode(const uint8_t* bytes, std::size_t length);
         /**
          * 自动设置标志位
          * @return void
@@ -68,6 +150,39 @@ public:
         void autoSetFlags();
     };
 
+    /**
+     * 整数比较码对应的融合比较跳转指令
+     * @param cmp 比较码，0~CMP_COUNT-1
+     * @param with_imm 是否为与 srcOffset 比较的形式
+     * @return OpCode
+     */
+    static constexpr OpCode fusedBranch(int8_t cmp, bool with_imm) {
+        return static_cast<OpCode>(static_cast<uint8_t>(with_imm ? OpCode::JEQI : OpCode::JEQ) + cmp);
+    }
+
+    /**
+     * 是否为融合比较跳转指令
+     * @param op
+     * @return bool
+     */
+    static constexpr bool isFusedBranch(OpCode op) { return op >= OpCode::JEQ && op <= OpCode::JLEI; }
+
+    /**
+     * 融合比较跳转指令的比较码
+     * @param op 必须满足 isFusedBranch
+     * @return int8_t
+     */
+    static constexpr int8_t fusedCmp(OpCode op) {
+        return static_cast<int8_t>((static_cast<uint8_t>(op) - static_cast<uint8_t>(OpCode::JEQ)) % CMP_COUNT);
+    }
+
+    /**
+     * 获取操作码名称
+     * @param op
+     * @return const char*
+     */
+    static const char* name(OpCode op);
+
     template<typename T>
     struct LmObject{
         long long key = &value; //地址
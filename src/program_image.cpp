@@ -0,0 +1,530 @@
+/******************************************************
+-     Date:  2026.10.20 14:10
+-     File:  program_image.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "program_image.hpp"
+#include "lz_codec.hpp"
+#include "vm/vm.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    // 顺序读取段内的定长字段
+    class SegmentReader {
+    public:
+        SegmentReader(const std::vector<uint8_t>& segment, const char* name)
+            : data_(segment.data()), size_(segment.size()), name_(name) {}
+
+        template<typename T>
+        T read() {
+            T value;
+            need(sizeof(T));
+            std::memcpy(&value, data_ + pos_, sizeof(T));
+            pos_ += sizeof(T);
+            return value;
+        }
+
+        const uint8_t* take(size_t count) {
+            need(count);
+            const uint8_t* at = data_ + pos_;
+            pos_ += count;
+            return at;
+        }
+
+        [[nodiscard]] const uint8_t* peek() const { return data_ + pos_; }
+        [[nodiscard]] size_t remaining() const { return size_ - pos_; }
+        size_t fill(size_t) { return remaining(); }
+
+    private:
+        const uint8_t* data_;
+        size_t size_;
+        size_t pos_ = 0;
+        const char* name_;
+
+        void need(size_t count) const {
+            if (size_ - pos_ < count) {
+                throw std::runtime_error(std::string("truncated ") + name_ + " segment");
+            }
+        }
+    };
+
+    template<typename T>
+    void append(std::vector<uint8_t>& out, T value) {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    // 单条指令编码的最大长度：操作码、寄存器、两个 31 位偏移、63 位立即数
+    constexpr size_t MAX_INSTR_BYTES = 2 + 4 + 4 + 8;
+
+    // Code 需要提供 fill(n)：尽量备好 n 字节并返回可读字节数
+    template<typename Code>
+    std::vector<OpCodeImpl::Instruction> decodeProgram(Code& code, SegmentReader* data, uint64_t count) {
+        std::vector<OpCodeImpl::Instruction> program;
+        // 指令数来自文件，不按它一次性分配
+        program.reserve(static_cast<size_t>(std::min<uint64_t>(count, 1 << 16)));
+        for (uint64_t i = 0; i < count; ++i) {
+            auto& instr = program.emplace_back();
+            const size_t available = code.fill(MAX_INSTR_BYTES);
+            if (available == 0) throw std::runtime_error("truncated code segment");
+            code.take(instr.decode(code.peek(), available));
+            if (data == nullptr) continue;
+            if (ProgramImage::usesMem(instr.op)) {
+                instr.mem = data->read<int64_t>();
+            }
+            if (ProgramImage::usesData(instr.op)) {
+                const auto length = data->read<uint32_t>();
+                const auto* bytes = reinterpret_cast<const int8_t*>(data->take(length));
+                instr.data.assign(bytes, bytes + length);
+            }
+        }
+        return program;
+    }
+
+    void encodeProgram(const std::vector<OpCodeImpl::Instruction>& program,
+                       std::vector<uint8_t>& code, std::vector<uint8_t>& data) {
+        for (const auto& instr : program) {
+            std::vector<uint8_t> bytes = instr.encode();
+            code.insert(code.end(), bytes.begin(), bytes.end());
+            if (ProgramImage::usesMem(instr.op)) {
+                append<int64_t>(data, instr.mem);
+            }
+            if (ProgramImage::usesData(instr.op)) {
+                append<uint32_t>(data, static_cast<uint32_t>(instr.data.size()));
+                data.insert(data.end(), instr.data.begin(), instr.data.end());
+            }
+        }
+    }
+}
+
+bool ProgramImage::usesMem(OpCodeImpl::OpCode op) {
+    using OpCode = OpCodeImpl::OpCode;
+    switch (op) {
+        case OpCode::MOVMI: case OpCode::MOVMR: case OpCode::MOVMM:
+        case OpCode::ADDM: case OpCode::SUBM: case OpCode::MULM: case OpCode::DIVM:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool ProgramImage::usesData(OpCodeImpl::OpCode op) {
+    using OpCode = OpCodeImpl::OpCode;
+    return op == OpCode::NEW || op == OpCode::NEWT || op == OpCode::IFRR || op == OpCode::IFRI
+           || op == OpCode::NEWF || op == OpCode::SWITCH;
+}
+
+namespace {
+    // 版本 4 符号表中每个程序的索引
+    struct IndexEntry {
+        uint64_t code_offset = 0; // 解压后代码段内的偏移
+        uint64_t code_size = 0;
+        uint64_t data_offset = 0;
+        uint64_t data_size = 0;
+    };
+
+    struct SymbolTable {
+        uint32_t function_count = 0;
+        uint32_t block_count = 0;
+        std::vector<uint64_t> counts; // 各程序的指令数（入口、函数、跳转块）
+        std::vector<IndexEntry> index; // 版本 4 起存在
+        uint64_t pool_size = 0;        // 版本 5 起，数据段末尾常量池的长度
+    };
+
+    /**
+     * 读出符号表，指令数总和必须与文件头一致
+     * 版本 1 没有符号表，全部指令属于入口程序
+     */
+    SymbolTable readSymbolTable(const FileLoader::FileHeader& header, const std::vector<uint8_t>& table) {
+        SymbolTable out;
+        if (header.version < 2) {
+            out.counts = {header.codeNum};
+            return out;
+        }
+
+        SegmentReader symbols(table, "symbol table");
+        out.function_count = symbols.read<uint32_t>();
+        out.block_count = symbols.read<uint32_t>();
+        const uint64_t programs = static_cast<uint64_t>(out.function_count) + out.block_count + 1;
+        const uint64_t per_program = sizeof(uint64_t) + (header.version >= 4 ? sizeof(IndexEntry) : 0);
+        if (programs * per_program > symbols.remaining()) {
+            throw std::runtime_error("truncated symbol table segment");
+        }
+        out.counts.resize(static_cast<size_t>(programs));
+        uint64_t total = 0;
+        for (auto& count : out.counts) {
+            count = symbols.read<uint64_t>();
+            if (count > header.codeNum) {
+                throw std::runtime_error("instruction count does not match file header");
+            }
+            total += count;
+        }
+        if (total != header.codeNum) {
+            throw std::runtime_error("instruction count does not match file header");
+        }
+        if (header.version < 4) return out;
+        if (header.version >= 5) {
+            // 常量池长度在索引之后
+            if (symbols.remaining() < sizeof(IndexEntry) * out.counts.size() + sizeof(uint64_t)) {
+                throw std::runtime_error("truncated symbol table segment");
+            }
+            std::memcpy(&out.pool_size, symbols.peek() + sizeof(IndexEntry) * out.counts.size(), sizeof(out.pool_size));
+            if (out.pool_size > header.dataSize) throw std::runtime_error("constant pool out of range");
+        }
+
+        // 代码偏移在压缩时按解压后的长度计算，读取时再检查
+        const bool compressed = header.flags & FileLoader::FLAG_COMPRESSED_CODE;
+        out.index.resize(out.counts.size());
+        for (auto& entry : out.index) {
+            entry = symbols.read<IndexEntry>();
+            const uint64_t operand_size = header.dataSize - out.pool_size;
+            if ((!compressed && (entry.code_offset > header.codeSize || entry.code_size > header.codeSize - entry.code_offset))
+                || entry.data_offset > operand_size || entry.data_size > operand_size - entry.data_offset) {
+                throw std::runtime_error("program index out of range");
+            }
+        }
+        return out;
+    }
+
+    // 从文件流中按需读取代码段，压缩时逐帧解压
+    class StreamCode {
+    public:
+        StreamCode(std::istream& in, const FileLoader::FileHeader& header) : in_(in), remaining_(header.codeSize) {
+            if (header.flags & FileLoader::FLAG_COMPRESSED_CODE) frames_.emplace(in, header.codeSize);
+        }
+
+        [[nodiscard]] const uint8_t* peek() const { return buffer_.data() + pos_; }
+        [[nodiscard]] size_t remaining() const { return buffer_.size() - pos_; }
+        bool exhausted() { return fill(1) == 0; }
+
+        void take(size_t count) { pos_ += count; }
+
+        size_t fill(size_t want) {
+            while (remaining() < want && pull()) {}
+            return remaining();
+        }
+
+    private:
+        static constexpr size_t CHUNK = 64 * 1024;
+
+        std::istream& in_;
+        uint64_t remaining_; // 未压缩时尚未读取的字节数
+        std::optional<LzCodec::FrameReader> frames_;
+        bool more_frames_ = true; // 压缩时是否还有未读的帧
+        std::vector<uint8_t> buffer_;
+        size_t pos_ = 0;
+
+        // 丢掉已解码的前缀，追加下一块
+        bool pull() {
+            buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(pos_));
+            pos_ = 0;
+            if (frames_) {
+                more_frames_ = more_frames_ && frames_->next(buffer_);
+                return more_frames_;
+            }
+            if (remaining_ == 0) return false;
+            const size_t count = static_cast<size_t>(std::min<uint64_t>(remaining_, CHUNK));
+            const size_t base = buffer_.size();
+            buffer_.resize(base + count);
+            if (!in_.read(reinterpret_cast<char*>(buffer_.data() + base), static_cast<std::streamsize>(count))) {
+                throw std::runtime_error("Failed to read code segment");
+            }
+            remaining_ -= count;
+            return true;
+        }
+    };
+}
+
+struct ProgramImage::Reader::State {
+    std::ifstream file;
+    FileLoader::FileHeader header;
+    std::streamoff code_start = 0;
+    std::vector<uint8_t> symbol_segment;
+    SymbolTable symbols;
+    std::vector<uint8_t> data_segment; // 顺序解码时首次 next() 才整段读入
+    std::optional<SegmentReader> data;
+    std::optional<StreamCode> code;
+    std::shared_ptr<const ConstantPool> constants;
+    size_t next = 0;
+    // 压缩代码段的随机访问：各帧相对代码段开头的位置，首次 read() 时扫描帧头建立
+    std::vector<uint64_t> frame_offsets;
+    uint64_t raw_code_size = 0;
+    size_t cached_frame = SIZE_MAX;
+    std::vector<uint8_t> frame; // 最近解压的一帧，相邻函数常落在同一帧
+
+    /**
+     * 读取代码段开头之后 offset 处的 size 字节，读完恢复流位置，不打断顺序解码
+     */
+    void readAt(uint64_t offset, uint8_t* out, uint64_t size) {
+        if (size == 0) return;
+        file.clear();
+        const std::streampos resume = file.tellg();
+        file.seekg(code_start + static_cast<std::streamoff>(offset));
+        if (!file.read(reinterpret_cast<char*>(out), static_cast<std::streamsize>(size))) {
+            throw std::runtime_error("Failed to read image");
+        }
+        file.seekg(resume);
+    }
+
+    void scanFrames() {
+        uint64_t pos = 0;
+        uint32_t last_raw = LzCodec::FRAME_SIZE;
+        while (pos < header.codeSize) {
+            uint32_t sizes[2];
+            if (header.codeSize - pos < sizeof(sizes)) throw std::runtime_error("truncated compressed segment");
+            readAt(pos, reinterpret_cast<uint8_t*>(sizes), sizeof(sizes));
+            // 只有最后一帧可以不满，帧的原始偏移才能直接由下标算出
+            if (last_raw != LzCodec::FRAME_SIZE || sizes[0] > LzCodec::FRAME_SIZE || sizes[1] > sizes[0]
+                || sizes[1] > header.codeSize - pos - sizeof(sizes)) {
+                throw std::runtime_error("corrupted compressed segment");
+            }
+            frame_offsets.push_back(pos);
+            raw_code_size += sizes[0];
+            last_raw = sizes[0];
+            pos += sizeof(sizes) + sizes[1];
+        }
+    }
+
+    void loadFrame(size_t index) {
+        if (cached_frame == index) return;
+        cached_frame = SIZE_MAX;
+        file.clear();
+        const std::streampos resume = file.tellg();
+        file.seekg(code_start + static_cast<std::streamoff>(frame_offsets[index]));
+        LzCodec::FrameReader frames(file, header.codeSize - frame_offsets[index]);
+        frame.clear();
+        frames.next(frame);
+        file.seekg(resume);
+        cached_frame = index;
+    }
+
+    std::vector<uint8_t> codeSlice(uint64_t offset, uint64_t size) {
+        if (!(header.flags & FileLoader::FLAG_COMPRESSED_CODE)) {
+            std::vector<uint8_t> out(static_cast<size_t>(size));
+            readAt(offset, out.data(), size);
+            return out;
+        }
+        if (frame_offsets.empty()) scanFrames();
+        if (offset > raw_code_size || size > raw_code_size - offset) {
+            throw std::runtime_error("program index out of range");
+        }
+        std::vector<uint8_t> out;
+        out.reserve(static_cast<size_t>(size));
+        while (out.size() < size) {
+            const uint64_t at = offset + out.size();
+            loadFrame(static_cast<size_t>(at / LzCodec::FRAME_SIZE));
+            const size_t begin = static_cast<size_t>(at % LzCodec::FRAME_SIZE);
+            const size_t count = std::min<size_t>(frame.size() - begin, static_cast<size_t>(size - out.size()));
+            out.insert(out.end(), frame.begin() + static_cast<std::ptrdiff_t>(begin),
+                       frame.begin() + static_cast<std::ptrdiff_t>(begin + count));
+        }
+        return out;
+    }
+};
+
+ProgramImage::Reader::Reader(const std::string& filename) : state_(std::make_unique<State>()) {
+    State& st = *state_;
+    st.file.open(filename, std::ios::binary);
+    if (!st.file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    st.header = FileLoader::readFileHeader(st.file);
+    if (!st.file || !FileLoader::validateHeader(st.header)) {
+        throw std::runtime_error("Invalid file format or unsupported version");
+    }
+
+    // 符号表在文件末尾，先跳过去读出来，再回到代码段开头
+    st.code_start = st.file.tellg();
+    st.symbol_segment.resize(static_cast<size_t>(st.header.symbolTableSize));
+    st.readAt(st.header.codeSize + st.header.dataSize, st.symbol_segment.data(), st.header.symbolTableSize);
+    st.symbols = readSymbolTable(st.header, st.symbol_segment);
+    std::vector<uint8_t> pool(static_cast<size_t>(st.symbols.pool_size));
+    st.readAt(st.header.codeSize + st.header.dataSize - st.symbols.pool_size, pool.data(), st.symbols.pool_size);
+    st.constants = ConstantPool::decode(pool.data(), pool.size());
+    st.code.emplace(st.file, st.header);
+}
+
+ProgramImage::Reader::~Reader() = default;
+
+size_t ProgramImage::Reader::functionCount() const {
+    return state_->symbols.function_count;
+}
+
+size_t ProgramImage::Reader::blockCount() const {
+    return state_->symbols.block_count;
+}
+
+bool ProgramImage::Reader::hasNext() const {
+    return state_->next < state_->symbols.counts.size();
+}
+
+bool ProgramImage::Reader::hasIndex() const {
+    return !state_->symbols.index.empty();
+}
+
+const std::shared_ptr<const ConstantPool>& ProgramImage::Reader::constants() const {
+    return state_->constants;
+}
+
+std::vector<OpCodeImpl::Instruction> ProgramImage::Reader::next() {
+    State& st = *state_;
+    if (!hasNext()) throw std::runtime_error("no more programs in image");
+    if (!st.data) {
+        st.data_segment.resize(static_cast<size_t>(st.header.dataSize));
+        st.readAt(st.header.codeSize, st.data_segment.data(), st.header.dataSize);
+        st.data.emplace(st.data_segment, "data");
+    }
+    SegmentReader* data = st.header.version < 2 ? nullptr : &*st.data;
+    std::vector<Instruction> program = decodeProgram(*st.code, data, st.symbols.counts[st.next++]);
+    if (!hasNext() && (!st.code->exhausted() || st.data->remaining() != st.symbols.pool_size) && st.header.version >= 2) {
+        throw std::runtime_error("trailing bytes after last program");
+    }
+    return program;
+}
+
+std::vector<OpCodeImpl::Instruction> ProgramImage::Reader::read(size_t index) {
+    State& st = *state_;
+    if (!hasIndex()) throw std::runtime_error("image has no program index");
+    if (index >= st.symbols.index.size()) throw std::runtime_error("program index out of range");
+
+    const IndexEntry& entry = st.symbols.index[index];
+    const std::vector<uint8_t> code_bytes = st.codeSlice(entry.code_offset, entry.code_size);
+    std::vector<uint8_t> data_bytes(static_cast<size_t>(entry.data_size));
+    st.readAt(st.header.codeSize + entry.data_offset, data_bytes.data(), entry.data_size);
+
+    SegmentReader code(code_bytes, "code");
+    SegmentReader data(data_bytes, "data");
+    std::vector<Instruction> program = decodeProgram(code, &data, st.symbols.counts[index]);
+    if (code.remaining() != 0 || data.remaining() != 0) {
+        throw std::runtime_error("program index does not match code");
+    }
+    return program;
+}
+
+namespace {
+    // 按入口、函数、跳转块的顺序解码全部程序
+    ProgramImage::Program readAll(ProgramImage::Reader& reader) {
+        ProgramImage::Program program;
+        program.entry = reader.next();
+        program.functions.reserve(reader.functionCount());
+        for (size_t i = 0; i < reader.functionCount(); ++i) program.functions.push_back(reader.next());
+        program.blocks.reserve(reader.blockCount());
+        for (size_t i = 0; i < reader.blockCount(); ++i) program.blocks.push_back(reader.next());
+        program.constants = reader.constants();
+        return program;
+    }
+}
+
+ProgramImage::Program ProgramImage::decode(const FileLoader::FileData& file) {
+    Program program;
+    SegmentReader code(file.codeSegment, "code");
+
+    // 每条指令至少 2 字节，先挡住伪造的指令数
+    if (file.header.codeNum > file.codeSegment.size() / 2) {
+        throw std::runtime_error("instruction count exceeds code segment");
+    }
+
+    const SymbolTable symbols = readSymbolTable(file.header, file.symbolTableSegment);
+    SegmentReader data(file.dataSegment, "data");
+    SegmentReader* operands = file.header.version < 2 ? nullptr : &data;
+
+    size_t next = 0;
+    program.entry = decodeProgram(code, operands, symbols.counts[next++]);
+    program.functions.reserve(symbols.function_count);
+    for (uint32_t i = 0; i < symbols.function_count; ++i) {
+        program.functions.push_back(decodeProgram(code, operands, symbols.counts[next++]));
+    }
+    program.blocks.reserve(symbols.block_count);
+    for (uint32_t i = 0; i < symbols.block_count; ++i) {
+        program.blocks.push_back(decodeProgram(code, operands, symbols.counts[next++]));
+    }
+    if (operands && (code.remaining() != 0 || data.remaining() != symbols.pool_size)) {
+        throw std::runtime_error("trailing bytes after last program");
+    }
+    program.constants = ConstantPool::decode(file.dataSegment.data() + file.dataSegment.size() - symbols.pool_size,
+                                             static_cast<size_t>(symbols.pool_size));
+    return program;
+}
+
+ProgramImage::Program ProgramImage::load(const std::string& filename) {
+    Reader reader(filename);
+    return readAll(reader);
+}
+
+void ProgramImage::install(const Program& program, RegisterVM& vm) {
+    if (program.constants) vm.setConstants(program.constants);
+    for (const auto& function : program.functions) vm.newFunc(function);
+    for (const auto& block : program.blocks) vm.newCall(block);
+}
+
+std::vector<OpCodeImpl::Instruction> ProgramImage::installLazy(const std::string& filename, RegisterVM& vm) {
+    auto reader = std::make_shared<Reader>(filename);
+    if (!reader->hasIndex()) {
+        Program program = readAll(*reader);
+        install(program, vm);
+        return std::move(program.entry);
+    }
+
+    // 读取器由加载回调持有，函数全部加载前文件保持打开
+    std::vector<Instruction> entry = reader->read(0);
+    vm.setConstants(reader->constants());
+    const size_t functions = reader->functionCount();
+    for (size_t i = 0; i < reader->blockCount(); ++i) vm.newCall(reader->read(1 + functions + i));
+    vm.newLazyFuncs(functions, [reader](size_t index) { return reader->read(1 + index); });
+    return entry;
+}
+
+void ProgramImage::write(const std::string& filename, const Program& program, bool compress) {
+    std::vector<uint8_t> code;
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> counts;
+    std::vector<uint8_t> index;
+
+    uint64_t total = 0;
+    auto add = [&](const std::vector<Instruction>& instrs) {
+        IndexEntry entry;
+        entry.code_offset = code.size();
+        entry.data_offset = data.size();
+        encodeProgram(instrs, code, data);
+        entry.code_size = code.size() - entry.code_offset;
+        entry.data_size = data.size() - entry.data_offset;
+        append<uint64_t>(counts, instrs.size());
+        append(index, entry);
+        total += instrs.size();
+    };
+    add(program.entry);
+    for (const auto& function : program.functions) add(function);
+    for (const auto& block : program.blocks) add(block);
+
+    std::vector<uint8_t> symbols;
+    append<uint32_t>(symbols, static_cast<uint32_t>(program.functions.size()));
+    append<uint32_t>(symbols, static_cast<uint32_t>(program.blocks.size()));
+    symbols.insert(symbols.end(), counts.begin(), counts.end());
+    symbols.insert(symbols.end(), index.begin(), index.end());
+    const std::vector<uint8_t> pool = program.constants ? program.constants->encode() : std::vector<uint8_t>{};
+    data.insert(data.end(), pool.begin(), pool.end());
+    append<uint64_t>(symbols, pool.size());
+
+    uint64_t flags = 0;
+    if (compress) {
+        code = LzCodec::compressFrames(code);
+        flags |= FileLoader::FLAG_COMPRESSED_CODE;
+    }
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    FileLoader::writeFileHeader(file, code.size(), total, data.size(), symbols.size(), flags);
+    file.write(reinterpret_cast<const char*>(code.data()), static_cast<std::streamsize>(code.size()));
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    file.write(reinterpret_cast<const char*>(symbols.data()), static_cast<std::streamsize>(symbols.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + filename);
+    }
+}
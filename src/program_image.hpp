@@ -0,0 +1,145 @@
+/******************************************************
+-     Date:  2026.10.20 14:10
+-     File:  program_image.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include "file_loader.hpp"
+#include "opcode.hpp"
+#include "vm/constant_pool.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+class RegisterVM;
+
+/**
+ * .lmc 镜像与可执行程序之间的转换
+ *
+ * 版本 2 布局：
+ *  代码段   入口程序、各函数、各跳转块的指令依次编码
+ *  符号表段 uint32 函数数、uint32 跳转块数，随后每个程序一个 uint64 指令数（入口、函数、跳转块）
+ *  数据段   按指令顺序存放编码中没有的操作数：用到堆地址的指令一个 int64 mem，
+ *           NEW/IFRR/IFRI 等一个 uint32 长度加 data 字节
+ * 版本 1 只有代码段，全部指令作为入口程序；版本 3 起代码段可以分帧压缩（FileLoader::FLAG_COMPRESSED_CODE）；
+ * 版本 4 起符号表在指令数之后为每个程序追加一条索引：uint64 代码偏移、代码长度、数据偏移、数据长度，
+ * 代码偏移按解压后的代码段计算；版本 5 起符号表最后是一个 uint64 常量池长度，常量池（ConstantPool 编码）
+ * 占数据段的最后这些字节
+ */
+class ProgramImage {
+public:
+    using Instruction = OpCodeImpl::Instruction;
+
+    // 解码后的完整程序
+    struct Program {
+        std::vector<Instruction> entry;
+        std::vector<std::vector<Instruction>> functions; // CALL 的目标，对应 FuncLists
+        std::vector<std::vector<Instruction>> blocks;    // IFRR/TRY 的目标，对应 CallLists
+        std::shared_ptr<const ConstantPool> constants;   // LDC 的常量池，可以为空
+    };
+
+    /**
+     * 流式读取镜像：先读入符号表，代码段按程序逐个读取、解压、解码，
+     * 入口程序解码完成时后面的帧还没有读。带索引的镜像还可以按下标单独解码任意程序
+     */
+    class Reader {
+    public:
+        explicit Reader(const std::string& filename);
+        ~Reader();
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        [[nodiscard]] size_t functionCount() const;
+        [[nodiscard]] size_t blockCount() const;
+
+        /**
+         * 是否还有未解码的程序
+         * @return bool
+         */
+        [[nodiscard]] bool hasNext() const;
+
+        /**
+         * 按入口、函数、跳转块的顺序解码下一个程序
+         * @return std::vector<Instruction>
+         */
+        std::vector<Instruction> next();
+
+        /**
+         * 镜像是否带程序索引（版本 4 起）
+         * @return bool
+         */
+        [[nodiscard]] bool hasIndex() const;
+
+        /**
+         * 按索引单独读取并解码一个程序，不影响 next() 的进度
+         * @param index 0 为入口，1..functionCount() 为函数，其后为跳转块
+         * @return std::vector<Instruction>
+         */
+        std::vector<Instruction> read(size_t index);
+
+        /**
+         * 镜像的常量池，打开时解析；没有常量池时为空池
+         * @return const std::shared_ptr<const ConstantPool>&
+         */
+        [[nodiscard]] const std::shared_ptr<const ConstantPool>& constants() const;
+
+    private:
+        struct State;
+        std::unique_ptr<State> state_;
+    };
+
+    /**
+     * 解码镜像，格式错误时抛出 std::runtime_error
+     * @param file
+     * @return Program
+     */
+    static Program decode(const FileLoader::FileData& file);
+
+    /**
+     * 读取并解码镜像文件
+     * @param filename
+     * @return Program
+     */
+    static Program load(const std::string& filename);
+
+    /**
+     * 将函数与跳转块装入虚拟机，下标与镜像中一致；常量池不复制，装入同一个 Program 的虚拟机共用
+     * @param program
+     * @param vm
+     * @return void
+     */
+    static void install(const Program& program, RegisterVM& vm);
+
+    /**
+     * 打开镜像并装入虚拟机：跳转块立即解码，带索引时函数登记为延迟加载，首次 CALL 时才解码；
+     * 没有索引的旧镜像全部立即装载
+     * @param filename
+     * @param vm
+     * @return std::vector<Instruction> 入口程序
+     */
+    static std::vector<Instruction> installLazy(const std::string& filename, RegisterVM& vm);
+
+    /**
+     * 以当前版本写出镜像
+     * @param filename
+     * @param program
+     * @param compress 是否压缩代码段
+     * @return void
+     */
+    static void write(const std::string& filename, const Program& program, bool compress = false);
+
+    /**
+     * 指令是否带堆地址操作数
+     * @param op
+     * @return bool
+     */
+    static bool usesMem(OpCodeImpl::OpCode op);
+
+    /**
+     * 指令是否带 data 操作数
+     * @param op
+     * @return bool
+     */
+    static bool usesData(OpCodeImpl::OpCode op);
+};
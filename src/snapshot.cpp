@@ -0,0 +1,214 @@
+/******************************************************
+-     Date:  2026.10.21 10:20
+-     File:  snapshot.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "snapshot.hpp"
+#include "vm/handler_fn.hpp"
+#include "vm/vm.hpp"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+static_assert(sizeof(Snapshot::Header) == 64, "snapshot header layout changed");
+static_assert(sizeof(Snapshot::ProgramRecord) == 16, "snapshot program record layout changed");
+static_assert(sizeof(Snapshot::InstrRecord) == 40, "snapshot instruction record layout changed");
+
+namespace {
+    constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+    constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+    // FNV-1a 按 8 字节分组，避免逐字节计算拖慢启动
+    uint64_t fnv1a(const uint8_t* bytes, size_t size, uint64_t hash = FNV_OFFSET) {
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, bytes + i, sizeof(word));
+            hash ^= word;
+            hash *= FNV_PRIME;
+        }
+        for (; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    // 校验和覆盖整个文件，计算时头部的 checksum 字段按 0 处理
+    uint64_t checksumOf(Snapshot::Header header, const uint8_t* body, size_t body_size) {
+        header.checksum = 0;
+        uint64_t hash = fnv1a(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+        return fnv1a(body, body_size, hash);
+    }
+
+    template<typename T>
+    void append(std::vector<uint8_t>& out, const T& value) {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+}
+
+uint32_t Snapshot::currentAbi() {
+    return (static_cast<uint32_t>(OpCodeImpl::LAST_OPCODE) << 16) | static_cast<uint32_t>(HandlerFn::HANDLER_COUNT);
+}
+
+bool Snapshot::isSnapshot(const FileLoader::MappedFile& file) {
+    uint32_t magic = 0;
+    if (file.size() < sizeof(magic)) return false;
+    std::memcpy(&magic, file.data(), sizeof(magic));
+    return magic == MAGIC_NUMBER;
+}
+
+void Snapshot::save(const std::string& filename, const RegisterVM& vm,
+                    const std::vector<OpCodeImpl::Instruction>& entry, bool optimized) {
+    if (vm.pendingFuncCount() != 0) {
+        throw std::runtime_error("snapshot requires all functions to be loaded");
+    }
+    std::vector<const std::vector<OpCodeImpl::Instruction>*> programs;
+    programs.push_back(&entry);
+    for (const auto& function : vm.FuncLists) programs.push_back(&function);
+    for (const auto& block : vm.CallLists) programs.push_back(&block);
+
+    std::vector<uint8_t> records;
+    std::vector<uint8_t> instrs;
+    std::vector<uint8_t> data;
+    uint64_t instr_count = 0;
+    for (const auto* program : programs) {
+        append(records, ProgramRecord{instr_count, program->size()});
+        for (const auto& instr : *program) {
+            InstrRecord record;
+            record.op = static_cast<uint8_t>(instr.op);
+            record.rd = instr.rd;
+            record.rs = instr.rs;
+            record.flags = instr.size == 19000 ? INSTR_RETURN : 0;
+            record.data_size = static_cast<uint32_t>(instr.data.size());
+            record.data_offset = data.size();
+            record.imm = instr.imm;
+            record.mem = instr.mem;
+            record.dst_offset = instr.dstOffset;
+            record.src_offset = instr.srcOffset;
+            data.insert(data.end(), instr.data.begin(), instr.data.end());
+            append(instrs, record);
+        }
+        instr_count += program->size();
+    }
+
+    Header header;
+    header.abi = currentAbi();
+    header.flags = (vm.verified_entry == &entry ? FLAG_VERIFIED : 0) | (optimized ? FLAG_OPTIMIZED : 0);
+    header.function_count = vm.FuncLists.size();
+    header.block_count = vm.CallLists.size();
+    header.instr_count = instr_count;
+    header.data_size = data.size();
+    const std::vector<uint8_t> pool = vm.constants ? vm.constants->encode() : std::vector<uint8_t>{};
+    header.const_size = pool.size();
+
+    std::vector<uint8_t> body;
+    body.reserve(records.size() + instrs.size() + data.size() + pool.size());
+    body.insert(body.end(), records.begin(), records.end());
+    body.insert(body.end(), instrs.begin(), instrs.end());
+    body.insert(body.end(), data.begin(), data.end());
+    body.insert(body.end(), pool.begin(), pool.end());
+    header.checksum = checksumOf(header, body.data(), body.size());
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(body.data()), static_cast<std::streamsize>(body.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + filename);
+    }
+}
+
+Snapshot::Info Snapshot::restore(const FileLoader::MappedFile& file, RegisterVM& vm,
+                                 std::vector<OpCodeImpl::Instruction>& entry) {
+    if (!vm.FuncLists.empty() || !vm.CallLists.empty()) {
+        throw std::runtime_error("snapshot must be restored into a fresh VM");
+    }
+    Header header;
+    if (file.size() < sizeof(header)) throw std::runtime_error("truncated snapshot");
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != MAGIC_NUMBER) throw std::runtime_error("not a snapshot");
+    if (header.version != CURRENT_VERSION) {
+        throw std::runtime_error("unsupported snapshot version " + std::to_string(header.version));
+    }
+    // 操作码编号或 VMCALL 表不同时，同样的字节表示不同的程序，不能只靠重新校验发现
+    if (header.abi != currentAbi()) {
+        throw std::runtime_error("snapshot was built for a different instruction set or VMCALL table (abi "
+                                 + std::to_string(header.abi) + ", expected " + std::to_string(currentAbi()) + ")");
+    }
+
+    // 逐项按剩余长度检查，避免伪造的计数造成溢出
+    const uint8_t* body = file.data() + sizeof(header);
+    const size_t body_size = file.size() - sizeof(header);
+    const uint64_t max_programs = body_size / sizeof(ProgramRecord);
+    if (header.function_count > max_programs || header.block_count > max_programs - header.function_count
+        || header.function_count + header.block_count + 1 > max_programs) {
+        throw std::runtime_error("truncated snapshot");
+    }
+    const uint64_t program_count = header.function_count + header.block_count + 1;
+    const size_t records_size = program_count * sizeof(ProgramRecord);
+    if (header.instr_count > (body_size - records_size) / sizeof(InstrRecord)) {
+        throw std::runtime_error("truncated snapshot");
+    }
+    const size_t instrs_size = header.instr_count * sizeof(InstrRecord);
+    if (header.const_size > body_size - records_size - instrs_size
+        || header.data_size != body_size - records_size - instrs_size - header.const_size) {
+        throw std::runtime_error("snapshot size does not match header");
+    }
+    if (checksumOf(header, body, body_size) != header.checksum) {
+        throw std::runtime_error("snapshot checksum mismatch");
+    }
+
+    const uint8_t* records = body;
+    const uint8_t* instrs = records + records_size;
+    const auto* data = reinterpret_cast<const int8_t*>(instrs + instrs_size);
+    const auto last_op = static_cast<uint8_t>(OpCodeImpl::LAST_OPCODE);
+
+    auto program = [&](uint64_t index) {
+        ProgramRecord record;
+        std::memcpy(&record, records + index * sizeof(ProgramRecord), sizeof(record));
+        if (record.first > header.instr_count || record.count > header.instr_count - record.first) {
+            throw std::runtime_error("snapshot program out of range");
+        }
+        std::vector<OpCodeImpl::Instruction> out(record.count);
+        for (uint64_t i = 0; i < record.count; ++i) {
+            InstrRecord in;
+            std::memcpy(&in, instrs + (record.first + i) * sizeof(InstrRecord), sizeof(in));
+            if (in.op > last_op) throw std::runtime_error("snapshot contains unknown opcode");
+            if (in.data_offset > header.data_size || in.data_size > header.data_size - in.data_offset) {
+                throw std::runtime_error("snapshot data out of range");
+            }
+            auto& instr = out[i];
+            instr.op = static_cast<OpCodeImpl::OpCode>(in.op);
+            instr.rd = in.rd;
+            instr.rs = in.rs;
+            instr.imm = in.imm;
+            instr.mem = in.mem;
+            instr.dstOffset = in.dst_offset;
+            instr.srcOffset = in.src_offset;
+            if (in.flags & INSTR_RETURN) instr.size = 19000;
+            instr.data.assign(data + in.data_offset, data + in.data_offset + in.data_size);
+        }
+        return out;
+    };
+
+    entry = program(0);
+    vm.FuncLists.reserve(header.function_count);
+    for (uint64_t i = 0; i < header.function_count; ++i) vm.FuncLists.push_back(program(1 + i));
+    vm.CallLists.reserve(header.block_count);
+    for (uint64_t i = 0; i < header.block_count; ++i) vm.CallLists.push_back(program(1 + header.function_count + i));
+    if (header.const_size > 0) {
+        vm.setConstants(ConstantPool::decode(reinterpret_cast<const uint8_t*>(data) + header.data_size,
+                                             static_cast<size_t>(header.const_size)));
+    }
+
+    // 校验和不带密钥，FLAG_VERIFIED 可以连同校验和一起伪造，恢复时总是重新校验
+    vm.verify(entry);
+    Info info;
+    info.flags = header.flags;
+    return info;
+}
@@ -0,0 +1,111 @@
+/******************************************************
+-     Date:  2026.10.21 10:20
+-     File:  snapshot.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include "file_loader.hpp"
+#include "opcode.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class RegisterVM;
+
+/**
+ * 虚拟机快照：保存已解码、已优化、已校验的程序与常量池，启动时映射文件直接恢复
+ *
+ * 布局（全部为定长记录，只用相对偏移，可在任意地址映射）：
+ *  Header
+ *  ProgramRecord[program_count]   入口、各函数、各跳转块
+ *  InstrRecord[instr_count]
+ *  data 字节                       NEW/IFRR 等指令的 data
+ *  常量池                          ConstantPool 编码，版本 3 起
+ * 指令集或 VMCALL 表与当前构建不同（abi 不符）的快照拒绝恢复；静态堆由恢复时的校验重新计算
+ * 校验和只防损坏不防篡改，恢复时总是经 Verifier 重新校验，不信任文件中的校验标志
+ */
+class Snapshot {
+public:
+    static constexpr uint32_t MAGIC_NUMBER = 0x53534D4C; // "LMSS"的小端序
+    // 版本 2 起指令记录带两个偏移与返回标记，版本 3 起带常量池，版本 4 起头部去掉未使用的静态堆槽位数
+    static constexpr uint32_t CURRENT_VERSION = 4;
+
+    // 快照标志位
+    static constexpr uint32_t FLAG_VERIFIED = 1 << 0;  // 保存时入口程序已通过校验，只作记录
+    static constexpr uint32_t FLAG_OPTIMIZED = 1 << 1; // 保存前经过优化器
+
+    // 指令记录标志位
+    static constexpr uint8_t INSTR_RETURN = 1 << 0; // 跳转指令带返回标记（size == 19000）
+
+    struct Header {
+        uint32_t magic = MAGIC_NUMBER;
+        uint32_t version = CURRENT_VERSION;
+        uint32_t abi = 0;          // 指令集与 VMCALL 表标识，恢复时必须与 currentAbi() 相同
+        uint32_t flags = 0;
+        uint64_t function_count = 0;
+        uint64_t block_count = 0;
+        uint64_t instr_count = 0;
+        uint64_t data_size = 0;
+        uint64_t const_size = 0;   // 常量池长度
+        uint64_t checksum = 0;     // 头部之后全部字节的 FNV-1a
+    };
+
+    struct ProgramRecord {
+        uint64_t first = 0; // 第一条指令在 InstrRecord 表中的下标
+        uint64_t count = 0;
+    };
+
+    struct InstrRecord {
+        uint8_t op = 0;
+        uint8_t rd = 0;
+        uint8_t rs = 0;
+        uint8_t flags = 0;
+        uint32_t data_size = 0;
+        uint64_t data_offset = 0;
+        int64_t imm = 0;
+        int64_t mem = 0;
+        int32_t dst_offset = 0;
+        int32_t src_offset = 0;
+    };
+
+    // 恢复结果
+    struct Info {
+        uint32_t flags = 0;
+    };
+
+    /**
+     * 判断映射内容是否为快照
+     * @param file
+     * @return bool
+     */
+    static bool isSnapshot(const FileLoader::MappedFile& file);
+
+    /**
+     * 保存虚拟机中的函数、跳转块与入口程序，延迟加载的函数须先 loadAllFuncs
+     * @param filename
+     * @param vm
+     * @param entry
+     * @param optimized 程序是否经过优化器
+     * @return void
+     */
+    static void save(const std::string& filename, const RegisterVM& vm,
+                     const std::vector<OpCodeImpl::Instruction>& entry, bool optimized);
+
+    /**
+     * 从映射的快照恢复，vm 必须是新建的且已注册 VMCALL
+     * 快照的 abi 与当前构建不同或重新校验失败时抛出异常；恢复后 entry 处于已校验状态，可以直接 runVerified
+     * @param file
+     * @param vm
+     * @param entry
+     * @return Info
+     */
+    static Info restore(const FileLoader::MappedFile& file, RegisterVM& vm,
+                        std::vector<OpCodeImpl::Instruction>& entry);
+
+    /**
+     * 当前构建的指令集与 VMCALL 表标识
+     * @return uint32_t
+     */
+    static uint32_t currentAbi();
+};
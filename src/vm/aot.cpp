@@ -0,0 +1,540 @@
+/******************************************************
+-     Date:  2026.10.22 10:40
+-     File:  aot.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "aot.hpp"
+#include "vm.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+// 编译生成代码用的编译器与头文件目录，由构建系统传入
+#ifndef LMVM_AOT_CXX
+#define LMVM_AOT_CXX "c++"
+#endif
+#ifndef LMVM_AOT_INCLUDE
+#define LMVM_AOT_INCLUDE "src"
+#endif
+
+static_assert(LMVM_AOT_NUM_REGS == NUM_REGS, "AOT register file size differs from the VM");
+
+namespace {
+    using Instruction = OpCodeImpl::Instruction;
+    using OpCode = OpCodeImpl::OpCode;
+
+    // 按入口、函数、跳转块的顺序列出全部程序，下标即生成代码中的程序编号
+    std::vector<const std::vector<Instruction>*> programsOf(const std::vector<Instruction>& entry,
+                                                            const std::vector<std::vector<Instruction>>& funcs,
+                                                            const std::vector<std::vector<Instruction>>& blocks) {
+        std::vector<const std::vector<Instruction>*> programs;
+        programs.reserve(1 + funcs.size() + blocks.size());
+        programs.push_back(&entry);
+        for (const auto& func : funcs) programs.push_back(&func);
+        for (const auto& block : blocks) programs.push_back(&block);
+        return programs;
+    }
+
+    std::string literal(int64_t value) {
+        if (value == INT64_MIN) return "INT64_MIN";
+        return "INT64_C(" + std::to_string(value) + ")";
+    }
+
+    const char* cmpOperator(int8_t code) {
+        static const char* const ops[] = {"==", "!=", ">", "<", ">=", "<="};
+        return ops[code % OpCodeImpl::CMP_COUNT];
+    }
+
+    // 批量数组、紧凑数组、哈希表、记录、函数对象、基址加偏移访问与常量指令，都回到运行器执行
+    bool isHeapOp(OpCode op) {
+        return (op >= OpCode::AFILL && op <= OpCode::NEWT) || (op >= OpCode::MNEW && op <= OpCode::NEWF)
+               || op == OpCode::LDX || op == OpCode::STX || op == OpCode::LDC;
+    }
+
+    /**
+     * 陷阱处理后匹配的 ENDTRY：从 at 之后找到第一个未配对的 ENDTRY，没有时为 n，与 RegisterVM::handleTrap 一致；
+     * 处理后从它的下一条继续，处理块又出错时以它为 at 再查一次外层。从后往前用栈一次算出所有位置
+     */
+    std::vector<size_t> resumeTable(const std::vector<Instruction>& program) {
+        const size_t n = program.size();
+        std::vector<size_t> resume(n + 1, n);
+        std::vector<size_t> ends;
+        for (size_t p = n; p-- > 0;) {
+            resume[p] = ends.empty() ? n : ends.back();
+            if (program[p].op == OpCode::ENDTRY) ends.push_back(p);
+            else if (program[p].op == OpCode::TRY && !ends.empty()) ends.pop_back();
+        }
+        return resume;
+    }
+
+    /**
+     * 各程序执行期间可能改写的寄存器（位掩码），包括它经条件跳转、SWITCH 与 TRY 进入的跳转块；
+     * CALL/CALLR 只改写 r0，TAILCALL 改写被调函数改写的寄存器，VMCALL 按改写全部寄存器处理。跳转块可以互相递归，迭代到不动点
+     */
+    std::vector<uint32_t> clobberMasks(const std::vector<const std::vector<Instruction>*>& programs, size_t block_base) {
+        constexpr uint32_t ALL = (1u << NUM_REGS) - 1;
+        std::vector<uint32_t> masks(programs.size(), 0);
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (size_t id = 0; id < programs.size(); ++id) {
+                uint32_t mask = masks[id];
+                for (const auto& instr : *programs[id]) {
+                    switch (instr.op) {
+                        case OpCode::VMCALL: mask = ALL; break;
+                        case OpCode::NEW: case OpCode::NEWT: mask |= 1u << 1; break;
+                        case OpCode::CALL: case OpCode::CALLR: mask |= 1u; break;
+                        case OpCode::IFRR: case OpCode::IFRI:
+                        case OpCode::JEQ: case OpCode::JNE: case OpCode::JGT: case OpCode::JLT: case OpCode::JGE: case OpCode::JLE:
+                        case OpCode::JEQI: case OpCode::JNEI: case OpCode::JGTI: case OpCode::JLTI: case OpCode::JGEI: case OpCode::JLEI:
+                            mask |= masks[block_base + static_cast<size_t>(instr.imm)];
+                            break;
+                        case OpCode::SWITCH:
+                            if (instr.imm >= 0) mask |= masks[block_base + static_cast<size_t>(instr.imm)];
+                            for (const auto& [key, block] : SwitchTable::decode(instr.data)) {
+                                mask |= masks[block_base + static_cast<size_t>(block)];
+                            }
+                            break;
+                        case OpCode::TRY: mask |= 1u | masks[block_base + static_cast<size_t>(instr.imm)]; break;
+                        case OpCode::TAILCALL: mask |= masks[1 + static_cast<size_t>(instr.imm)]; break;
+                        case OpCode::MOVRI: case OpCode::MOVRM: case OpCode::MOVRR:
+                        case OpCode::ADDR: case OpCode::ADDI: case OpCode::ADDM:
+                        case OpCode::SUBR: case OpCode::SUBI: case OpCode::SUBM:
+                        case OpCode::MULR: case OpCode::MULI: case OpCode::MULM:
+                        case OpCode::DIVR: case OpCode::DIVI: case OpCode::DIVM: case OpCode::DIVIQ:
+                        case OpCode::SHLI:
+                        case OpCode::ASUM: case OpCode::AMIN: case OpCode::AMAX:
+                        case OpCode::AFIND: case OpCode::ACMP:
+                        case OpCode::LDI8: case OpCode::LDI32: case OpCode::LDI64: case OpCode::LDF64:
+                        case OpCode::ADDF: case OpCode::SUBF: case OpCode::MULF: case OpCode::DIVF: case OpCode::CVT:
+                        case OpCode::MNEW: case OpCode::MGET: case OpCode::MDEL:
+                        case OpCode::NEWR: case OpCode::GETFIELD: case OpCode::NEWF:
+                        case OpCode::LDX: case OpCode::LDC:
+                            mask |= 1u << instr.rd;
+                            break;
+                        case OpCode::MNEXT:
+                            mask |= 1u << instr.rd | 1u << instr.imm;
+                            break;
+                        default:
+                            break;
+                    }
+                }
+                if (mask != masks[id]) {
+                    masks[id] = mask;
+                    changed = true;
+                }
+            }
+        }
+        return masks;
+    }
+
+    /**
+     * 生成单个程序对应的 C++ 函数
+     * 帧内只有顺序执行，陷阱处理块仿照解释器记在帧内的小栈上
+     */
+    void emitProgram(std::ostringstream& out, const std::vector<Instruction>& program, size_t id, size_t block_base,
+                     const std::vector<uint32_t>& clobbers) {
+        const size_t n = program.size();
+        size_t tries = 0;
+        bool uses_code = false;
+        for (const auto& instr : program) {
+            if (instr.op == OpCode::TRY) ++tries;
+            if (instr.op == OpCode::VMCALL || instr.op == OpCode::NEW || instr.op == OpCode::CALLR || isHeapOp(instr.op)) {
+                uses_code = true;
+            }
+        }
+
+        std::vector<size_t> resume;
+        std::set<size_t> targets; // 陷阱处理后可能跳到的位置
+        if (tries > 0) {
+            resume = resumeTable(program);
+            for (size_t at = 0; at <= n; ++at) targets.insert(std::min(resume[at] + 1, n));
+            out << "static const uint32_t lm_resume" << id << "[] = {";
+            for (size_t at = 0; at <= n; ++at) out << (at ? "," : "") << resume[at];
+            out << "};\n";
+        }
+
+        out << "static int lm_p" << id << "(LmAotContext* ctx) {\n"
+            << "    int64_t* const r = ctx->regs;\n";
+        if (uses_code) out << "    const char* const code = ctx->programs[" << id << "];\n";
+        if (tries > 0) {
+            out << "    int (*open[" << tries << "])(LmAotContext*);\n"
+                << "    size_t nopen = 0;\n"
+                << "    size_t at = 0;\n";
+        }
+
+        // 帧内没有处理块时陷阱直接交给上一帧
+        auto trap = [&](size_t i) {
+            return tries > 0 ? "{ at = " + std::to_string(i) + "; goto unwind; }" : std::string("return 1;");
+        };
+        const std::string ret = tries > 0 ? "goto done;" : "return 0;";
+        auto reg = [](uint8_t index) { return "r[" + std::to_string(index) + "]"; };
+        auto instrAt = [](size_t i) { return "code + " + std::to_string(i) + " * ctx->instr_stride"; };
+        auto divide = [&](size_t i, const std::string& dst, const std::string& divisor) {
+            return "{ const int64_t d = " + divisor + "; const int64_t t = lm_aot_div_trap(" + dst + ", d); "
+                   "if (t) { ctx->pending = t; if (ctx->open_handlers == 0) ctx->ops->throwTrap(ctx, t); " + trap(i) + " } "
+                   + dst + " /= d; }";
+        };
+
+        for (size_t i = 0; i < n; ++i) {
+            const Instruction& instr = program[i];
+            if (targets.count(i)) out << "L" << i << ":\n";
+            const std::string rd = reg(instr.rd);
+            const std::string rs = reg(instr.rs);
+            const std::string imm = literal(instr.imm);
+            const std::string mem = literal(instr.mem);
+            out << "    ";
+            switch (instr.op) {
+                case OpCode::NEW: out << "ctx->ops->newArray(ctx, " << instrAt(i) << ");"; break;
+                case OpCode::MOVRI:
+                case OpCode::MOVRM: out << rd << " = " << imm << ";"; break;
+                case OpCode::MOVRR: out << rd << " = " << rs << ";"; break;
+                case OpCode::MOVMI: out << "ctx->ops->storeSmi(ctx, " << mem << ", " << imm << ");"; break;
+                case OpCode::MOVMR: out << "ctx->ops->storeSmi(ctx, " << mem << ", " << rs << ");"; break;
+                case OpCode::MOVMM: out << "ctx->ops->storeSmi(ctx, " << mem << ", " << reg(static_cast<uint8_t>(instr.imm)) << ");"; break;
+                case OpCode::ADDR: out << rd << " = lm_aot_add(" << rd << ", " << rs << ");"; break;
+                case OpCode::ADDI: out << rd << " = lm_aot_add(" << rd << ", " << imm << ");"; break;
+                case OpCode::SUBR: out << rd << " = lm_aot_sub(" << rd << ", " << rs << ");"; break;
+                case OpCode::SUBI: out << rd << " = lm_aot_sub(" << rd << ", " << imm << ");"; break;
+                case OpCode::MULR: out << rd << " = lm_aot_mul(" << rd << ", " << rs << ");"; break;
+                case OpCode::MULI: out << rd << " = lm_aot_mul(" << rd << ", " << imm << ");"; break;
+                case OpCode::SHLI: out << rd << " = lm_aot_shl(" << rd << ", " << imm << ");"; break;
+                case OpCode::ADDM:
+                case OpCode::SUBM:
+                case OpCode::MULM: {
+                    const char* fn = instr.op == OpCode::ADDM ? "lm_aot_add" : instr.op == OpCode::SUBM ? "lm_aot_sub" : "lm_aot_mul";
+                    out << "{ int64_t v; if (ctx->ops->loadSmi(ctx, " << mem << ", &v)) " << rd << " = " << fn << "(" << rd << ", v); }";
+                    break;
+                }
+                case OpCode::DIVR: out << divide(i, rd, rs); break;
+                case OpCode::DIVI: out << divide(i, rd, imm); break;
+                case OpCode::DIVIQ: out << rd << " /= " << imm << ";"; break;
+                case OpCode::ADDF: out << rd << " = lm_aot_bits(lm_aot_f64(" << rd << ") + lm_aot_f64(" << rs << "));"; break;
+                case OpCode::SUBF: out << rd << " = lm_aot_bits(lm_aot_f64(" << rd << ") - lm_aot_f64(" << rs << "));"; break;
+                case OpCode::MULF: out << rd << " = lm_aot_bits(lm_aot_f64(" << rd << ") * lm_aot_f64(" << rs << "));"; break;
+                case OpCode::DIVF: out << rd << " = lm_aot_bits(lm_aot_f64(" << rd << ") / lm_aot_f64(" << rs << "));"; break;
+                case OpCode::CVT: out << rd << " = lm_aot_cvt(" << imm << ", " << rs << ");"; break;
+                case OpCode::DIVM:
+                    out << "{ int64_t v; if (ctx->ops->loadSmi(ctx, " << mem << ", &v)) " << divide(i, rd, "v") << " }";
+                    break;
+                case OpCode::TRY:
+                    out << "open[nopen++] = lm_p" << block_base + static_cast<size_t>(instr.imm) << "; ++ctx->open_handlers;";
+                    break;
+                case OpCode::ENDTRY:
+                    // 帧内没有 TRY 时 ENDTRY 不起作用
+                    out << (tries > 0 ? "if (nopen != 0) { --nopen; --ctx->open_handlers; }" : ";");
+                    break;
+                case OpCode::IFRR: case OpCode::IFRI:
+                case OpCode::JEQ: case OpCode::JNE: case OpCode::JGT: case OpCode::JLT: case OpCode::JGE: case OpCode::JLE:
+                case OpCode::JEQI: case OpCode::JNEI: case OpCode::JGTI: case OpCode::JLTI: case OpCode::JGEI: case OpCode::JLEI: {
+                    const bool fused = OpCodeImpl::isFusedBranch(instr.op);
+                    const int8_t cmp = fused ? OpCodeImpl::fusedCmp(instr.op) : instr.data[0];
+                    const bool with_imm = instr.op == OpCode::IFRI || instr.op >= OpCode::JEQI;
+                    const std::string right = with_imm ? literal(instr.srcOffset) : rs;
+                    if (!fused && cmp >= OpCodeImpl::CMP_FLOAT) {
+                        out << "if (lm_aot_f64(" << rd << ") " << cmpOperator(cmp) << " lm_aot_f64(" << right << ")) { if (lm_p";
+                    } else {
+                        out << "if (" << rd << " " << cmpOperator(cmp) << " " << right << ") { if (lm_p";
+                    }
+                    out << block_base + static_cast<size_t>(instr.imm) << "(ctx)) " << trap(i)
+                        << (instr.size == 19000 ? " " + ret : "") << " }";
+                    break;
+                }
+                case OpCode::SWITCH: {
+                    // 交给 C++ 编译器的 switch，由它选择跳转表或比较树
+                    auto enter = [&](int64_t block) {
+                        return "if (lm_p" + std::to_string(block_base + static_cast<size_t>(block)) + "(ctx)) " + trap(i)
+                               + (instr.size == 19000 ? " " + ret : "") + " break;";
+                    };
+                    out << "switch (" << rd << ") {";
+                    for (const auto& [key, block] : SwitchTable::decode(instr.data)) {
+                        out << " case " << literal(key) << ": " << enter(block);
+                    }
+                    if (instr.imm >= 0) out << " default: " << enter(instr.imm);
+                    out << " }";
+                    break;
+                }
+                case OpCode::VMCALL: out << "ctx->ops->vmcall(ctx, " << instrAt(i) << ");"; break;
+                case OpCode::AFILL: case OpCode::ACOPY:
+                case OpCode::AADDR: case OpCode::AADDA:
+                case OpCode::ASUBR: case OpCode::ASUBA:
+                case OpCode::AMULR: case OpCode::AMULA:
+                case OpCode::ASUM: case OpCode::AMIN: case OpCode::AMAX:
+                case OpCode::AFIND: case OpCode::ACMP:
+                case OpCode::LDI8: case OpCode::LDI32: case OpCode::LDI64: case OpCode::LDF64:
+                case OpCode::STI8: case OpCode::STI32: case OpCode::STI64: case OpCode::STF64:
+                case OpCode::NEWT:
+                case OpCode::MNEW: case OpCode::MGET: case OpCode::MPUT: case OpCode::MDEL: case OpCode::MNEXT:
+                case OpCode::NEWR: case OpCode::GETFIELD: case OpCode::SETFIELD:
+                case OpCode::NEWF:
+                case OpCode::LDX: case OpCode::STX: case OpCode::LDC:
+                    // 批量运算本身已向量化，其余需要类型与边界检查，内联缓存也在运行器中，都回到运行器
+                    out << "ctx->ops->heapOp(ctx, " << instrAt(i) << ");";
+                    break;
+                case OpCode::CALL: {
+                    // 与 funcCalling 一致：返回后只有 r0 可见，只需保存被调函数会改写的寄存器
+                    const size_t callee = 1 + static_cast<size_t>(instr.imm);
+                    const uint32_t saved = clobbers[callee] & ~1u;
+                    out << "{ ";
+                    for (uint8_t reg_index = 1; reg_index < NUM_REGS; ++reg_index) {
+                        if (saved & (1u << reg_index)) out << "const int64_t s" << +reg_index << " = " << reg(reg_index) << "; ";
+                    }
+                    out << "const int s = lm_p" << callee << "(ctx); ";
+                    for (uint8_t reg_index = 1; reg_index < NUM_REGS; ++reg_index) {
+                        if (saved & (1u << reg_index)) out << reg(reg_index) << " = s" << +reg_index << "; ";
+                    }
+                    out << "if (s) " << trap(i) << " }";
+                    break;
+                }
+                case OpCode::CALLR: {
+                    // 目标在运行期才知道：保存任一函数可能改写的寄存器与捕获值写入的寄存器，经函数表调用
+                    uint32_t saved = ~((1u << instr.imm) - 1);
+                    for (size_t callee = 1; callee < block_base; ++callee) saved |= clobbers[callee];
+                    saved &= ((1u << NUM_REGS) - 1) & ~1u;
+                    out << "{ ";
+                    for (uint8_t reg_index = 1; reg_index < NUM_REGS; ++reg_index) {
+                        if (saved & (1u << reg_index)) out << "const int64_t s" << +reg_index << " = " << reg(reg_index) << "; ";
+                    }
+                    out << "const int s = lm_funcs[ctx->ops->callTarget(ctx, " << instrAt(i) << ")](ctx); ";
+                    for (uint8_t reg_index = 1; reg_index < NUM_REGS; ++reg_index) {
+                        if (saved & (1u << reg_index)) out << reg(reg_index) << " = s" << +reg_index << "; ";
+                    }
+                    out << "if (s) " << trap(i) << " }";
+                    break;
+                }
+                case OpCode::TAILCALL:
+                    // 丢弃本帧的处理块后直接返回被调函数的结果，编译器按尾调用生成跳转，不增长本机栈
+                    if (tries > 0) out << "ctx->open_handlers -= static_cast<int64_t>(nopen); ";
+                    out << "return lm_p" << 1 + static_cast<size_t>(instr.imm) << "(ctx);";
+                    break;
+                case OpCode::RET: out << ret; break;
+                case OpCode::HALT: out << ";"; break;
+                default:
+                    throw std::runtime_error(std::string("AOT: unsupported opcode ") + OpCodeImpl::name(instr.op));
+            }
+            out << "\n";
+        }
+        if (tries == 0) {
+            out << "    return 0;\n}\n\n";
+            return;
+        }
+
+        out << "L" << n << ":\n"
+            << "done:\n"
+            << "    ctx->open_handlers -= static_cast<int64_t>(nopen);\n"
+            << "    return 0;\n"
+            << "unwind:\n"
+            << "    while (nopen != 0) {\n"
+            << "        int (*handler)(LmAotContext*) = open[--nopen];\n"
+            << "        --ctx->open_handlers;\n"
+            << "        r[0] = ctx->pending;\n"
+            << "        ctx->pending = 0;\n"
+            << "        at = lm_resume" << id << "[at];\n"
+            << "        if (handler(ctx) == 0) goto resume;\n"
+            << "    }\n"
+            << "    return 1;\n"
+            << "resume:\n"
+            << "    if (at < " << n << ") ++at;\n"
+            << "    switch (at) {\n";
+        for (size_t target : targets) out << "        case " << target << ": goto L" << target << ";\n";
+        out << "        default: goto done;\n"
+            << "    }\n"
+            << "}\n\n";
+    }
+}
+
+uint64_t AotCompiler::fingerprint(const RegisterVM& vm, const std::vector<OpCodeImpl::Instruction>& entry) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto mix = [&](uint64_t value) {
+        hash ^= value;
+        hash *= 0x100000001b3ULL;
+    };
+    for (const auto* program : programsOf(entry, vm.FuncLists, vm.CallLists)) {
+        mix(program->size());
+        for (const auto& instr : *program) {
+            mix(static_cast<uint64_t>(instr.op) | (static_cast<uint64_t>(instr.rd) << 8)
+                | (static_cast<uint64_t>(instr.rs) << 16) | (static_cast<uint64_t>(instr.size == 19000) << 24));
+            mix(static_cast<uint64_t>(instr.imm));
+            mix(static_cast<uint64_t>(instr.mem));
+            // 融合比较跳转的常量、LDX/STX 的下标都在偏移里，直接写进生成的代码
+            mix(static_cast<uint64_t>(static_cast<uint32_t>(instr.srcOffset))
+                | (static_cast<uint64_t>(static_cast<uint32_t>(instr.dstOffset)) << 32));
+            mix(instr.data.size());
+            for (int8_t byte : instr.data) mix(static_cast<uint8_t>(byte));
+        }
+    }
+    return hash;
+}
+
+std::string AotCompiler::emit(const RegisterVM& vm, const std::vector<OpCodeImpl::Instruction>& entry) {
+    if (vm.verified_entry != &entry) {
+        throw std::runtime_error("program must pass verify() before AOT compilation");
+    }
+    if (vm.pendingFuncCount() != 0) {
+        throw std::runtime_error("AOT compilation requires all functions to be loaded");
+    }
+    const auto programs = programsOf(entry, vm.FuncLists, vm.CallLists);
+    const size_t block_base = 1 + vm.FuncLists.size();
+    const std::vector<uint32_t> clobbers = clobberMasks(programs, block_base);
+
+    std::ostringstream out;
+    out << "// Generated by AotCompiler, program fingerprint 0x" << std::hex << fingerprint(vm, entry) << std::dec << "\n"
+        << "#include \"vm/aot_abi.hpp\"\n\n";
+    for (size_t id = 0; id < programs.size(); ++id) out << "static int lm_p" << id << "(LmAotContext* ctx);\n";
+    out << "\n";
+    // CALLR 经函数表按下标调用，没有函数时 callTarget 总会抛出，表中只放一个空指针占位
+    const bool indirect = std::any_of(programs.begin(), programs.end(), [](const auto* program) {
+        return std::any_of(program->begin(), program->end(), [](const Instruction& instr) { return instr.op == OpCode::CALLR; });
+    });
+    if (indirect) {
+        out << "static int (*const lm_funcs[])(LmAotContext*) = {";
+        for (size_t id = 1; id < block_base; ++id) out << (id > 1 ? ", " : "") << "lm_p" << id;
+        out << (block_base == 1 ? "nullptr" : "") << "};\n\n";
+    }
+    for (size_t id = 0; id < programs.size(); ++id) emitProgram(out, *programs[id], id, block_base, clobbers);
+    out << "extern \"C\" uint32_t lmvm_aot_abi() { return LMVM_AOT_ABI_VERSION; }\n"
+        << "extern \"C\" uint64_t lmvm_aot_fingerprint() { return 0x" << std::hex << fingerprint(vm, entry) << std::dec << "ULL; }\n"
+        << "extern \"C\" int lmvm_aot_entry(LmAotContext* ctx) { return lm_p0(ctx); }\n";
+    return out.str();
+}
+
+void AotCompiler::build(const std::string& source, const std::string& module) {
+    const std::string command = std::string(LMVM_AOT_CXX) + " -std=c++17 -O2 -fPIC -shared -I\"" LMVM_AOT_INCLUDE "\" \""
+                                + source + "\" -o \"" + module + "\"";
+    if (std::system(command.c_str()) != 0) {
+        throw std::runtime_error("AOT build failed: " + command);
+    }
+}
+
+void AotCompiler::compile(const RegisterVM& vm, const std::vector<OpCodeImpl::Instruction>& entry,
+                          const std::string& module) {
+    const std::string source = module + ".cpp";
+    {
+        std::ofstream file(source);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + source);
+        }
+        file << emit(vm, entry);
+        if (!file) {
+            throw std::runtime_error("Failed to write file: " + source);
+        }
+    }
+    build(source, module);
+}
+
+const LmAotOps AotModule::ops_ = {
+    &AotModule::vmcall,
+    &AotModule::newArray,
+    &AotModule::storeSmi,
+    &AotModule::loadSmi,
+    &AotModule::throwTrap,
+    &AotModule::heapOp,
+    &AotModule::callTarget,
+};
+
+AotModule::AotModule(const std::string& path) {
+#ifdef _WIN32
+    throw std::runtime_error("AOT modules are not supported on this platform");
+#else
+    // 不带目录的名字会按系统库路径查找，补上 ./
+    const std::string file = path.find('/') == std::string::npos ? "./" + path : path;
+    handle_ = dlopen(file.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle_ == nullptr) {
+        throw std::runtime_error("Failed to load AOT module: " + std::string(dlerror()));
+    }
+    auto abi = reinterpret_cast<uint32_t (*)()>(dlsym(handle_, "lmvm_aot_abi"));
+    auto fingerprint = reinterpret_cast<uint64_t (*)()>(dlsym(handle_, "lmvm_aot_fingerprint"));
+    entry_ = reinterpret_cast<EntryFn>(dlsym(handle_, "lmvm_aot_entry"));
+    if (abi == nullptr || fingerprint == nullptr || entry_ == nullptr || abi() != LMVM_AOT_ABI_VERSION) {
+        dlclose(handle_);
+        throw std::runtime_error("not a compatible AOT module: " + path);
+    }
+    fingerprint_ = fingerprint();
+#endif
+}
+
+AotModule::~AotModule() {
+#ifndef _WIN32
+    if (handle_ != nullptr) dlclose(handle_);
+#endif
+}
+
+void AotModule::bind(RegisterVM& vm, const std::vector<OpCodeImpl::Instruction>& entry) {
+    if (vm.verified_entry != &entry) {
+        throw std::runtime_error("program must pass verify() before AOT execution");
+    }
+    if (vm.pendingFuncCount() != 0 || AotCompiler::fingerprint(vm, entry) != fingerprint_) {
+        throw std::runtime_error("AOT module was built from a different program");
+    }
+    programs_.clear();
+    for (const auto* program : programsOf(entry, vm.FuncLists, vm.CallLists)) {
+        programs_.push_back(reinterpret_cast<const char*>(program->data()));
+    }
+    ctx_ = {};
+    ctx_.regs = vm.registers;
+    ctx_.vm = &vm;
+    ctx_.ops = &ops_;
+    ctx_.programs = programs_.data();
+    ctx_.instr_stride = sizeof(OpCodeImpl::Instruction);
+}
+
+void AotModule::run() {
+    if (ctx_.vm == nullptr) throw std::runtime_error("AOT module is not bound to a VM");
+    ctx_.pending = 0;
+    ctx_.open_handlers = 0;
+    auto* vm = static_cast<RegisterVM*>(ctx_.vm);
+    vm->exit_status.reset();
+    try {
+        entry_(&ctx_);
+    } catch (const VmExit& e) {
+        vm->exit_status = e.code();
+    }
+}
+
+void AotModule::vmcall(LmAotContext* ctx, const void* instr) {
+    auto* vm = static_cast<RegisterVM*>(ctx->vm);
+    const auto* in = static_cast<const OpCodeImpl::Instruction*>(instr);
+    (*vm->vm_call_table[in->imm])(in);
+}
+
+void AotModule::newArray(LmAotContext* ctx, const void* instr) {
+    static_cast<RegisterVM*>(ctx->vm)->newOnHeap(static_cast<const OpCodeImpl::Instruction*>(instr));
+}
+
+void AotModule::heapOp(LmAotContext* ctx, const void* instr) {
+    static_cast<RegisterVM*>(ctx->vm)->heapOp(static_cast<const OpCodeImpl::Instruction*>(instr));
+}
+
+int64_t AotModule::callTarget(LmAotContext* ctx, const void* instr) {
+    return static_cast<int64_t>(static_cast<RegisterVM*>(ctx->vm)->enterCallTarget(static_cast<const OpCodeImpl::Instruction*>(instr)));
+}
+
+void AotModule::storeSmi(LmAotContext* ctx, int64_t mem, int64_t value) {
+    auto* vm = static_cast<RegisterVM*>(ctx->vm);
+    LmHeapObject*& slot = vm->heap[mem];
+    if (slot != nullptr) slot->del_ref();
+    auto* arr = new LmArray(1);
+    arr->push(TaggedUtil::encode_Smi(value));
+    slot = arr;
+}
+
+int AotModule::loadSmi(LmAotContext* ctx, int64_t mem, int64_t* value) {
+    LmHeapObject* obj = static_cast<RegisterVM*>(ctx->vm)->heap[mem];
+    auto* arr = obj ? dynamic_cast<LmArray*>(obj) : nullptr;
+    if (arr == nullptr || arr->get_size() == 0) return 0;
+    TaggedVal val = arr->get(0);
+    if (TaggedUtil::get_tagged_type(val) != TaggedType::Smi) return 0;
+    *value = TaggedUtil::decode_Smi(val);
+    return 1;
+}
+
+void AotModule::throwTrap(LmAotContext*, int64_t code) {
+    throw VmTrap(static_cast<TrapCode>(code));
+}
@@ -0,0 +1,99 @@
+/******************************************************
+-     Date:  2026.10.22 10:40
+-     File:  aot.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include "../opcode.hpp"
+#include "aot_abi.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class RegisterVM;
+
+/**
+ * 提前编译：把已校验的入口程序、函数与跳转块翻译成一个 C++ 翻译单元，
+ * 每个程序一个 C++ 函数，编译成共享库后由 AotModule 加载执行
+ */
+class AotCompiler {
+public:
+    /**
+     * 生成 C++ 源码，入口程序必须先通过 verify
+     * @param vm
+     * @param entry
+     * @return std::string
+     */
+    static std::string emit(const RegisterVM& vm, const std::vector<OpCodeImpl::Instruction>& entry);
+
+    /**
+     * 程序指纹，模块只能绑定到生成它的那份程序
+     * @param vm
+     * @param entry
+     * @return uint64_t
+     */
+    static uint64_t fingerprint(const RegisterVM& vm, const std::vector<OpCodeImpl::Instruction>& entry);
+
+    /**
+     * 调用 C++ 编译器把源码编译为共享库，失败时抛出 std::runtime_error
+     * @param source
+     * @param module
+     * @return void
+     */
+    static void build(const std::string& source, const std::string& module);
+
+    /**
+     * 生成源码写到 module + ".cpp" 并编译为 module
+     * @param vm
+     * @param entry
+     * @param module
+     * @return void
+     */
+    static void compile(const RegisterVM& vm, const std::vector<OpCodeImpl::Instruction>& entry,
+                        const std::string& module);
+};
+
+/**
+ * 加载 AOT 共享库并在虚拟机上执行
+ */
+class AotModule {
+public:
+    explicit AotModule(const std::string& path);
+    ~AotModule();
+    AotModule(const AotModule&) = delete;
+    AotModule& operator=(const AotModule&) = delete;
+
+    /**
+     * 绑定到已校验的程序，指纹不一致时抛出 std::runtime_error
+     * 绑定后虚拟机中的程序不能再修改
+     * @param vm
+     * @param entry
+     * @return void
+     */
+    void bind(RegisterVM& vm, const std::vector<OpCodeImpl::Instruction>& entry);
+
+    /**
+     * 执行入口程序，语义与 runVerified 相同，不统计执行指令数，也不消耗燃料
+     * @return void
+     */
+    void run();
+
+private:
+    using EntryFn = int (*)(LmAotContext*);
+
+    void* handle_ = nullptr;
+    EntryFn entry_ = nullptr;
+    uint64_t fingerprint_ = 0;
+    std::vector<const char*> programs_;
+    LmAotContext ctx_{};
+
+    static const LmAotOps ops_;
+    static void vmcall(LmAotContext* ctx, const void* instr);
+    static void newArray(LmAotContext* ctx, const void* instr);
+    static void storeSmi(LmAotContext* ctx, int64_t mem, int64_t value);
+    static int loadSmi(LmAotContext* ctx, int64_t mem, int64_t* value);
+    [[noreturn]] static void throwTrap(LmAotContext* ctx, int64_t code);
+    static void heapOp(LmAotContext* ctx, const void* instr);
+    static int64_t callTarget(LmAotContext* ctx, const void* instr);
+};
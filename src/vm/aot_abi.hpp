@@ -0,0 +1,93 @@
+/******************************************************
+-     Date:  2026.10.22 10:40
+-     File:  aot_abi.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+/**
+ * AOT 模块与运行器之间的接口，生成的 C++ 只包含这一个头文件
+ * 寄存器运算直接内联，堆、VMCALL 与陷阱经由 LmAotOps 回到运行器，
+ * 所以模块不依赖虚拟机的类布局，也不需要导出运行器的符号
+ */
+
+// 接口版本，LmAotContext/LmAotOps 布局、程序指纹的算法、内联函数或生成代码的语义变化时递增
+#define LMVM_AOT_ABI_VERSION 6u
+#define LMVM_AOT_NUM_REGS 16
+
+struct LmAotContext;
+
+// 运行器提供的回调，instr 指向原程序中的 OpCodeImpl::Instruction
+struct LmAotOps {
+    void (*vmcall)(LmAotContext* ctx, const void* instr);
+    void (*newArray)(LmAotContext* ctx, const void* instr);                  // NEW，地址写入 r1
+    void (*storeSmi)(LmAotContext* ctx, int64_t mem, int64_t value);        // MOVM*
+    int (*loadSmi)(LmAotContext* ctx, int64_t mem, int64_t* value);         // *M 运算的操作数，取不到时返回 0
+    [[noreturn]] void (*throwTrap)(LmAotContext* ctx, int64_t code);        // 没有处理块时抛出 VmTrap
+    void (*heapOp)(LmAotContext* ctx, const void* instr);                   // AFILL ~ NEWT, MNEW ~ NEWF
+    int64_t (*callTarget)(LmAotContext* ctx, const void* instr);            // CALLR，写入捕获值后返回函数下标
+};
+
+struct LmAotContext {
+    int64_t* regs;              // 虚拟机寄存器
+    void* vm;
+    const LmAotOps* ops;
+    const char* const* programs; // 各程序第一条指令，下标为 0 入口、1.. 函数、其后跳转块
+    size_t instr_stride;        // sizeof(OpCodeImpl::Instruction)
+    int64_t pending;            // 正在展开的陷阱码
+    int64_t open_handlers;      // 所有帧中已安装未结束的陷阱处理块数
+};
+
+// 整数运算按补码回绕，与解释器在常见编译器上的行为一致
+static inline int64_t lm_aot_add(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b)); }
+static inline int64_t lm_aot_sub(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b)); }
+static inline int64_t lm_aot_mul(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b)); }
+static inline int64_t lm_aot_shl(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) << b); }
+
+// 除法陷阱码，0 表示可以直接相除（对应 TrapCode）
+static inline int64_t lm_aot_div_trap(int64_t dividend, int64_t divisor) {
+    if (static_cast<uint64_t>(divisor) + 1 > 1) return 0;
+    if (divisor == 0) return 1;
+    return dividend == INT64_MIN ? 2 : 0;
+}
+
+// 寄存器中的 double 按位存放
+static inline double lm_aot_f64(int64_t bits) { double d; std::memcpy(&d, &bits, sizeof(d)); return d; }
+static inline int64_t lm_aot_bits(double d) { int64_t bits; std::memcpy(&bits, &d, sizeof(bits)); return bits; }
+
+// CVT，与 RegisterVM::convert 及 TaggedUtil::encode_Double/decode_Double 一致
+static inline int64_t lm_aot_cvt(int64_t mode, int64_t value) {
+    const uint64_t sign = 1ULL << 63, low60 = (1ULL << 60) - 1;
+    switch (mode) {
+        case 0: return lm_aot_bits(static_cast<double>(value));
+        case 1: {
+            const double d = lm_aot_f64(value);
+            if (std::isnan(d)) return 0;
+            if (d >= 0x1p63) return INT64_MAX;
+            if (d < -0x1p63) return INT64_MIN;
+            return static_cast<int64_t>(d);
+        }
+        case 2: {
+            const auto bits = std::isnan(lm_aot_f64(value)) ? 0x7FF8000000000000ULL : static_cast<uint64_t>(value);
+            const uint64_t top4 = (bits >> 59) & 0xF;
+            if (top4 == 0b0111 || top4 == 0b1000) return static_cast<int64_t>((bits & sign) | ((bits & low60) << 3) | 0b100);
+            return static_cast<int64_t>((bits & ~0b111ULL) | 0b110);
+        }
+        default: {
+            const auto v = static_cast<uint64_t>(value);
+            if ((v & 0b111) == 0b100) {
+                const uint64_t low = (v >> 3) & low60;
+                return static_cast<int64_t>((v & sign) | ((low >> 59 ? 0b011ULL : 0b100ULL) << 60) | low);
+            }
+            if ((v & 0b111) == 0b110) return static_cast<int64_t>(v & ~0b111ULL);
+            if ((v & 0b111) == 0b001) return lm_aot_bits(static_cast<double>(value >> 3));
+            return lm_aot_bits(std::numeric_limits<double>::quiet_NaN());
+        }
+    }
+}
@@ -0,0 +1,334 @@
+/******************************************************
+-     Date:  2026.10.23 09:30
+-     File:  array_ops.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "array_ops.hpp"
+#include "handler.hpp"
+#include "vm.hpp"
+#include <algorithm>
+#include <bit>
+#include <climits>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace {
+    using Arith = ArrayOps::Arith;
+    using Reduce = ArrayOps::Reduce;
+
+    constexpr uint64_t TAG_MASK = 0b111;
+    constexpr uint64_t SMI_TAG = static_cast<uint64_t>(TaggedType::Smi);
+
+    // 目标支持 AVX-512 时，编译器会把逐元素运算与求和的标量循环自动向量化为 512 位，
+    // 实测比手写的 256 位内核快，这两类交给编译器；最值、查找与比较的循环无法自动向量化，始终使用内核
+#ifdef __AVX512F__
+    constexpr bool LINEAR_KERNEL = false;
+#else
+    constexpr bool LINEAR_KERNEL = true;
+#endif
+
+    bool isSmi(TaggedVal val) { return (static_cast<uint64_t>(val) & TAG_MASK) == SMI_TAG; }
+
+    void release(TaggedVal val) {
+        if (TaggedUtil::is_HeapObject(val)) TaggedUtil::decode_HeapObject(val)->del_ref();
+    }
+
+    // operand 为另一侧的整数左移 3 位（即去掉标记的 Smi）
+    template<Arith kOp>
+    TaggedVal applyTagged(TaggedVal val, uint64_t operand) {
+        const auto x = static_cast<uint64_t>(val);
+        if constexpr (kOp == Arith::Add) return static_cast<TaggedVal>(x + operand);
+        else if constexpr (kOp == Arith::Sub) return static_cast<TaggedVal>(x - operand);
+        else return static_cast<TaggedVal>((x >> 3) * operand + SMI_TAG);
+    }
+
+    template<Arith kOp>
+    void arithScalarLoop(TaggedVal* vals, size_t begin, size_t end, uint64_t operand) {
+        for (size_t i = begin; i < end; ++i) {
+            if (isSmi(vals[i])) vals[i] = applyTagged<kOp>(vals[i], operand);
+        }
+    }
+
+    template<Arith kOp>
+    void arithArrayLoop(TaggedVal* dst, const TaggedVal* src, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (isSmi(dst[i]) && isSmi(src[i])) {
+                dst[i] = applyTagged<kOp>(dst[i], static_cast<uint64_t>(src[i]) - SMI_TAG);
+            }
+        }
+    }
+
+#ifdef __AVX2__
+    __m256i load(const TaggedVal* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    void store(TaggedVal* p, __m256i v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    int laneMask(__m256i v) { return _mm256_movemask_pd(_mm256_castsi256_pd(v)); }
+
+    // Smi 元素所在的通道全 1
+    __m256i smiLanes(__m256i v) {
+        return _mm256_cmpeq_epi64(_mm256_and_si256(v, _mm256_set1_epi64x(TAG_MASK)), _mm256_set1_epi64x(SMI_TAG));
+    }
+
+    // AVX2 没有 64 位乘法，用 32 位乘法拼出低 64 位
+    __m256i mullo64(__m256i a, __m256i b) {
+        const __m256i low = _mm256_mul_epu32(a, b);
+        const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                               _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+        return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+    }
+
+    template<Arith kOp>
+    __m256i applyTagged(__m256i x, __m256i operand) {
+        if constexpr (kOp == Arith::Add) return _mm256_add_epi64(x, operand);
+        else if constexpr (kOp == Arith::Sub) return _mm256_sub_epi64(x, operand);
+        else return _mm256_add_epi64(mullo64(_mm256_srli_epi64(x, 3), operand), _mm256_set1_epi64x(SMI_TAG));
+    }
+
+    int64_t horizontalSum(__m256i v) {
+        alignas(32) int64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+        return static_cast<int64_t>(static_cast<uint64_t>(lanes[0]) + static_cast<uint64_t>(lanes[1])
+                                    + static_cast<uint64_t>(lanes[2]) + static_cast<uint64_t>(lanes[3]));
+    }
+#endif
+
+    template<Arith kOp>
+    void arithScalarImpl(TaggedVal* vals, size_t size, uint64_t operand, bool simd) {
+        size_t i = 0;
+#ifdef __AVX2__
+        if (simd && LINEAR_KERNEL) {
+            const __m256i op = _mm256_set1_epi64x(static_cast<long long>(operand));
+            for (; i + 4 <= size; i += 4) {
+                const __m256i x = load(vals + i);
+                const __m256i smi = smiLanes(x);
+                // 非 Smi 通道保留原值；加减只需把这些通道的操作数清零
+                if constexpr (kOp == Arith::Mul) store(vals + i, _mm256_blendv_epi8(x, applyTagged<kOp>(x, op), smi));
+                else store(vals + i, applyTagged<kOp>(x, _mm256_and_si256(op, smi)));
+            }
+        }
+#else
+        (void)simd;
+#endif
+        arithScalarLoop<kOp>(vals, i, size, operand);
+    }
+
+    template<Arith kOp>
+    void arithArrayImpl(TaggedVal* dst, const TaggedVal* src, size_t size, bool simd) {
+        size_t i = 0;
+#ifdef __AVX2__
+        if (simd && LINEAR_KERNEL) {
+            const __m256i tag = _mm256_set1_epi64x(SMI_TAG);
+            for (; i + 4 <= size; i += 4) {
+                const __m256i x = load(dst + i);
+                const __m256i y = load(src + i);
+                const __m256i smi = _mm256_and_si256(smiLanes(x), smiLanes(y));
+                const __m256i operand = _mm256_sub_epi64(y, tag);
+                if constexpr (kOp == Arith::Mul) store(dst + i, _mm256_blendv_epi8(x, applyTagged<kOp>(x, operand), smi));
+                else store(dst + i, applyTagged<kOp>(x, _mm256_and_si256(operand, smi)));
+            }
+        }
+#else
+        (void)simd;
+#endif
+        arithArrayLoop<kOp>(dst, src, i, size);
+    }
+
+    int64_t sumImpl(const TaggedVal* vals, size_t size, bool simd) {
+        uint64_t sum = 0;
+        size_t i = 0;
+#ifdef __AVX2__
+        if (simd && LINEAR_KERNEL) {
+            // 逻辑右移后负数少了 2^61，单独统计负数个数再补回
+            const __m256i zero = _mm256_setzero_si256();
+            __m256i acc[2] = {zero, zero};
+            __m256i negatives[2] = {zero, zero};
+            // 两组累加器交替使用，缩短加法依赖链
+            for (; i + 8 <= size; i += 8) {
+                for (int k = 0; k < 2; ++k) {
+                    const __m256i x = load(vals + i + 4 * k);
+                    const __m256i smi = smiLanes(x);
+                    acc[k] = _mm256_add_epi64(acc[k], _mm256_and_si256(_mm256_srli_epi64(x, 3), smi));
+                    negatives[k] = _mm256_add_epi64(negatives[k], _mm256_and_si256(_mm256_cmpgt_epi64(zero, x), smi));
+                }
+            }
+            sum = static_cast<uint64_t>(horizontalSum(_mm256_add_epi64(acc[0], acc[1])))
+                  + (static_cast<uint64_t>(horizontalSum(_mm256_add_epi64(negatives[0], negatives[1]))) << 61);
+        }
+#else
+        (void)simd;
+#endif
+        for (; i < size; ++i) {
+            if (isSmi(vals[i])) sum += static_cast<uint64_t>(TaggedUtil::decode_Smi(vals[i]));
+        }
+        return static_cast<int64_t>(sum);
+    }
+
+    // Smi 编码保序，直接比较标记值
+    template<Reduce kOp>
+    int64_t extremumImpl(const TaggedVal* vals, size_t size, bool simd) {
+        constexpr bool kMin = kOp == Reduce::Min;
+        TaggedVal best = kMin ? LLONG_MAX : LLONG_MIN;
+        bool found = false;
+        size_t i = 0;
+#ifdef __AVX2__
+        if (simd && size >= 4) {
+            const __m256i identity = _mm256_set1_epi64x(best);
+            __m256i acc = identity;
+            __m256i seen = _mm256_setzero_si256();
+            for (; i + 4 <= size; i += 4) {
+                const __m256i x = load(vals + i);
+                const __m256i smi = smiLanes(x);
+                const __m256i cur = _mm256_blendv_epi8(identity, x, smi);
+                const __m256i better = kMin ? _mm256_cmpgt_epi64(acc, cur) : _mm256_cmpgt_epi64(cur, acc);
+                acc = _mm256_blendv_epi8(acc, cur, better);
+                seen = _mm256_or_si256(seen, smi);
+            }
+            alignas(32) TaggedVal lanes[4];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+            const int seen_mask = laneMask(seen);
+            for (int lane = 0; lane < 4; ++lane) {
+                if (!(seen_mask & (1 << lane))) continue;
+                best = kMin ? std::min(best, lanes[lane]) : std::max(best, lanes[lane]);
+                found = true;
+            }
+        }
+#else
+        (void)simd;
+#endif
+        for (; i < size; ++i) {
+            if (!isSmi(vals[i])) continue;
+            best = kMin ? std::min(best, vals[i]) : std::max(best, vals[i]);
+            found = true;
+        }
+        return found ? TaggedUtil::decode_Smi(best) : 0;
+    }
+}
+
+void ArrayOps::fill(TaggedVal* vals, size_t size, int64_t value, bool simd) {
+    const TaggedVal tagged = TaggedUtil::encode_Smi(value);
+    size_t i = 0;
+#ifdef __AVX2__
+    if (simd) {
+        const __m256i fill = _mm256_set1_epi64x(tagged);
+        const __m256i tag_mask = _mm256_set1_epi64x(TAG_MASK);
+        for (; i + 4 <= size; i += 4) {
+            const __m256i x = load(vals + i);
+            // 被覆盖的堆对象需要释放引用，这种块很少见，逐个处理
+            if (laneMask(_mm256_cmpeq_epi64(_mm256_and_si256(x, tag_mask), _mm256_setzero_si256()))) [[unlikely]] {
+                for (size_t k = i; k < i + 4; ++k) release(vals[k]);
+            }
+            store(vals + i, fill);
+        }
+    }
+#else
+    (void)simd;
+#endif
+    for (; i < size; ++i) {
+        release(vals[i]);
+        vals[i] = tagged;
+    }
+}
+
+void ArrayOps::arithScalar(Arith op, TaggedVal* vals, size_t size, int64_t value, bool simd) {
+    const uint64_t operand = static_cast<uint64_t>(value) << 3;
+    switch (op) {
+        case Arith::Add: arithScalarImpl<Arith::Add>(vals, size, operand, simd); break;
+        case Arith::Sub: arithScalarImpl<Arith::Sub>(vals, size, operand, simd); break;
+        case Arith::Mul: arithScalarImpl<Arith::Mul>(vals, size, operand, simd); break;
+    }
+}
+
+void ArrayOps::arithArray(Arith op, TaggedVal* dst, const TaggedVal* src, size_t size, bool simd) {
+    switch (op) {
+        case Arith::Add: arithArrayImpl<Arith::Add>(dst, src, size, simd); break;
+        case Arith::Sub: arithArrayImpl<Arith::Sub>(dst, src, size, simd); break;
+        case Arith::Mul: arithArrayImpl<Arith::Mul>(dst, src, size, simd); break;
+    }
+}
+
+int64_t ArrayOps::reduce(Reduce op, const TaggedVal* vals, size_t size, bool simd) {
+    switch (op) {
+        case Reduce::Sum: return sumImpl(vals, size, simd);
+        case Reduce::Min: return extremumImpl<Reduce::Min>(vals, size, simd);
+        case Reduce::Max: return extremumImpl<Reduce::Max>(vals, size, simd);
+    }
+    return 0;
+}
+
+int64_t ArrayOps::find(const TaggedVal* vals, size_t size, int64_t value, bool simd) {
+    // 非 Smi 元素的标记不同，不可能与目标相等
+    const TaggedVal target = TaggedUtil::encode_Smi(value);
+    size_t i = 0;
+#ifdef __AVX2__
+    if (simd) {
+        const __m256i needle = _mm256_set1_epi64x(target);
+        for (; i + 4 <= size; i += 4) {
+            if (const int hit = laneMask(_mm256_cmpeq_epi64(load(vals + i), needle))) {
+                return static_cast<int64_t>(i) + std::countr_zero(static_cast<unsigned>(hit));
+            }
+        }
+    }
+#else
+    (void)simd;
+#endif
+    for (; i < size; ++i) {
+        if (vals[i] == target) return static_cast<int64_t>(i);
+    }
+    return -1;
+}
+
+int64_t ArrayOps::mismatch(const TaggedVal* left, size_t left_size, const TaggedVal* right, size_t right_size,
+                           bool simd) {
+    const size_t size = std::min(left_size, right_size);
+    size_t i = 0;
+#ifdef __AVX2__
+    if (simd) {
+        for (; i + 4 <= size; i += 4) {
+            const int equal = laneMask(_mm256_cmpeq_epi64(load(left + i), load(right + i)));
+            if (equal != 0xF) {
+                return static_cast<int64_t>(i) + std::countr_zero(static_cast<unsigned>(~equal));
+            }
+        }
+    }
+#else
+    (void)simd;
+#endif
+    for (; i < size; ++i) {
+        if (left[i] != right[i]) return static_cast<int64_t>(i);
+    }
+    return left_size == right_size ? -1 : static_cast<int64_t>(size);
+}
+
+void ArrayOps::vmCallArrayNew() {
+    RegisterVM::vm_call_handlers[13] = [](const OpCodeImpl::Instruction*) {
+        RegisterVM* vm = Handler::current_vm;
+        if (!vm) return;
+
+        const int64_t size = vm->registers[9];
+        if (size < 0) {
+            vm->registers[0] = -1;
+            return;
+        }
+        auto* arr = new LmArray();
+        arr->resize(static_cast<size_t>(size), TaggedUtil::encode_Smi(vm->registers[10]));
+        vm->registers[0] = static_cast<int64_t>(vm->allocOnHeap(arr));
+    };
+}
+
+void ArrayOps::vmCallTypedArrayNew() {
+    RegisterVM::vm_call_handlers[14] = [](const OpCodeImpl::Instruction*) {
+        RegisterVM* vm = Handler::current_vm;
+        if (!vm) return;
+
+        const int64_t length = vm->registers[9];
+        const int64_t kind = vm->registers[10];
+        if (length < 0 || static_cast<uint64_t>(length) > SIZE_MAX / 8 || kind < 0 || kind >= LmTypedArray::KIND_COUNT) {
+            vm->registers[0] = -1;
+            return;
+        }
+        auto* arr = new LmTypedArray(LmTypedArray::type_of(kind), static_cast<size_t>(length));
+        vm->registers[0] = static_cast<int64_t>(vm->allocOnHeap(arr));
+    };
+}
@@ -0,0 +1,107 @@
+/******************************************************
+-     Date:  2026.10.23 09:30
+-     File:  array_ops.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include "models.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 批量数组指令的计算内核
+ * 直接在带标记的 Smi 上运算：加减用 x ± (v << 3)，乘法用 (x >> 3) * (v << 3) + 1，
+ * 结果与逐个解码、运算、编码相同（按补码回绕）。非 Smi 元素保持不变、不参与归约；
+ * 编译目标支持 AVX2 时每次处理 4 个元素，否则退回标量循环
+ */
+class ArrayOps {
+public:
+    enum class Arith : uint8_t { Add, Sub, Mul };
+    enum class Reduce : uint8_t { Sum, Min, Max };
+
+    // 是否编译了 AVX2 内核
+#ifdef __AVX2__
+    static constexpr bool SIMD = true;
+#else
+    static constexpr bool SIMD = false;
+#endif
+
+    /**
+     * 全部元素置为 Smi value，被覆盖的堆对象元素释放引用
+     * @param vals
+     * @param size
+     * @param value
+     * @param simd 为 false 时强制走标量路径
+     * @return void
+     */
+    static void fill(TaggedVal* vals, size_t size, int64_t value, bool simd = SIMD);
+
+    /**
+     * 每个 Smi 元素与标量运算
+     * @param op
+     * @param vals
+     * @param size
+     * @param value
+     * @param simd
+     * @return void
+     */
+    static void arithScalar(Arith op, TaggedVal* vals, size_t size, int64_t value, bool simd = SIMD);
+
+    /**
+     * dst[i] = dst[i] op src[i]，两侧都是 Smi 时才运算；dst 与 src 可以相同
+     * @param op
+     * @param dst
+     * @param src
+     * @param size
+     * @param simd
+     * @return void
+     */
+    static void arithArray(Arith op, TaggedVal* dst, const TaggedVal* src, size_t size, bool simd = SIMD);
+
+    /**
+     * 对 Smi 元素求和/最小值/最大值，没有 Smi 元素时返回 0
+     * @param op
+     * @param vals
+     * @param size
+     * @param simd
+     * @return int64_t
+     */
+    static int64_t reduce(Reduce op, const TaggedVal* vals, size_t size, bool simd = SIMD);
+
+    /**
+     * 第一个等于 Smi value 的元素下标，没有时返回 -1
+     * @param vals
+     * @param size
+     * @param value
+     * @param simd
+     * @return int64_t
+     */
+    static int64_t find(const TaggedVal* vals, size_t size, int64_t value, bool simd = SIMD);
+
+    /**
+     * 第一个不同元素的下标，一方是另一方的前缀时为较短的长度，完全相同时返回 -1
+     * 元素按标记值比较，堆对象比较的是同一性
+     * @param left
+     * @param left_size
+     * @param right
+     * @param right_size
+     * @param simd
+     * @return int64_t
+     */
+    static int64_t mismatch(const TaggedVal* left, size_t left_size, const TaggedVal* right, size_t right_size,
+                            bool simd = SIMD);
+
+    /**
+     * 注册 VMCALL 13：新建数组，r9 为长度、r10 为初始值，地址写入 r0，长度为负时 r0 = -1
+     * @return void
+     */
+    static void vmCallArrayNew();
+
+    /**
+     * 注册 VMCALL 14：新建清零的紧凑数组，r9 为长度、r10 为种类（0 int8 / 1 int32 / 2 int64 / 3 f64），
+     * 地址写入 r0，长度为负或种类未知时 r0 = -1
+     * @return void
+     */
+    static void vmCallTypedArrayNew();
+};
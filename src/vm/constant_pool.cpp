@@ -0,0 +1,122 @@
+/******************************************************
+-     Date:  2026.10.27 09:40
+-     File:  constant_pool.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "constant_pool.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    // 每个常量至少有类型与长度
+    constexpr size_t ENTRY_HEADER = sizeof(uint8_t) + sizeof(uint32_t);
+
+    template<typename T>
+    void append(std::vector<uint8_t>& out, T value) {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    template<typename T>
+    T read(const uint8_t* data, size_t size, size_t& pos) {
+        if (size - pos < sizeof(T)) throw std::runtime_error("truncated constant pool");
+        T value;
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    LmHeapObject* decodeString(const uint8_t* bytes, size_t length) {
+        if (std::memchr(bytes, 0, length) != nullptr) throw std::runtime_error("string constant contains NUL");
+        const std::string text(reinterpret_cast<const char*>(bytes), length);
+        return new LmString(text.c_str());
+    }
+
+    LmHeapObject* decodeBigint(const uint8_t* bytes, size_t length) {
+        if (length == 0 || (length - 1) % sizeof(uint32_t) != 0 || bytes[0] > 1) {
+            throw std::runtime_error("malformed bigint constant");
+        }
+        std::vector<uint64_t> vals((length - 1) / sizeof(uint32_t));
+        for (size_t i = 0; i < vals.size(); ++i) {
+            uint32_t limb;
+            std::memcpy(&limb, bytes + 1 + i * sizeof(limb), sizeof(limb));
+            vals[i] = limb;
+        }
+        return new LmBigint(vals, bytes[0] == 1);
+    }
+
+    LmHeapObject* decodeTyped(HeapObjType type, const uint8_t* bytes, size_t length) {
+        const size_t width = LmTypedArray::element_width(type);
+        if (length % width != 0) throw std::runtime_error("typed array constant is not a whole number of elements");
+        auto* arr = new LmTypedArray(type, length / width);
+        if (length > 0) std::memcpy(arr->data(), bytes, length);
+        return arr;
+    }
+}
+
+ConstantPool::~ConstantPool() {
+    // 固定的对象不经过引用计数，直接释放
+    for (auto* obj : constants_) delete obj;
+}
+
+size_t ConstantPool::add(LmHeapObject* obj) {
+    const HeapObjType type = obj->get_type();
+    if (type != HeapObjType::String && type != HeapObjType::Bigint && !LmTypedArray::is_typed(type)) {
+        delete obj;
+        throw std::runtime_error("unsupported constant type: " + std::to_string(static_cast<int>(type)));
+    }
+    // 字符串的哈希在首次使用时才写入缓存；常量被多个虚拟机的线程共享，共享前先算好，之后只读
+    if (type == HeapObjType::String) (void)static_cast<const LmString*>(obj)->hash();
+    obj->pin();
+    constants_.push_back(obj);
+    return constants_.size() - 1;
+}
+
+std::vector<uint8_t> ConstantPool::encode() const {
+    std::vector<uint8_t> out;
+    append<uint32_t>(out, static_cast<uint32_t>(constants_.size()));
+    for (const auto* obj : constants_) {
+        append<uint8_t>(out, static_cast<uint8_t>(obj->get_type()));
+        const size_t length_at = out.size();
+        append<uint32_t>(out, 0);
+        if (obj->get_type() == HeapObjType::String) {
+            const auto* str = static_cast<const LmString*>(obj);
+            out.insert(out.end(), str->get_utf8_data(), str->get_utf8_data() + str->byte_len());
+        } else if (obj->get_type() == HeapObjType::Bigint) {
+            const auto* big = static_cast<const LmBigint*>(obj);
+            out.push_back(big->is_neg() ? 1 : 0);
+            for (uint64_t limb : big->get_vals()) append<uint32_t>(out, static_cast<uint32_t>(limb));
+        } else {
+            const auto* arr = static_cast<const LmTypedArray*>(obj);
+            out.insert(out.end(), arr->data(), arr->data() + arr->get_size());
+        }
+        const auto length = static_cast<uint32_t>(out.size() - length_at - sizeof(uint32_t));
+        std::memcpy(out.data() + length_at, &length, sizeof(length));
+    }
+    return out;
+}
+
+std::shared_ptr<const ConstantPool> ConstantPool::decode(const uint8_t* data, size_t size) {
+    auto pool = std::make_shared<ConstantPool>();
+    if (size == 0) return pool;
+    size_t pos = 0;
+    const auto count = read<uint32_t>(data, size, pos);
+    // 常量数来自文件，先按剩余长度挡住伪造的计数
+    if (count > (size - pos) / ENTRY_HEADER) throw std::runtime_error("truncated constant pool");
+    pool->constants_.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const auto type = static_cast<HeapObjType>(read<uint8_t>(data, size, pos));
+        const auto length = read<uint32_t>(data, size, pos);
+        if (size - pos < length) throw std::runtime_error("truncated constant pool");
+        const uint8_t* bytes = data + pos;
+        pos += length;
+        if (type == HeapObjType::String) pool->add(decodeString(bytes, length));
+        else if (type == HeapObjType::Bigint) pool->add(decodeBigint(bytes, length));
+        else if (LmTypedArray::is_typed(type)) pool->add(decodeTyped(type, bytes, length));
+        else throw std::runtime_error("unsupported constant type: " + std::to_string(static_cast<int>(type)));
+    }
+    if (pos != size) throw std::runtime_error("trailing bytes after constant pool");
+    return pool;
+}
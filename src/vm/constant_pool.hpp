@@ -0,0 +1,72 @@
+/******************************************************
+-     Date:  2026.10.27 09:40
+-     File:  constant_pool.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include "models.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * 只读常量池：字符串、大整数与紧凑数组，由镜像数据段末尾解析得到，LDC 按下标取用
+ * 常量在加入时被固定（LmHeapObject::pin），引用计数不再变化，同一个池可以被运行同一镜像的多个虚拟机共享；
+ * 常量由池直接释放，紧凑数组常量不能被 STI/STX 写入
+ *
+ * 编码：uint32 常量数，随后每个常量一个 uint8 对象类型、uint32 字节数与内容
+ *  String                       UTF-8 字节，不含 NUL
+ *  Bigint                       uint8 符号（1 为负），随后每 32 位一个 uint32，低位在前
+ *  Int8/Int32/Int64/Float64Array 元素字节，按宿主字节序
+ */
+class ConstantPool {
+public:
+    ConstantPool() = default;
+
+    /**
+     * 析构函数，释放全部常量
+     */
+    ~ConstantPool();
+
+    ConstantPool(const ConstantPool&) = delete;
+    ConstantPool& operator=(const ConstantPool&) = delete;
+
+    /**
+     * 加入常量并接管其所有权，类型不受支持时释放对象并抛出 std::runtime_error
+     * @param obj
+     * @return size_t 常量下标
+     */
+    size_t add(LmHeapObject* obj);
+
+    /**
+     * 取常量，index 必须小于 size()
+     * @param index
+     * @return LmHeapObject*
+     */
+    [[nodiscard]] LmHeapObject* at(size_t index) const { return constants_[index]; }
+
+    /**
+     * 常量个数
+     * @return size_t
+     */
+    [[nodiscard]] size_t size() const { return constants_.size(); }
+
+    /**
+     * 编码为数据段中的常量池
+     * @return std::vector<uint8_t>
+     */
+    [[nodiscard]] std::vector<uint8_t> encode() const;
+
+    /**
+     * 解析常量池，格式错误时抛出 std::runtime_error
+     * @param data
+     * @param size
+     * @return std::shared_ptr<const ConstantPool>
+     */
+    static std::shared_ptr<const ConstantPool> decode(const uint8_t* data, size_t size);
+
+private:
+    std::vector<LmHeapObject*> constants_;
+};
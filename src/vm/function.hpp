@@ -0,0 +1,69 @@
+/******************************************************
+-     Date:  2026.10.25 09:30
+-     File:  function.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include "models.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * 函数对象：代码对象加上创建时捕获的值，值为寄存器中的原始 64 位
+ * 同一函数的所有函数对象共用一个 CodeType::Function 的代码对象
+ */
+class LmFunction : public LmHeapObject {
+public:
+    /**
+     * 构造函数，增加代码对象的引用
+     * @param code
+     * @param captures
+     */
+    LmFunction(LmCodeObject* code, std::vector<int64_t> captures)
+        : LmHeapObject(HeapObjType::Function), code_(code), captures_(std::move(captures)) {
+        code_->make_ref();
+    }
+
+    /**
+     * 析构函数，释放代码对象的引用
+     */
+    ~LmFunction() override { code_->del_ref(); }
+
+    LmFunction(const LmFunction&) = delete;
+    LmFunction& operator=(const LmFunction&) = delete;
+
+    /**
+     * 获取代码对象
+     * @return const LmCodeObject*
+     */
+    [[nodiscard]] const LmCodeObject* code() const { return code_; }
+
+    /**
+     * 捕获值
+     * @return const int64_t*
+     */
+    [[nodiscard]] const int64_t* captures() const { return captures_.data(); }
+
+    /**
+     * 捕获值个数
+     * @return size_t
+     */
+    [[nodiscard]] size_t capture_count() const { return captures_.size(); }
+
+private:
+    LmCodeObject* code_;
+    std::vector<int64_t> captures_;
+};
+
+/**
+ * CALLR 的调用点缓存（单态），记住上一次调用的函数对象及其函数下标
+ * 缓存持有函数对象的引用，对象不会被释放，地址也就不会被新对象复用，命中时比较指针与捕获值起始寄存器
+ */
+struct CallCache {
+    LmFunction* function = nullptr;
+    size_t index = 0;
+    int64_t base = -1; // 检查过的捕获值起始寄存器（CALLR 的 imm）
+};
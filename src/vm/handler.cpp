@@ -18,5 +18,18 @@ void Handler::vmCallTable(RegisterVM& vm) {
     HandlerFunction<0>::func();
     HandlerFunction<1>::func();
     HandlerFunction<2>::func();
+    HandlerFunction<3>::func();
+    HandlerFunction<4>::func();
+    HandlerFunction<5>::func();
+    HandlerFunction<6>::func();
+    HandlerFunction<7>::func();
+    HandlerFunction<8>::func();
+    HandlerFunction<9>::func();
+    HandlerFunction<10>::func();
+    HandlerFunction<11>::func();
+    HandlerFunction<12>::func();
+    HandlerFunction<13>::func();
+    HandlerFunction<14>::func();
+    HandlerFunction<15>::func();
 
 }
\ No newline at end of file
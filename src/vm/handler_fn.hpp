@@ -7,6 +7,9 @@
 #pragma once
 #include "handler.hpp"
 #include "../vmcall/console_io.hpp"
+#include "../vmcall/file_io.hpp"
+#include "../vmcall/heap_ops.hpp"
+#include "array_ops.hpp"
 template<size_t>
 struct HandlerFunction {
     static void (*func)();
@@ -27,9 +30,74 @@ struct HandlerFunction<2> {
     static void func() { ConsoleIO::vmCallExit(); }
 };
 
+template<>
+struct HandlerFunction<3> {
+    static void func() { FileIO::vmCallOpen(); }
+};
+
+template<>
+struct HandlerFunction<4> {
+    static void func() { FileIO::vmCallClose(); }
+};
+
+template<>
+struct HandlerFunction<5> {
+    static void func() { FileIO::vmCallRead(); }
+};
+
+template<>
+struct HandlerFunction<6> {
+    static void func() { FileIO::vmCallWrite(); }
+};
+
+template<>
+struct HandlerFunction<7> {
+    static void func() { FileIO::vmCallSeek(); }
+};
+
+template<>
+struct HandlerFunction<8> {
+    static void func() { FileIO::vmCallAsyncRead(); }
+};
+
+template<>
+struct HandlerFunction<9> {
+    static void func() { FileIO::vmCallAwait(); }
+};
+
+template<>
+struct HandlerFunction<10> {
+    static void func() { FileIO::vmCallBufferNew(); }
+};
+
+template<>
+struct HandlerFunction<11> {
+    static void func() { ConsoleIO::vmCallReadChunk(); }
+};
+
+template<>
+struct HandlerFunction<12> {
+    static void func() { ConsoleIO::vmCallReadLines(); }
+};
+
+template<>
+struct HandlerFunction<13> {
+    static void func() { ArrayOps::vmCallArrayNew(); }
+};
+
+template<>
+struct HandlerFunction<14> {
+    static void func() { ArrayOps::vmCallTypedArrayNew(); }
+};
+
+template<>
+struct HandlerFunction<15> {
+    static void func() { HeapOps::vmCallRelease(); }
+};
+
 class HandlerFn : public Handler {
 public:
-    static constexpr size_t HANDLER_COUNT = 3;
+    static constexpr size_t HANDLER_COUNT = 16;
 
     template<size_t N>
     static void callHandler();
@@ -0,0 +1,194 @@
+/******************************************************
+-     Date:  2026.10.24 10:00
+-     File:  hash_map.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "hash_map.hpp"
+#include <bit>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr int8_t EMPTY = -128;  // 0b10000000
+    constexpr int8_t DELETED = -2;  // 0b11111110
+
+    // murmur3 的 fmix64，Smi 与字符串哈希都要经过它，h1/h2 的各位才足够均匀
+    uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    size_t h1(uint64_t hash) { return static_cast<size_t>(hash >> 7); }
+    int8_t h2(uint64_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+
+    // 组内匹配结果，第 i 位对应组内第 i 个槽位
+#ifdef __SSE2__
+    uint32_t matchByte(const int8_t* group, int8_t byte) {
+        const __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(byte))));
+    }
+
+    // 空槽与墓碑的最高位都是 1
+    uint32_t matchFree(const int8_t* group) {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group))));
+    }
+#else
+    uint32_t matchByte(const int8_t* group, int8_t byte) {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < LmMap::GROUP; ++i) mask |= static_cast<uint32_t>(group[i] == byte) << i;
+        return mask;
+    }
+
+    uint32_t matchFree(const int8_t* group) {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < LmMap::GROUP; ++i) mask |= static_cast<uint32_t>(group[i] < 0) << i;
+        return mask;
+    }
+#endif
+
+    bool isString(TaggedVal key) {
+        return TaggedUtil::is_HeapObject(key) && TaggedUtil::decode_HeapObject(key)->get_type() == HeapObjType::String;
+    }
+
+    const LmString* asString(TaggedVal key) { return static_cast<const LmString*>(TaggedUtil::decode_HeapObject(key)); }
+
+    // 负载上限 7/8
+    size_t maxLoad(size_t capacity) { return capacity - capacity / 8; }
+}
+
+LmMap::LmMap(size_t capacity_hint)
+    : LmHeapObject(HeapObjType::Map), ctrl_(nullptr), slots_(nullptr), capacity_(0), size_(0), growth_left_(0) {
+    size_t capacity = GROUP;
+    while (maxLoad(capacity) < capacity_hint) capacity *= 2;
+    rehash(capacity);
+}
+
+LmMap::~LmMap() {
+    for (size_t i = 0; i < capacity_; ++i) {
+        if (ctrl_[i] >= 0 && TaggedUtil::is_HeapObject(slots_[i].key)) TaggedUtil::decode_HeapObject(slots_[i].key)->del_ref();
+    }
+    delete[] ctrl_;
+    delete[] slots_;
+}
+
+bool LmMap::is_key(TaggedVal key) {
+    return TaggedUtil::get_tagged_type(key) == TaggedType::Smi || isString(key);
+}
+
+uint64_t LmMap::hash_of(TaggedVal key) {
+    return mix(TaggedUtil::is_HeapObject(key) ? asString(key)->hash() : static_cast<uint64_t>(key));
+}
+
+bool LmMap::key_equals(TaggedVal a, TaggedVal b) {
+    if (a == b) return true;
+    if (!TaggedUtil::is_HeapObject(a) || !TaggedUtil::is_HeapObject(b)) return false;
+    const LmString* left = asString(a);
+    const LmString* right = asString(b);
+    return left->hash() == right->hash() && left->equals(right);
+}
+
+size_t LmMap::find_slot(TaggedVal key, uint64_t hash) const {
+    const size_t group_mask = capacity_ / GROUP - 1;
+    const int8_t tag = h2(hash);
+    size_t group = h1(hash) & group_mask;
+#ifdef __GNUC__
+    // 控制字节与槽位通常都不在缓存中，同时取
+    __builtin_prefetch(slots_ + group * GROUP);
+#endif
+    for (size_t step = 1;; ++step) {
+        const int8_t* ctrl = ctrl_ + group * GROUP;
+        for (uint32_t match = matchByte(ctrl, tag); match != 0; match &= match - 1) {
+            const size_t slot = group * GROUP + static_cast<size_t>(std::countr_zero(match));
+            if (key_equals(slots_[slot].key, key)) [[likely]] return slot;
+        }
+        // 组内有空槽说明键不在表中
+        if (matchByte(ctrl, EMPTY) != 0) return capacity_;
+        group = (group + step) & group_mask;
+    }
+}
+
+size_t LmMap::find_free(uint64_t hash) const {
+    const size_t group_mask = capacity_ / GROUP - 1;
+    size_t group = h1(hash) & group_mask;
+    for (size_t step = 1;; ++step) {
+        const uint32_t match = matchFree(ctrl_ + group * GROUP);
+        if (match != 0) return group * GROUP + static_cast<size_t>(std::countr_zero(match));
+        group = (group + step) & group_mask;
+    }
+}
+
+const int64_t* LmMap::find(TaggedVal key) const {
+    const size_t slot = find_slot(key, hash_of(key));
+    return slot != capacity_ ? &slots_[slot].value : nullptr;
+}
+
+void LmMap::put(TaggedVal key, int64_t value) {
+    const uint64_t hash = hash_of(key);
+    const size_t found = find_slot(key, hash);
+    if (found != capacity_) {
+        slots_[found].value = value;
+        return;
+    }
+    size_t slot = find_free(hash);
+    if (ctrl_[slot] == EMPTY && growth_left_ == 0) {
+        // 墓碑占了一半以上时原地清理，否则扩容
+        rehash(size_ * 2 < maxLoad(capacity_) ? capacity_ : capacity_ * 2);
+        slot = find_free(hash);
+    }
+    if (ctrl_[slot] == EMPTY) --growth_left_;
+    ctrl_[slot] = h2(hash);
+    slots_[slot] = {key, value};
+    ++size_;
+    if (TaggedUtil::is_HeapObject(key)) TaggedUtil::decode_HeapObject(key)->make_ref();
+}
+
+bool LmMap::erase(TaggedVal key) {
+    const size_t slot = find_slot(key, hash_of(key));
+    if (slot == capacity_) return false;
+    if (TaggedUtil::is_HeapObject(slots_[slot].key)) TaggedUtil::decode_HeapObject(slots_[slot].key)->del_ref();
+    // 组按 GROUP 对齐：组内已有空槽时，经过这一组的探测本来就会停在这里，可以直接置空
+    if (matchByte(ctrl_ + slot / GROUP * GROUP, EMPTY) != 0) {
+        ctrl_[slot] = EMPTY;
+        ++growth_left_;
+    } else {
+        ctrl_[slot] = DELETED;
+    }
+    --size_;
+    return true;
+}
+
+size_t LmMap::next(size_t cursor) const {
+    for (size_t slot = cursor; slot < capacity_; ++slot) {
+        if (ctrl_[slot] >= 0) return slot;
+    }
+    return capacity_;
+}
+
+void LmMap::rehash(size_t capacity) {
+    int8_t* old_ctrl = ctrl_;
+    Slot* old_slots = slots_;
+    const size_t old_capacity = capacity_;
+
+    ctrl_ = new int8_t[capacity];
+    slots_ = new Slot[capacity];
+    capacity_ = capacity;
+    std::memset(ctrl_, EMPTY, capacity);
+    for (size_t i = 0; i < old_capacity; ++i) {
+        if (old_ctrl[i] < 0) continue;
+        const uint64_t hash = hash_of(old_slots[i].key);
+        const size_t slot = find_free(hash);
+        ctrl_[slot] = h2(hash);
+        slots_[slot] = old_slots[i];
+    }
+    growth_left_ = maxLoad(capacity) - size_;
+    delete[] old_ctrl;
+    delete[] old_slots;
+}
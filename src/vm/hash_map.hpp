@@ -0,0 +1,155 @@
+/******************************************************
+-     Date:  2026.10.24 10:00
+-     File:  hash_map.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include "models.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * SwissTable 风格的开放寻址哈希表，键为 Smi 或 LmString 的 TaggedVal，值为寄存器中的原始 64 位
+ * 每个槽位有一个控制字节：最高位为 1 表示空槽或墓碑，否则低 7 位是哈希的 h2；
+ * 槽位按 16 个一组，哈希的 h1 选起始组，组间按三角数探测。
+ * 编译目标支持 SSE2 时一次比较整组控制字节，否则退回逐字节比较。
+ * 字符串键按内容比较：先比较指针，再比较 LmString 缓存的哈希，驻留的字符串只需比较指针
+ */
+class LmMap : public LmHeapObject {
+public:
+    static constexpr size_t GROUP = 16;
+
+    // 是否编译了 SSE2 分组探测
+#ifdef __SSE2__
+    static constexpr bool SIMD = true;
+#else
+    static constexpr bool SIMD = false;
+#endif
+
+    /**
+     * 构造函数
+     * @param capacity_hint 预计元素个数，插入这么多元素前不会扩容
+     */
+    explicit LmMap(size_t capacity_hint = 0);
+
+    /**
+     * 析构函数，释放对字符串键的引用
+     */
+    ~LmMap() override;
+
+    LmMap(const LmMap&) = delete;
+    LmMap& operator=(const LmMap&) = delete;
+
+    /**
+     * 查找，键不存在时返回 nullptr
+     * @param key
+     * @return const int64_t*
+     */
+    [[nodiscard]] const int64_t* find(TaggedVal key) const;
+
+    /**
+     * 插入或覆盖，新插入的字符串键增加引用
+     * @param key 必须满足 is_key
+     * @param value
+     * @return void
+     */
+    void put(TaggedVal key, int64_t value);
+
+    /**
+     * 删除，返回键是否存在
+     * @param key
+     * @return bool
+     */
+    bool erase(TaggedVal key);
+
+    /**
+     * 从槽位 cursor 起的下一个元素所在槽位，没有时返回 capacity()
+     * 迭代期间删除元素不影响其余元素，插入可能触发重排
+     * @param cursor
+     * @return size_t
+     */
+    [[nodiscard]] size_t next(size_t cursor) const;
+
+    /**
+     * 槽位上的键，slot 必须来自 next
+     * @param slot
+     * @return TaggedVal
+     */
+    [[nodiscard]] TaggedVal key_at(size_t slot) const { return slots_[slot].key; }
+
+    /**
+     * 槽位上的值，slot 必须来自 next
+     * @param slot
+     * @return int64_t
+     */
+    [[nodiscard]] int64_t value_at(size_t slot) const { return slots_[slot].value; }
+
+    /**
+     * 元素个数
+     * @return size_t
+     */
+    [[nodiscard]] size_t size() const { return size_; }
+
+    /**
+     * 槽位个数
+     * @return size_t
+     */
+    [[nodiscard]] size_t capacity() const { return capacity_; }
+
+    /**
+     * 是否可以作为键：Smi 或字符串
+     * @param key
+     * @return bool
+     */
+    static bool is_key(TaggedVal key);
+
+    /**
+     * 键的哈希，字符串取缓存的内容哈希
+     * @param key
+     * @return uint64_t
+     */
+    static uint64_t hash_of(TaggedVal key);
+
+private:
+    struct Slot {
+        TaggedVal key;
+        int64_t value;
+    };
+
+    int8_t* ctrl_;       // 控制字节
+    Slot* slots_;        // 槽位
+    size_t capacity_;    // 槽位个数，GROUP 的 2 的幂倍
+    size_t size_;        // 元素个数
+    size_t growth_left_; // 还能占用的空槽数，保证探测总能遇到空槽
+
+    /**
+     * 查找键所在槽位，不存在时返回 capacity_
+     * @param key
+     * @param hash
+     * @return size_t
+     */
+    [[nodiscard]] size_t find_slot(TaggedVal key, uint64_t hash) const;
+
+    /**
+     * 探测序列上第一个空槽或墓碑
+     * @param hash
+     * @return size_t
+     */
+    [[nodiscard]] size_t find_free(uint64_t hash) const;
+
+    /**
+     * 按新容量重新放置所有元素，同时清掉墓碑
+     * @param capacity
+     * @return void
+     */
+    void rehash(size_t capacity);
+
+    /**
+     * 键是否相等
+     * @param a
+     * @param b
+     * @return bool
+     */
+    static bool key_equals(TaggedVal a, TaggedVal b);
+};
@@ -6,6 +6,7 @@
 ********************************************************/
 #include "models.hpp"
 #include <cassert>
+#include <cmath>
 
 TaggedVal TaggedUtil::encode_Smi(int64_t smi_val) {
     return (static_cast<TaggedVal>(smi_val) << 3) | static_cast<TaggedVal>(TaggedType::Smi);
@@ -34,11 +35,52 @@ bool TaggedUtil::is_HeapObject(TaggedVal val) {
     return get_tagged_type(val) == TaggedType::HeapObject;
 }
 
+namespace {
+    constexpr uint64_t SIGN_BIT = 1ULL << 63;
+    constexpr uint64_t LOW60 = (1ULL << 60) - 1;
+    constexpr uint64_t CANONICAL_NAN = 0x7FF8000000000000ULL;
+}
+
+TaggedVal TaggedUtil::encode_Double(double val) {
+    uint64_t bits;
+    std::memcpy(&bits, &val, sizeof(bits));
+    // 载荷只在尾数低 3 位的 NaN 去掉低位后会变成 Inf，统一为静默 NaN
+    if (std::isnan(val)) bits = CANONICAL_NAN;
+    const uint64_t top4 = (bits >> 59) & 0xF;
+    if (top4 == 0b0111 || top4 == 0b1000) {
+        return static_cast<TaggedVal>((bits & SIGN_BIT) | ((bits & LOW60) << 3) | static_cast<uint64_t>(TaggedType::Double));
+    }
+    return static_cast<TaggedVal>((bits & ~0b111ULL) | static_cast<uint64_t>(TaggedType::DoubleWide));
+}
+
+double TaggedUtil::decode_Double(TaggedVal val) {
+    assert(is_Double(val));
+    const auto v = static_cast<uint64_t>(val);
+    uint64_t bits;
+    if (get_tagged_type(val) == TaggedType::Double) {
+        const uint64_t low = (v >> 3) & LOW60;
+        const uint64_t top3 = (low >> 59) ? 0b011 : 0b100;
+        bits = (v & SIGN_BIT) | (top3 << 60) | low;
+    } else {
+        bits = v & ~0b111ULL;
+    }
+    double result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+bool TaggedUtil::is_Double(TaggedVal val) {
+    const TaggedType type = get_tagged_type(val);
+    return type == TaggedType::Double || type == TaggedType::DoubleWide;
+}
+
 void LmHeapObject::make_ref() {
+    if (ref_count_ == PINNED) return;
     ref_count_++;
 }
 
 void LmHeapObject::del_ref() {
+    if (ref_count_ == PINNED) return;
     ref_count_ --;
     if (ref_count_ == 0) delete this;
 }
@@ -49,6 +91,18 @@ bool LmString::equals(const LmString *other) const {
            && (std::strcmp(utf8_data_, other->utf8_data_) == 0);
 }
 
+uint64_t LmString::hash() const {
+    if (hash_ != 0) return hash_;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < byte_length_; ++i) {
+        h ^= static_cast<unsigned char>(utf8_data_[i]);
+        h *= 0x100000001b3ULL;
+    }
+    // 0 留作未计算的标记
+    hash_ = h != 0 ? h : 1;
+    return hash_;
+}
+
 LmString *LmString::concat(const LmString *other) const {
     if (other == nullptr) return new LmString(utf8_data_);
 
@@ -104,6 +158,11 @@ size_t LmCodeObject::get_machine_code_len() const {
     return machine_code_len_;
 }
 
+size_t LmCodeObject::get_func_index() const {
+    assert(code_type_ == CodeType::Function);
+    return func_index_;
+}
+
 void LmArray::push(TaggedVal val) {
     if (size_ >= capacity_) {
         capacity_ *= 2;
@@ -119,4 +178,47 @@ void LmArray::push(TaggedVal val) {
 TaggedVal LmArray::get(size_t idx) const {
     assert(idx < size_);
     return vals_[idx];
-}
\ No newline at end of file
+}
+
+void LmArray::resize(size_t size, TaggedVal val) {
+    for (size_t i = size; i < size_; ++i) {
+        if (TaggedUtil::is_HeapObject(vals_[i])) TaggedUtil::decode_HeapObject(vals_[i])->del_ref();
+    }
+    if (size > size_ && TaggedUtil::is_HeapObject(val)) {
+        for (size_t i = size_; i < size; ++i) TaggedUtil::decode_HeapObject(val)->make_ref();
+    }
+    vals_.resize(size, val);
+    size_ = size;
+    if (capacity_ < size) capacity_ = size;
+}
+
+void LmArray::assign(const TaggedVal* vals, size_t size) {
+    if (vals == vals_.data() && size == size_) return;
+    // 先增加新元素的引用，旧元素释放后新元素仍然有效
+    for (size_t i = 0; i < size; ++i) {
+        if (TaggedUtil::is_HeapObject(vals[i])) TaggedUtil::decode_HeapObject(vals[i])->make_ref();
+    }
+    for (TaggedVal val : vals_) {
+        if (TaggedUtil::is_HeapObject(val)) TaggedUtil::decode_HeapObject(val)->del_ref();
+    }
+    vals_.assign(vals, vals + size);
+    size_ = size;
+    if (capacity_ < size) capacity_ = size;
+}
+
+void LmBuffer::set_size(size_t size) {
+    size_ = size < capacity_ ? size : capacity_;
+}
+
+void LmBuffer::set_read_size(size_t size) {
+    if (get_type() == HeapObjType::Buffer) set_size(size);
+}
+
+void LmBuffer::reserve(size_t capacity) {
+    if (capacity <= capacity_) return;
+    auto* new_data = new uint8_t[capacity];
+    if (size_ > 0) std::memcpy(new_data, data_, size_);
+    delete[] data_;
+    data_ = new_data;
+    capacity_ = capacity;
+}
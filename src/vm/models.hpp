@@ -6,6 +6,7 @@
 ********************************************************/
 #pragma once
 
+#include <cstdint>
 #include <cstring>
 #include <vector>
 #include <memory>
@@ -19,6 +20,8 @@ enum class TaggedType : unsigned char {
     Smi = 0b001,
     Null = 0b010,
     BTrue = 0b011,
+    Double = 0b100,     // 指数在 [2^-127, 2^128) 内的 double，无损
+    DoubleWide = 0b110, // 其余 double（含 ±0、Inf、NaN），舍去尾数最低 3 位，NaN 统一为静默 NaN
     BFalse = 0b111
 };
 
@@ -67,6 +70,31 @@ public:
      * @return bool
      */
     static bool is_HeapObject(TaggedVal val);
+
+    /**
+     * 编码 double，不分配堆对象
+     * 指数最高 4 位为 0111 或 1000 时，指数最高 3 位可由第 4 位还原，去掉后整体左移 3 位放入标记（Double）；
+     * 其余值直接用尾数最低 3 位存放标记（DoubleWide），±0 与 Inf 仍是精确的，NaN 统一编码为静默 NaN（载荷不保留）。
+     * 绝对值在 [2^-127, 2^128) 之外的有限值（含非规格化数）会丢失尾数最低 3 位，相对误差小于 2^-49；
+     * 需要精确保存这类值时不要装箱，直接把位模式留在寄存器或紧凑数组（Float64Array）中
+     * @param val
+     * @return TaggedVal
+     */
+    static TaggedVal encode_Double(double val);
+
+    /**
+     * 解码 double
+     * @param val
+     * @return double
+     */
+    static double decode_Double(TaggedVal val);
+
+    /**
+     * 判断TaggedVal是否为 double
+     * @param val
+     * @return bool
+     */
+    static bool is_Double(TaggedVal val);
 };
 
 // 堆对象类型
@@ -76,7 +104,15 @@ enum class HeapObjType : unsigned char {
     Array,
     Function,
     String,
-    WeakRef
+    WeakRef,
+    Buffer,
+    // 定长元素的紧凑数组（LmTypedArray），元素按宿主字节序存放
+    Int8Array,
+    Int32Array,
+    Int64Array,
+    Float64Array,
+    Map, // 开放寻址哈希表（LmMap）
+    Record // 带隐藏类的记录（LmRecord）
 };
 
 class LmHeapObject {
@@ -115,7 +151,22 @@ public:
      * @return size_t
      */
     [[nodiscard]] size_t get_ref_count() const { return ref_count_; }
+
+    /**
+     * 固定对象：此后 make_ref/del_ref 不再改动引用计数，对象由持有者直接 delete
+     * 常量池中的常量被多个虚拟机共享，固定后各虚拟机之间不会争用计数
+     * @return void
+     */
+    void pin() { ref_count_ = PINNED; }
+
+    /**
+     * 是否已固定
+     * @return bool
+     */
+    [[nodiscard]] bool is_pinned() const { return ref_count_ == PINNED; }
 private:
+    static constexpr size_t PINNED = SIZE_MAX; // 固定对象的引用计数
+
     HeapObjType type_; // 指向堆对象类型
     size_t ref_count_; // 引用计数
 };
@@ -134,7 +185,8 @@ public:
         : LmHeapObject(HeapObjType::String),
           utf8_data_(nullptr),
           byte_length_(0),
-          char_length_(0)
+          char_length_(0),
+          hash_(0)
     {
         if (utf8_str == nullptr) utf8_str = "";
 
@@ -194,9 +246,16 @@ public:
      */
     LmString* concat(const LmString* other) const;
 
+    /**
+     * 内容的哈希（FNV-1a），首次调用时计算并缓存，字符串内容不可再修改
+     * @return uint64_t
+     */
+    [[nodiscard]] uint64_t hash() const;
+
 private:
     size_t byte_length_;
     size_t char_length_;    // 缓存 UTF-8 实际字符数（如 "你好" 字节数6，字符数2）
+    mutable uint64_t hash_; // 缓存的哈希，0 表示尚未计算；常量池中的字符串加入时已算好，共享后不再写入
 
     /**
      * 计算UTF-8字符串
@@ -211,7 +270,8 @@ class LmCodeObject : public LmHeapObject {
 public:
     enum class CodeType { // 代码类型
         Bytecode,
-        MachineCode
+        MachineCode,
+        Function // 虚拟机 FuncLists 中的函数，只记录下标
     };
 
 private:
@@ -222,6 +282,7 @@ private:
     void* machine_code_addr_; // 指向机器码地址
     size_t machine_code_len_; // 机器码长度
     size_t size_; // 代码大小
+    size_t func_index_ = 0; // FuncLists 中的下标
 
 public:
     /**
@@ -244,6 +305,18 @@ public:
         }
     }
 
+    /**
+     * 构造函数，代码为 FuncLists 中的函数
+     * @param func_index
+     */
+    explicit LmCodeObject(size_t func_index)
+        : LmHeapObject(HeapObjType::CodeObject),
+          code_type_(CodeType::Function),
+          machine_code_addr_(nullptr),
+          machine_code_len_(0),
+          size_(0),
+          func_index_(func_index) {}
+
     /**
      * 析构函数
      */
@@ -276,6 +349,12 @@ public:
      * @return size_t
      */
     [[nodiscard]] size_t get_machine_code_len() const;
+
+    /**
+     * 获取函数下标
+     * @return size_t
+     */
+    [[nodiscard]] size_t get_func_index() const;
 };
 
 class LmBigint : public LmHeapObject {
@@ -325,6 +404,29 @@ public:
      */
     [[nodiscard]] TaggedVal get(size_t idx) const;
 
+    /**
+     * 获取连续存放的元素，批量数组指令直接读写此处
+     * @return TaggedVal*
+     */
+    [[nodiscard]] TaggedVal* data() { return vals_.data(); }
+    [[nodiscard]] const TaggedVal* data() const { return vals_.data(); }
+
+    /**
+     * 调整大小，新增元素为 val，截掉的堆对象元素释放引用
+     * @param size
+     * @param val
+     * @return void
+     */
+    void resize(size_t size, TaggedVal val);
+
+    /**
+     * 用一组元素替换全部内容，堆对象元素的引用计数随之调整；vals 可以是本数组自身，但不能是其中一段
+     * @param vals
+     * @param size
+     * @return void
+     */
+    void assign(const TaggedVal* vals, size_t size);
+
     /**
      * Override
      */
@@ -347,6 +449,137 @@ private:
     size_t capacity_; // 容量
 };
 
+class LmBuffer : public LmHeapObject {
+public:
+    /**
+     * 构造函数，按容量一次性分配原始字节
+     * @param capacity
+     */
+    explicit LmBuffer(size_t capacity)
+        : LmHeapObject(HeapObjType::Buffer),
+          data_(capacity ? new uint8_t[capacity] : nullptr),
+          size_(0),
+          capacity_(capacity) {}
+
+    /**
+     * 析构函数
+     */
+    ~LmBuffer() override {
+        delete[] data_;
+        data_ = nullptr;
+    }
+
+    /**
+     * 获取原始字节指针，I/O 直接读写此处
+     * @return uint8_t*
+     */
+    [[nodiscard]] uint8_t* data() { return data_; }
+    [[nodiscard]] const uint8_t* data() const { return data_; }
+
+    /**
+     * 获取有效字节数
+     * @return size_t
+     */
+    [[nodiscard]] size_t get_size() const { return size_; }
+
+    /**
+     * 获取容量
+     * @return size_t
+     */
+    [[nodiscard]] size_t get_capacity() const { return capacity_; }
+
+    /**
+     * 设置有效字节数（不超过容量）
+     * @param size
+     * @return void
+     */
+    void set_size(size_t size);
+
+    /**
+     * 记录一次读入的字节数：普通缓冲区的有效字节数随之改变，
+     * 紧凑数组长度固定，读入只覆盖前 size 个字节
+     * @param size
+     * @return void
+     */
+    void set_read_size(size_t size);
+
+    /**
+     * 扩容，保留已有数据
+     * @param capacity
+     * @return void
+     */
+    void reserve(size_t capacity);
+protected:
+    /**
+     * 供派生的紧凑数组指定对象类型
+     * @param type
+     * @param capacity
+     */
+    LmBuffer(HeapObjType type, size_t capacity)
+        : LmHeapObject(type),
+          data_(capacity ? new uint8_t[capacity] : nullptr),
+          size_(0),
+          capacity_(capacity) {}
+private:
+    uint8_t* data_; // 原始字节
+    size_t size_; // 有效字节数
+    size_t capacity_; // 容量
+};
+
+/**
+ * 紧凑数组：int8/int32/int64/f64 元素直接存放在 LmBuffer 的字节中，不再逐个展开为 TaggedVal，
+ * 因此也可以直接作为 I/O 缓冲区读写；长度为有效字节数除以元素宽度，读入不改变长度
+ */
+class LmTypedArray : public LmBuffer {
+public:
+    /**
+     * 构造函数，元素全部置 0
+     * @param type Int8Array / Int32Array / Int64Array / Float64Array
+     * @param length
+     */
+    LmTypedArray(HeapObjType type, size_t length)
+        : LmBuffer(type, length * element_width(type)) {
+        if (get_capacity() > 0) std::memset(data(), 0, get_capacity());
+        set_size(get_capacity());
+    }
+
+    /**
+     * 元素宽度（字节）
+     * @param type
+     * @return size_t
+     */
+    static size_t element_width(HeapObjType type) {
+        return type == HeapObjType::Int8Array ? 1 : type == HeapObjType::Int32Array ? 4 : 8;
+    }
+
+    // NEWT 与 VMCALL 14 使用的元素类型编码：0 int8、1 int32、2 int64、3 f64
+    static constexpr int64_t KIND_COUNT = 4;
+
+    /**
+     * 元素类型编码对应的对象类型，kind 必须小于 KIND_COUNT
+     * @param kind
+     * @return HeapObjType
+     */
+    static HeapObjType type_of(int64_t kind) {
+        return static_cast<HeapObjType>(static_cast<int64_t>(HeapObjType::Int8Array) + kind);
+    }
+
+    /**
+     * 是否为紧凑数组类型
+     * @param type
+     * @return bool
+     */
+    static bool is_typed(HeapObjType type) {
+        return type >= HeapObjType::Int8Array && type <= HeapObjType::Float64Array;
+    }
+
+    /**
+     * 元素个数
+     * @return size_t
+     */
+    [[nodiscard]] size_t length() const { return get_size() / element_width(get_type()); }
+};
+
 class LmWeakRef : public LmHeapObject {
 public:
     /**
@@ -0,0 +1,926 @@
+/******************************************************
+-     Date:  2026.10.19 16:05
+-     File:  optimizer.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "optimizer.hpp"
+#include "vm.hpp"
+#include <algorithm>
+#include <bit>
+#include <iomanip>
+#include <ostream>
+
+namespace {
+    using OpCode = OpCodeImpl::OpCode;
+    using Instruction = OpCodeImpl::Instruction;
+
+    constexpr uint32_t ALL_REGS = (1u << NUM_REGS) - 1;
+
+    // 指令对寄存器的读写与副作用
+    struct Effect {
+        uint32_t uses = 0;      // 读取的寄存器
+        uint32_t defs = 0;      // 写入（或可能写入）的寄存器
+        bool barrier = false;   // 控制流离开当前程序，结束基本块
+        bool removable = false; // 无副作用，结果不用时可删除
+    };
+
+    uint32_t bit(uint8_t reg) { return reg < NUM_REGS ? (1u << reg) : 0; }
+
+    Effect effectOf(const Instruction& instr) {
+        Effect e;
+        switch (instr.op) {
+            case OpCode::MOVRI:
+            case OpCode::MOVRM:
+                e.defs = bit(instr.rd);
+                e.removable = true;
+                break;
+            case OpCode::MOVRR:
+                e.uses = bit(instr.rs);
+                e.defs = bit(instr.rd);
+                e.removable = true;
+                break;
+            case OpCode::ADDR: case OpCode::SUBR: case OpCode::MULR:
+                e.uses = bit(instr.rd) | bit(instr.rs);
+                e.defs = bit(instr.rd);
+                e.removable = true;
+                break;
+            case OpCode::DIVR:
+                // 除数可能为 0，保留
+                e.uses = bit(instr.rd) | bit(instr.rs);
+                e.defs = bit(instr.rd);
+                break;
+            case OpCode::ADDI: case OpCode::SUBI: case OpCode::MULI: case OpCode::SHLI: case OpCode::DIVIQ:
+            case OpCode::ADDM: case OpCode::SUBM: case OpCode::MULM:
+                e.uses = bit(instr.rd);
+                e.defs = bit(instr.rd);
+                e.removable = true;
+                break;
+            case OpCode::DIVI:
+                e.uses = bit(instr.rd);
+                e.defs = bit(instr.rd);
+                e.removable = instr.imm != 0 && instr.imm != -1;
+                break;
+            case OpCode::DIVM:
+                e.uses = bit(instr.rd);
+                e.defs = bit(instr.rd);
+                break;
+            case OpCode::MOVMI:
+                break;
+            case OpCode::MOVMR:
+                e.uses = bit(instr.rs);
+                break;
+            case OpCode::MOVMM:
+                e.uses = instr.imm >= 0 && instr.imm < NUM_REGS ? bit(static_cast<uint8_t>(instr.imm)) : ALL_REGS;
+                break;
+            case OpCode::NEW:
+                e.defs = bit(1);
+                break;
+            case OpCode::CALL: case OpCode::CALLR:
+                // 被调函数返回时除 r0 外的寄存器都会恢复
+                e.uses = ALL_REGS;
+                e.defs = bit(0);
+                e.barrier = true;
+                break;
+            case OpCode::AFILL: case OpCode::ACOPY:
+            case OpCode::AADDR: case OpCode::AADDA:
+            case OpCode::ASUBR: case OpCode::ASUBA:
+            case OpCode::AMULR: case OpCode::AMULA:
+                // 只改写堆上的数组
+                e.uses = bit(instr.rd) | bit(instr.rs);
+                break;
+            case OpCode::ASUM: case OpCode::AMIN: case OpCode::AMAX:
+                // 操作数不是数组时抛出，保留
+                e.uses = bit(instr.rs);
+                e.defs = bit(instr.rd);
+                break;
+            case OpCode::AFIND: case OpCode::ACMP:
+                e.uses = bit(instr.rd) | bit(instr.rs);
+                e.defs = bit(instr.rd);
+                break;
+            case OpCode::LDI8: case OpCode::LDI32: case OpCode::LDI64: case OpCode::LDF64:
+                // 类型不符或越界时抛出，保留
+                e.uses = bit(instr.rs) | bit(static_cast<uint8_t>(instr.imm));
+                e.defs = bit(instr.rd);
+                break;
+            case OpCode::STI8: case OpCode::STI32: case OpCode::STI64: case OpCode::STF64:
+                e.uses = bit(instr.rd) | bit(instr.rs) | bit(static_cast<uint8_t>(instr.imm));
+                break;
+            case OpCode::LDX:
+                // 类型不符或越界时抛出，保留
+                e.uses = bit(instr.rs);
+                e.defs = bit(instr.rd);
+                break;
+            case OpCode::STX:
+                e.uses = bit(instr.rd) | bit(instr.rs);
+                break;
+            case OpCode::LDC:
+                // 常量下标越界时抛出，保留
+                e.defs = bit(instr.rd);
+                break;
+            case OpCode::NEWT:
+                e.defs = bit(1);
+                break;
+            case OpCode::ADDF: case OpCode::SUBF: case OpCode::MULF: case OpCode::DIVF:
+                // IEEE 754 运算不会陷入
+                e.uses = bit(instr.rd) | bit(instr.rs);
+                e.defs = bit(instr.rd);
+                e.removable = true;
+                break;
+            case OpCode::CVT:
+                e.uses = bit(instr.rs);
+                e.defs = bit(instr.rd);
+                e.removable = true;
+                break;
+            case OpCode::MNEW:
+                e.defs = bit(instr.rd);
+                break;
+            case OpCode::MGET:
+                // 键不存在时 r[rd] 保持原值
+                e.uses = bit(instr.rd) | bit(instr.rs) | bit(static_cast<uint8_t>(instr.imm & OpCodeImpl::MAP_KEY_REG));
+                e.defs = bit(instr.rd);
+                break;
+            case OpCode::MPUT:
+                e.uses = bit(instr.rd) | bit(instr.rs) | bit(static_cast<uint8_t>(instr.imm & OpCodeImpl::MAP_KEY_REG));
+                break;
+            case OpCode::MDEL:
+                e.uses = bit(instr.rs) | bit(static_cast<uint8_t>(instr.imm & OpCodeImpl::MAP_KEY_REG));
+                e.defs = bit(instr.rd);
+                break;
+            case OpCode::MNEXT:
+                e.uses = bit(instr.rs) | bit(static_cast<uint8_t>(instr.imm));
+                e.defs = bit(instr.rd) | bit(static_cast<uint8_t>(instr.imm));
+                break;
+            case OpCode::NEWR:
+                e.defs = bit(instr.rd);
+                break;
+            case OpCode::GETFIELD:
+                // 字段不存在时 r[rd] 保持原值
+                e.uses = bit(instr.rd) | bit(instr.rs);
+                e.defs = bit(instr.rd);
+                break;
+            case OpCode::SETFIELD:
+                e.uses = bit(instr.rd) | bit(instr.rs);
+                break;
+            case OpCode::TAILCALL:
+                // 与 RET 一样离开程序，被调函数可能读取任何寄存器
+                e.uses = ALL_REGS;
+                e.barrier = true;
+                break;
+            case OpCode::NEWF:
+                for (int8_t reg : instr.data) e.uses |= reg >= 0 && reg < NUM_REGS ? bit(static_cast<uint8_t>(reg)) : ALL_REGS;
+                e.defs = bit(instr.rd);
+                break;
+            case OpCode::HALT:
+                e.removable = true;
+                break;
+            default:
+                // VMCALL / 条件跳转 / SWITCH / RET 以及未知指令一律保守处理
+                e.uses = ALL_REGS;
+                e.defs = ALL_REGS;
+                e.barrier = true;
+                break;
+        }
+        return e;
+    }
+
+    /**
+     * 可能触发陷阱的指令。陷阱被 TRY 捕获时，处理块可以读取触发时的全部寄存器，
+     * 处理完后从 ENDTRY 之后继续，保护区内余下的写入不会发生
+     */
+    bool mayTrap(const Instruction& instr) {
+        switch (instr.op) {
+            case OpCode::DIVR: case OpCode::DIVM:
+                return true;
+            case OpCode::DIVI:
+                return instr.imm == 0 || instr.imm == -1;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * 陷阱可见时，可能陷入的指令读取全部寄存器，并作为数据流事实的屏障
+     */
+    Effect effectOf(const Instruction& instr, bool traps_visible) {
+        Effect e = effectOf(instr);
+        if (traps_visible && mayTrap(instr)) {
+            e.uses = ALL_REGS;
+            e.defs = ALL_REGS;
+            e.removable = false;
+        }
+        return e;
+    }
+
+    bool hasTry(const std::vector<Instruction>& program) {
+        return std::any_of(program.begin(), program.end(), [](const Instruction& instr) { return instr.op == OpCode::TRY; });
+    }
+
+    /**
+     * 删除被标记的指令
+     */
+    size_t compact(std::vector<Instruction>& program, const std::vector<bool>& dead) {
+        size_t out = 0;
+        for (size_t i = 0; i < program.size(); ++i) {
+            if (dead[i]) continue;
+            if (out != i) program[out] = std::move(program[i]);
+            ++out;
+        }
+        size_t removed = program.size() - out;
+        program.resize(out);
+        return removed;
+    }
+
+    void rewriteImm(Instruction& instr, OpCode op, int64_t imm) {
+        instr.op = op;
+        instr.imm = imm;
+        instr.rs = 0;
+    }
+
+    // 按二进制补码回绕计算，避免有符号溢出
+    bool evaluate(OpCode op, int64_t left, int64_t right, int64_t& out) {
+        auto l = static_cast<uint64_t>(left);
+        auto r = static_cast<uint64_t>(right);
+        switch (op) {
+            case OpCode::ADDR: case OpCode::ADDI: out = static_cast<int64_t>(l + r); return true;
+            case OpCode::SUBR: case OpCode::SUBI: out = static_cast<int64_t>(l - r); return true;
+            case OpCode::MULR: case OpCode::MULI: out = static_cast<int64_t>(l * r); return true;
+            case OpCode::SHLI: out = static_cast<int64_t>(l << (r & 63)); return true;
+            case OpCode::DIVR: case OpCode::DIVI: case OpCode::DIVIQ:
+                if (right == 0 || (left == INT64_MIN && right == -1)) return false;
+                out = left / right;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    OpCode immediateForm(OpCode op) {
+        switch (op) {
+            case OpCode::ADDR: return OpCode::ADDI;
+            case OpCode::SUBR: return OpCode::SUBI;
+            case OpCode::MULR: return OpCode::MULI;
+            case OpCode::DIVR: return OpCode::DIVI;
+            default: return op;
+        }
+    }
+
+    // 能放进指令 31 位扩展偏移的值
+    bool fitsOffset(int64_t value) { return value >= -(int64_t{1} << 30) && value < (int64_t{1} << 30); }
+
+    // 前向数据流的常量事实
+    struct ConstFacts {
+        uint32_t known = 0;
+        int64_t val[NUM_REGS]{};
+
+        void meet(const ConstFacts& other) {
+            for (uint8_t r = 0; r < NUM_REGS; ++r) {
+                if ((known & bit(r)) && (!(other.known & bit(r)) || other.val[r] != val[r])) known &= ~bit(r);
+            }
+        }
+    };
+
+    // 前向数据流的复制事实，copy_of[r] 表示 r 与该寄存器值相同
+    struct CopyFacts {
+        int8_t copy_of[NUM_REGS];
+
+        CopyFacts() { std::fill(std::begin(copy_of), std::end(copy_of), -1); }
+
+        void meet(const CopyFacts& other) {
+            for (uint8_t r = 0; r < NUM_REGS; ++r) {
+                if (copy_of[r] != other.copy_of[r]) copy_of[r] = -1;
+            }
+        }
+
+        void kill(uint32_t defs) {
+            for (uint8_t r = 0; r < NUM_REGS; ++r) {
+                if ((defs & bit(r)) || (copy_of[r] >= 0 && (defs & bit(copy_of[r])))) copy_of[r] = -1;
+            }
+        }
+    };
+
+    /**
+     * 按块顺序做前向分析，块入口事实为所有前驱出口事实的交
+     */
+    template<typename Facts, typename Transfer>
+    void forwardPass(std::vector<Instruction>& program, Transfer transfer) {
+        auto blocks = Optimizer::buildBlocks(program);
+        std::vector<Facts> out(blocks.size());
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            Facts facts;
+            if (!blocks[b].preds.empty()) {
+                facts = out[blocks[b].preds[0]];
+                for (size_t p = 1; p < blocks[b].preds.size(); ++p) facts.meet(out[blocks[b].preds[p]]);
+            }
+            for (size_t i = blocks[b].begin; i < blocks[b].end; ++i) transfer(i, facts);
+            out[b] = facts;
+        }
+    }
+
+    // 整个虚拟机的存活寄存器：跳转块入口与返回时、函数入口时，下标分别为 CallLists 与 FuncLists 中的程序
+    struct ProgramLiveness {
+        std::vector<uint32_t> block_entry;
+        std::vector<uint32_t> block_exit;
+        std::vector<uint32_t> func_entry;
+    };
+
+    /**
+     * 条件跳转：IFRR/IFRI 与融合比较跳转，条件成立时进入 CallLists[imm]
+     */
+    bool isBranch(OpCode op) {
+        return op == OpCode::IFRR || op == OpCode::IFRI || OpCodeImpl::isFusedBranch(op);
+    }
+
+    /**
+     * 条件跳转读取的寄存器
+     */
+    uint32_t branchUses(const Instruction& instr) {
+        const bool with_rs = instr.op == OpCode::IFRR || (instr.op >= OpCode::JEQ && instr.op <= OpCode::JLE);
+        return bit(instr.rd) | (with_rs ? bit(instr.rs) : 0);
+    }
+
+    /**
+     * 条件跳转或 SWITCH 可能进入的跳转块，目标越界或分支列表不合法时返回 false
+     */
+    bool branchTargets(const Instruction& instr, size_t block_count, std::vector<size_t>& targets) {
+        targets.clear();
+        auto add = [&](int64_t block) {
+            if (block < 0 || static_cast<size_t>(block) >= block_count) return false;
+            targets.push_back(static_cast<size_t>(block));
+            return true;
+        };
+        if (isBranch(instr.op)) return add(instr.imm);
+        if (instr.op != OpCode::SWITCH) return false;
+        std::vector<SwitchTable::Case> cases;
+        try {
+            cases = SwitchTable::decode(instr.data);
+        } catch (const std::runtime_error&) {
+            return false;
+        }
+        if (instr.imm != -1 && !add(instr.imm)) return false;
+        return std::all_of(cases.begin(), cases.end(), [&](const SwitchTable::Case& c) { return add(c.second); });
+    }
+
+    /**
+     * 每条指令之后存活的寄存器，live_at_exit 为离开程序时存活的寄存器
+     * 条件跳转与 SWITCH 按读取的寄存器加上各目标块入口存活的寄存器计算，跳转块不一定执行，之后存活的寄存器保持存活；
+     * CALL 返回时恢复除 r0 外的全部寄存器，按被调函数入口存活的寄存器计算
+     * @param live_in 写入程序入口存活的寄存器
+     */
+    std::vector<uint32_t> liveAfter(const std::vector<Instruction>& program, uint32_t live_at_exit,
+                                    const ProgramLiveness& vm_live, uint32_t* live_in = nullptr) {
+        auto blocks = Optimizer::buildBlocks(program);
+        std::vector<uint32_t> after(program.size(), 0);
+        std::vector<uint32_t> block_in(blocks.size(), 0);
+        std::vector<size_t> targets;
+        for (size_t b = blocks.size(); b-- > 0;) {
+            uint32_t live = blocks[b].exits ? live_at_exit : 0;
+            for (size_t s : blocks[b].succs) live |= block_in[s];
+            for (size_t i = blocks[b].end; i-- > blocks[b].begin;) {
+                const Instruction& instr = program[i];
+                after[i] = live;
+                if (instr.op == OpCode::RET) {
+                    live = live_at_exit;
+                } else if (branchTargets(instr, vm_live.block_entry.size(), targets)) {
+                    live |= instr.op == OpCode::SWITCH ? bit(instr.rd) : branchUses(instr);
+                    for (size_t block : targets) live |= vm_live.block_entry[block];
+                } else if (instr.op == OpCode::CALL && instr.imm >= 0
+                           && static_cast<size_t>(instr.imm) < vm_live.func_entry.size()) {
+                    live = (live & ~bit(0)) | vm_live.func_entry[static_cast<size_t>(instr.imm)];
+                } else {
+                    const Effect e = effectOf(instr);
+                    live = (live & ~e.defs) | e.uses;
+                }
+            }
+            block_in[b] = live;
+        }
+        if (live_in != nullptr) *live_in = blocks.empty() ? live_at_exit : block_in[0];
+        return after;
+    }
+
+    /**
+     * 整个虚拟机的存活寄存器：条件跳转与 SWITCH 进入的块返回时取调用点之后存活的寄存器，函数返回时只有 r0 存活
+     * 程序之间可以互相进入，从空集迭代到不动点；调用方需保证没有陷阱处理块
+     */
+    ProgramLiveness programLiveness(const std::vector<Instruction>& entry,
+                                    const std::vector<std::vector<Instruction>>& funcs,
+                                    const std::vector<std::vector<Instruction>>& blocks) {
+        ProgramLiveness live{std::vector<uint32_t>(blocks.size(), 0), std::vector<uint32_t>(blocks.size(), 0),
+                             std::vector<uint32_t>(funcs.size(), 0)};
+        for (bool changed = true; changed;) {
+            changed = false;
+            auto merge = [&](uint32_t& into, uint32_t mask) {
+                if ((into | mask) == into) return;
+                into |= mask;
+                changed = true;
+            };
+            auto visit = [&](const std::vector<Instruction>& program, uint32_t live_at_exit, uint32_t* entry_live) {
+                uint32_t live_in = 0;
+                const auto after = liveAfter(program, live_at_exit, live, &live_in);
+                if (entry_live != nullptr) merge(*entry_live, live_in);
+                std::vector<size_t> targets;
+                for (size_t i = 0; i < program.size(); ++i) {
+                    if (!branchTargets(program[i], blocks.size(), targets)) continue;
+                    for (size_t block : targets) merge(live.block_exit[block], after[i]);
+                }
+            };
+            visit(entry, ALL_REGS, nullptr);
+            for (size_t f = 0; f < funcs.size(); ++f) visit(funcs[f], bit(0), &live.func_entry[f]);
+            for (size_t b = 0; b < blocks.size(); ++b) visit(blocks[b], live.block_exit[b], &live.block_entry[b]);
+        }
+        return live;
+    }
+
+    // 可以内联的被调函数
+    struct InlineCallee {
+        size_t size = 0;      // 展开的指令数（不含末尾 RET）
+        uint32_t touched = 0; // 读写过的寄存器
+        uint32_t written = 0; // 改写的寄存器（不含 r0）
+        uint32_t exposed = 0; // 改写之前就读取的寄存器，即参数
+        bool may_trap = false;
+    };
+
+    /**
+     * 分析被调函数能否内联：只含寄存器操作数都在 rd/rs 中的指令，不含调用、跳转与陷阱处理，RET 只在末尾
+     */
+    bool analyzeCallee(const std::vector<Instruction>& func, size_t max_size, InlineCallee& callee) {
+        const size_t size = !func.empty() && func.back().op == OpCode::RET ? func.size() - 1 : func.size();
+        if (size > max_size) return false;
+        callee = InlineCallee{};
+        callee.size = size;
+        uint32_t defined = 0;
+        for (size_t i = 0; i < size; ++i) {
+            const Instruction& instr = func[i];
+            switch (instr.op) {
+                case OpCode::MOVRI: case OpCode::MOVRR: case OpCode::MOVRM:
+                case OpCode::MOVMI: case OpCode::MOVMR:
+                case OpCode::ADDR: case OpCode::ADDI: case OpCode::ADDM:
+                case OpCode::SUBR: case OpCode::SUBI: case OpCode::SUBM:
+                case OpCode::MULR: case OpCode::MULI: case OpCode::MULM:
+                case OpCode::DIVIQ: case OpCode::SHLI:
+                case OpCode::ADDF: case OpCode::SUBF: case OpCode::MULF: case OpCode::DIVF: case OpCode::CVT:
+                case OpCode::NEWR: case OpCode::GETFIELD: case OpCode::SETFIELD:
+                case OpCode::HALT:
+                    break;
+                case OpCode::DIVR: case OpCode::DIVM:
+                    callee.may_trap = true;
+                    break;
+                case OpCode::DIVI:
+                    callee.may_trap |= instr.imm == 0 || instr.imm == -1;
+                    break;
+                default:
+                    return false;
+            }
+            if (instr.rd >= NUM_REGS || instr.rs >= NUM_REGS) return false;
+            const Effect e = effectOf(instr);
+            callee.exposed |= e.uses & ~defined;
+            defined |= e.defs;
+            callee.touched |= e.uses | e.defs;
+        }
+        callee.written = defined & ~bit(0);
+        return true;
+    }
+}
+
+void Optimizer::Stats::merge(const Stats& other) {
+    before += other.before;
+    after += other.after;
+    for (const auto& pass : other.passes) {
+        auto it = std::find_if(passes.begin(), passes.end(), [&](const PassStats& p) { return p.name == pass.name; });
+        if (it == passes.end()) {
+            passes.push_back(pass);
+        } else {
+            it->rewritten += pass.rewritten;
+            it->added += pass.added;
+            it->removed += pass.removed;
+        }
+    }
+}
+
+void Optimizer::Stats::print(std::ostream& out) const {
+    out << std::left << std::setw(24) << "pass" << std::right << std::setw(10) << "rewritten"
+        << std::setw(10) << "added" << std::setw(10) << "removed" << "\n";
+    for (const auto& pass : passes) {
+        out << std::left << std::setw(24) << pass.name << std::right << std::setw(10) << pass.rewritten
+            << std::setw(10) << pass.added << std::setw(10) << pass.removed << "\n";
+    }
+    // 内联可能让程序变长
+    double ratio = before ? 100.0 * (static_cast<double>(after) - static_cast<double>(before)) / before : 0.0;
+    out << "instructions: " << before << " -> " << after
+        << " (" << std::showpos << std::fixed << std::setprecision(1) << ratio << std::noshowpos << "%)\n";
+}
+
+std::vector<Optimizer::BasicBlock> Optimizer::buildBlocks(const std::vector<OpCodeImpl::Instruction>& program) {
+    std::vector<BasicBlock> blocks;
+    size_t begin = 0;
+    for (size_t i = 0; i < program.size(); ++i) {
+        if (effectOf(program[i]).barrier || i + 1 == program.size()) {
+            BasicBlock block;
+            block.begin = begin;
+            block.end = i + 1;
+            blocks.push_back(block);
+            begin = i + 1;
+        }
+    }
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        const Instruction& last = program[blocks[b].end - 1];
+        // RET/TAILCALL 离开程序；条件跳转与 SWITCH 的跳转块可能带着返回标记离开程序
+        bool falls_through = last.op != OpCode::RET && last.op != OpCode::TAILCALL;
+        blocks[b].exits = !falls_through || isBranch(last.op) || last.op == OpCode::SWITCH || b + 1 == blocks.size();
+        if (falls_through && b + 1 < blocks.size()) {
+            blocks[b].succs.push_back(b + 1);
+            blocks[b + 1].preds.push_back(b);
+        }
+    }
+    return blocks;
+}
+
+size_t Optimizer::foldConstants(std::vector<OpCodeImpl::Instruction>& program, bool traps_visible) {
+    size_t rewritten = 0;
+    forwardPass<ConstFacts>(program, [&](size_t i, ConstFacts& facts) {
+        Instruction& instr = program[i];
+        if (traps_visible && mayTrap(instr)) {
+            facts.known = 0;
+            return;
+        }
+        const uint32_t rd = bit(instr.rd);
+        const uint32_t rs = bit(instr.rs);
+        int64_t value;
+        switch (instr.op) {
+            case OpCode::MOVRI:
+                facts.known |= rd;
+                facts.val[instr.rd] = instr.imm;
+                return;
+            case OpCode::MOVRR:
+                if (facts.known & rs) {
+                    rewriteImm(instr, OpCode::MOVRI, facts.val[instr.rs]);
+                    facts.known |= rd;
+                    facts.val[instr.rd] = instr.imm;
+                    ++rewritten;
+                    return;
+                }
+                break;
+            case OpCode::ADDI: case OpCode::SUBI: case OpCode::MULI: case OpCode::SHLI:
+            case OpCode::DIVI: case OpCode::DIVIQ:
+                if ((facts.known & rd) && evaluate(instr.op, facts.val[instr.rd], instr.imm, value)) {
+                    rewriteImm(instr, OpCode::MOVRI, value);
+                    facts.val[instr.rd] = value;
+                    ++rewritten;
+                    return;
+                }
+                break;
+            case OpCode::ADDR: case OpCode::SUBR: case OpCode::MULR: case OpCode::DIVR:
+                if (facts.known & rs) {
+                    if ((facts.known & rd) && evaluate(instr.op, facts.val[instr.rd], facts.val[instr.rs], value)) {
+                        rewriteImm(instr, OpCode::MOVRI, value);
+                        facts.val[instr.rd] = value;
+                        ++rewritten;
+                        return;
+                    }
+                    rewriteImm(instr, immediateForm(instr.op), facts.val[instr.rs]);
+                    ++rewritten;
+                }
+                break;
+            case OpCode::IFRR:
+            case OpCode::JEQ: case OpCode::JNE: case OpCode::JGT: case OpCode::JLT: case OpCode::JGE: case OpCode::JLE: {
+                // 与常量比较改写为带 I 的融合比较跳转，常量放在 31 位的源偏移里
+                const int8_t cmp = instr.op == OpCode::IFRR ? (instr.data.empty() ? -1 : instr.data[0])
+                                                             : OpCodeImpl::fusedCmp(instr.op);
+                if ((facts.known & rs) && cmp >= 0 && cmp < OpCodeImpl::CMP_COUNT && fitsOffset(facts.val[instr.rs])) {
+                    instr.op = OpCodeImpl::fusedBranch(cmp, true);
+                    instr.srcOffset = static_cast<int32_t>(facts.val[instr.rs]);
+                    instr.rs = 0;
+                    instr.data.clear();
+                    ++rewritten;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        facts.known &= ~effectOf(instr).defs;
+    });
+    return rewritten;
+}
+
+size_t Optimizer::propagateCopies(std::vector<OpCodeImpl::Instruction>& program, bool traps_visible, size_t& removed) {
+    size_t rewritten = 0;
+    std::vector<bool> dead(program.size(), false);
+    forwardPass<CopyFacts>(program, [&](size_t i, CopyFacts& facts) {
+        Instruction& instr = program[i];
+        // 纯源操作数替换为最早的副本
+        switch (instr.op) {
+            case OpCode::MOVRR: case OpCode::MOVMR:
+            case OpCode::ADDR: case OpCode::SUBR: case OpCode::MULR: case OpCode::DIVR:
+                if (instr.rs < NUM_REGS && facts.copy_of[instr.rs] >= 0) {
+                    instr.rs = static_cast<uint8_t>(facts.copy_of[instr.rs]);
+                    ++rewritten;
+                }
+                break;
+            case OpCode::MOVMM:
+                if (instr.imm >= 0 && instr.imm < NUM_REGS && facts.copy_of[instr.imm] >= 0) {
+                    instr.imm = facts.copy_of[instr.imm];
+                    ++rewritten;
+                }
+                break;
+            default:
+                break;
+        }
+        if (instr.op == OpCode::MOVRR
+            && (instr.rd == instr.rs || (instr.rd < NUM_REGS && facts.copy_of[instr.rd] == instr.rs))) {
+            dead[i] = true;
+            return;
+        }
+        facts.kill(effectOf(instr, traps_visible).defs);
+        if (instr.op == OpCode::MOVRR && instr.rd < NUM_REGS) {
+            facts.copy_of[instr.rd] = static_cast<int8_t>(instr.rs);
+        }
+    });
+    removed += compact(program, dead);
+    return rewritten;
+}
+
+size_t Optimizer::reduceStrength(std::vector<OpCodeImpl::Instruction>& program, size_t& removed) {
+    size_t rewritten = 0;
+    std::vector<bool> dead(program.size(), false);
+    for (size_t i = 0; i < program.size(); ++i) {
+        Instruction& instr = program[i];
+        switch (instr.op) {
+            case OpCode::ADDI: case OpCode::SUBI: case OpCode::SHLI:
+                if (instr.imm == 0) dead[i] = true;
+                break;
+            case OpCode::DIVI: case OpCode::DIVIQ:
+                if (instr.imm == 1) dead[i] = true;
+                break;
+            case OpCode::MULI:
+                if (instr.imm == 1) {
+                    dead[i] = true;
+                } else if (instr.imm == 0) {
+                    rewriteImm(instr, OpCode::MOVRI, 0);
+                    ++rewritten;
+                } else if (instr.imm > 0 && (instr.imm & (instr.imm - 1)) == 0) {
+                    rewriteImm(instr, OpCode::SHLI, std::countr_zero(static_cast<uint64_t>(instr.imm)));
+                    ++rewritten;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    removed += compact(program, dead);
+    return rewritten;
+}
+
+size_t Optimizer::quicken(std::vector<OpCodeImpl::Instruction>& program) {
+    size_t rewritten = 0;
+    for (auto& instr : program) {
+        // 除数为非 0、非 -1 的立即数时不可能触发陷阱
+        if (instr.op == OpCode::DIVI && instr.imm != 0 && instr.imm != -1) {
+            instr.op = OpCode::DIVIQ;
+            ++rewritten;
+        }
+        // 整数比较的 IFRR/IFRI 改写为融合比较跳转，不再查比较表
+        if ((instr.op == OpCode::IFRR || instr.op == OpCode::IFRI) && !instr.data.empty()
+            && instr.data[0] >= 0 && instr.data[0] < OpCodeImpl::CMP_COUNT) {
+            instr.op = OpCodeImpl::fusedBranch(instr.data[0], instr.op == OpCode::IFRI);
+            instr.data.clear();
+            ++rewritten;
+        }
+    }
+    return rewritten;
+}
+
+size_t Optimizer::formTailCalls(std::vector<OpCodeImpl::Instruction>& program, size_t& removed) {
+    // 帧内安装的陷阱处理块能捕获 CALL 中的陷阱，TAILCALL 会先丢弃它们，有 TRY 的函数不改写
+    if (hasTry(program)) return 0;
+    size_t rewritten = 0;
+    std::vector<bool> dead(program.size(), false);
+    for (size_t i = 0; i < program.size(); ++i) {
+        if (program[i].op != OpCode::CALL) continue;
+        // 函数末尾的 CALL 之后同样直接返回
+        const bool last = i + 1 == program.size();
+        if (!last && program[i + 1].op != OpCode::RET) continue;
+        program[i].op = OpCode::TAILCALL;
+        ++rewritten;
+        if (!last) dead[i + 1] = true;
+    }
+    removed += compact(program, dead);
+    return rewritten;
+}
+
+size_t Optimizer::eliminateDeadCode(std::vector<OpCodeImpl::Instruction>& program, ProgramKind kind, bool traps_visible) {
+    // 函数返回时只有 r0 会带回调用方
+    const uint32_t live_at_exit = kind == ProgramKind::Function ? bit(0) : ALL_REGS;
+    auto blocks = buildBlocks(program);
+    std::vector<uint32_t> live_in(blocks.size(), 0);
+    std::vector<bool> dead(program.size(), false);
+
+    for (size_t b = blocks.size(); b-- > 0;) {
+        uint32_t live = blocks[b].exits ? live_at_exit : 0;
+        for (size_t s : blocks[b].succs) live |= live_in[s];
+        for (size_t i = blocks[b].end; i-- > blocks[b].begin;) {
+            const Instruction& instr = program[i];
+            if (instr.op == OpCode::RET) {
+                live = live_at_exit;
+                continue;
+            }
+            Effect e = effectOf(instr, traps_visible);
+            if (e.removable && !(e.defs & live)) {
+                dead[i] = true;
+                continue;
+            }
+            live = (live & ~e.defs) | e.uses;
+        }
+        live_in[b] = live;
+    }
+    return compact(program, dead);
+}
+
+Optimizer::Stats Optimizer::optimize(std::vector<OpCodeImpl::Instruction>& program, ProgramKind kind,
+                                     const Options& options) {
+    Stats stats;
+    stats.before = program.size();
+    PassStats folding{"constant-folding"};
+    PassStats copies{"copy-propagation"};
+    PassStats strength{"strength-reduction"};
+    PassStats dce{"dead-code-elimination"};
+    PassStats quickening{"quickening"};
+    PassStats tail_calls{"tail-calls"};
+    // 陷阱经 CALL 展开时由调用方恢复寄存器，函数中的陷阱只对自己的 TRY 可见；
+    // 跳转块与调用方共用寄存器，任何一层帧的处理块都能看到
+    const bool traps_visible = hasTry(program) || (kind == ProgramKind::Block && options.trap_handlers);
+
+    for (size_t round = 0; round < options.max_rounds; ++round) {
+        size_t changes = 0;
+        if (options.constant_folding) {
+            size_t n = foldConstants(program, traps_visible);
+            folding.rewritten += n;
+            changes += n;
+        }
+        if (options.copy_propagation) {
+            size_t removed = 0;
+            size_t n = propagateCopies(program, traps_visible, removed);
+            copies.rewritten += n;
+            copies.removed += removed;
+            changes += n + removed;
+        }
+        if (options.strength_reduction) {
+            size_t removed = 0;
+            size_t n = reduceStrength(program, removed);
+            strength.rewritten += n;
+            strength.removed += removed;
+            changes += n + removed;
+        }
+        if (options.dead_code_elimination) {
+            size_t removed = eliminateDeadCode(program, kind, traps_visible);
+            dce.removed += removed;
+            changes += removed;
+        }
+        if (changes == 0) break;
+    }
+    if (options.quickening) quickening.rewritten += quicken(program);
+    // 只有函数帧返回时由调用方恢复寄存器，入口与跳转块中的 CALL + RET 不能复用帧
+    if (options.tail_calls && kind == ProgramKind::Function) {
+        tail_calls.rewritten += formTailCalls(program, tail_calls.removed);
+    }
+
+    if (options.constant_folding) stats.passes.push_back(folding);
+    if (options.copy_propagation) stats.passes.push_back(copies);
+    if (options.strength_reduction) stats.passes.push_back(strength);
+    if (options.dead_code_elimination) stats.passes.push_back(dce);
+    if (options.quickening) stats.passes.push_back(quickening);
+    if (options.tail_calls) stats.passes.push_back(tail_calls);
+    stats.after = program.size();
+    return stats;
+}
+
+Optimizer::PassStats Optimizer::inlineCalls(RegisterVM& vm, std::vector<OpCodeImpl::Instruction>& entry,
+                                            const Options& options) {
+    PassStats stats{"inlining"};
+    auto& funcs = vm.FuncLists;
+    // 热度：各函数的静态调用点个数
+    std::vector<size_t> heat(funcs.size(), 0);
+    auto countCalls = [&](const std::vector<Instruction>& program) {
+        for (const auto& instr : program) {
+            if (instr.op == OpCode::CALL && instr.imm >= 0 && static_cast<size_t>(instr.imm) < funcs.size()) {
+                ++heat[static_cast<size_t>(instr.imm)];
+            }
+        }
+    };
+    countCalls(entry);
+    for (const auto& func : funcs) countCalls(func);
+    for (const auto& block : vm.CallLists) countCalls(block);
+    // 陷阱处理块可能在保护区内任意一点读取寄存器，有 TRY 时不内联
+    if (hasTry(entry) || std::any_of(funcs.begin(), funcs.end(), hasTry)
+        || std::any_of(vm.CallLists.begin(), vm.CallLists.end(), hasTry)) {
+        return stats;
+    }
+    const ProgramLiveness vm_live = programLiveness(entry, funcs, vm.CallLists);
+
+    auto inlineInto = [&](std::vector<Instruction>& program, uint32_t live_at_exit, bool is_function) {
+        // 函数帧展开陷阱时由调用方恢复寄存器，只有函数体可以容纳会陷入的被调函数
+        const bool trap_safe = is_function;
+        struct Site {
+            size_t at;
+            size_t callee;
+        };
+        std::vector<Site> sites;
+        for (size_t i = 0; i < program.size(); ++i) {
+            const Instruction& instr = program[i];
+            if (instr.op != OpCode::CALL || instr.imm < 0 || static_cast<size_t>(instr.imm) >= funcs.size()) continue;
+            const auto index = static_cast<size_t>(instr.imm);
+            // 函数自身的函数体会在展开时被改写
+            if (&funcs[index] == &program) continue;
+            InlineCallee callee;
+            if (!analyzeCallee(funcs[index], options.inline_max_size, callee) || (callee.may_trap && !trap_safe)) continue;
+            sites.push_back({i, index});
+        }
+        std::stable_sort(sites.begin(), sites.end(), [&](const Site& a, const Site& b) {
+            if (heat[a.callee] != heat[b.callee]) return heat[a.callee] > heat[b.callee];
+            return funcs[a.callee].size() < funcs[b.callee].size();
+        });
+        size_t budget = options.inline_growth;
+        std::vector<Site> chosen;
+        for (const Site& site : sites) {
+            const size_t cost = funcs[site.callee].size();
+            if (cost > budget) continue;
+            budget -= cost;
+            chosen.push_back(site);
+        }
+        // 从后往前展开，前面调用点的下标不变；每次展开后重新计算存活寄存器
+        std::sort(chosen.begin(), chosen.end(), [](const Site& a, const Site& b) { return a.at > b.at; });
+        for (const Site& site : chosen) {
+            const std::vector<Instruction>& func = funcs[site.callee];
+            InlineCallee callee;
+            analyzeCallee(func, options.inline_max_size, callee);
+            const uint32_t live = liveAfter(program, live_at_exit, vm_live)[site.at];
+            // 调用点之后仍要用的寄存器若被改写，改名为被调函数不用、之后也不再用的寄存器
+            uint8_t rename[NUM_REGS];
+            for (uint8_t r = 0; r < NUM_REGS; ++r) rename[r] = r;
+            uint32_t free = ALL_REGS & ~(callee.touched | live | bit(0));
+            std::vector<Instruction> spliced;
+            bool fits = true;
+            for (uint32_t conflicts = callee.written & live; conflicts != 0; conflicts &= conflicts - 1) {
+                if (free == 0) {
+                    fits = false;
+                    break;
+                }
+                const auto from = static_cast<uint8_t>(std::countr_zero(conflicts));
+                const auto to = static_cast<uint8_t>(std::countr_zero(free));
+                free &= free - 1;
+                rename[from] = to;
+                // 参数先复制到新寄存器
+                if (callee.exposed & bit(from)) {
+                    Instruction copy;
+                    copy.op = OpCode::MOVRR;
+                    copy.rd = to;
+                    copy.rs = from;
+                    spliced.push_back(copy);
+                }
+            }
+            if (!fits) continue;
+            for (size_t i = 0; i < callee.size; ++i) {
+                Instruction instr = func[i];
+                instr.rd = rename[instr.rd];
+                instr.rs = rename[instr.rs];
+                instr.cache = 0; // 每个展开点使用自己的内联缓存
+                spliced.push_back(std::move(instr));
+            }
+            const auto at = program.begin() + static_cast<std::ptrdiff_t>(site.at);
+            program.erase(at);
+            program.insert(program.begin() + static_cast<std::ptrdiff_t>(site.at), spliced.begin(), spliced.end());
+            ++stats.rewritten;
+            stats.added += spliced.size();
+            ++stats.removed;
+        }
+    };
+
+    inlineInto(entry, ALL_REGS, false);
+    for (auto& func : funcs) inlineInto(func, bit(0), true);
+    // 内联只会减少存活的寄存器，先前算出的各程序存活寄存器仍然成立
+    for (size_t b = 0; b < vm.CallLists.size(); ++b) inlineInto(vm.CallLists[b], vm_live.block_exit[b], false);
+    return stats;
+}
+
+Optimizer::Stats Optimizer::optimizeVM(RegisterVM& vm, std::vector<OpCodeImpl::Instruction>& entry,
+                                       const Options& options) {
+    // 优化需要看到全部函数，延迟加载的函数在这里一次加载
+    vm.loadAllFuncs();
+    size_t before = entry.size();
+    for (const auto& func : vm.FuncLists) before += func.size();
+    for (const auto& block : vm.CallLists) before += block.size();
+    PassStats inlining{"inlining"};
+    if (options.inlining) inlining = inlineCalls(vm, entry, options);
+
+    Options program_options = options;
+    program_options.trap_handlers = hasTry(entry) || std::any_of(vm.FuncLists.begin(), vm.FuncLists.end(), hasTry)
+                                    || std::any_of(vm.CallLists.begin(), vm.CallLists.end(), hasTry);
+    Stats stats = optimize(entry, ProgramKind::Entry, program_options);
+    for (auto& func : vm.FuncLists) stats.merge(optimize(func, ProgramKind::Function, program_options));
+    for (auto& block : vm.CallLists) stats.merge(optimize(block, ProgramKind::Block, program_options));
+    if (options.inlining) stats.passes.insert(stats.passes.begin(), inlining);
+    stats.before = before;
+    // 程序已被改写，需要重新校验
+    vm.verified_entry = nullptr;
+    return stats;
+}
@@ -0,0 +1,159 @@
+/******************************************************
+-     Date:  2026.10.19 16:05
+-     File:  optimizer.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include "../opcode.hpp"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class RegisterVM;
+
+/**
+ * 字节码优化器
+ * 先把小函数内联到调用点，再在基本块/CFG 上执行常量折叠、复制传播、强度削减与死代码消除，
+ * 最后做指令快速化与尾调用改写
+ */
+class Optimizer {
+public:
+    // 程序种类，决定程序结束时哪些寄存器仍然存活
+    enum class ProgramKind {
+        Entry,    // 入口程序，结束后所有寄存器可见
+        Function, // FuncLists 中的函数，返回后只有 r0 可见
+        Block     // CallLists 中的跳转块，返回后所有寄存器可见
+    };
+
+    // 单个 pass 的选项开关
+    struct Options {
+        bool constant_folding = true;
+        bool copy_propagation = true;
+        bool strength_reduction = true;
+        bool dead_code_elimination = true;
+        bool quickening = true; // 改写为免检查的快速指令与融合比较跳转
+        bool tail_calls = true; // 函数中的 CALL + RET 改写为 TAILCALL
+        bool inlining = true; // 把小函数的函数体展开到调用点
+        size_t inline_max_size = 12; // 可内联函数体的最大指令数（不含末尾 RET）
+        size_t inline_growth = 64; // 每个程序因内联最多增加的指令数
+        size_t max_rounds = 4; // 迭代至不动点的最大轮数
+        bool trap_handlers = false; // 其他程序中有 TRY，跳转块中的陷阱可能被上层帧捕获；optimizeVM 自动设置
+    };
+
+    // 单个 pass 的统计
+    struct PassStats {
+        std::string name;
+        size_t rewritten = 0; // 改写的指令数（内联为展开的调用点数）
+        size_t added = 0;     // 新增的指令数
+        size_t removed = 0;   // 删除的指令数
+    };
+
+    // 整体统计
+    struct Stats {
+        size_t before = 0; // 优化前指令数
+        size_t after = 0;  // 优化后指令数
+        std::vector<PassStats> passes;
+
+        /**
+         * 合并另一份统计
+         * @param other
+         * @return void
+         */
+        void merge(const Stats& other);
+
+        /**
+         * 打印统计
+         * @param out
+         * @return void
+         */
+        void print(std::ostream& out) const;
+    };
+
+    // 基本块，[begin, end) 为程序中的指令下标
+    struct BasicBlock {
+        size_t begin = 0;
+        size_t end = 0;
+        std::vector<size_t> preds; // 前驱块
+        std::vector<size_t> succs; // 后继块
+        bool exits = false;        // 是否可能离开当前程序
+    };
+
+    /**
+     * 构建基本块与 CFG
+     * 跳转块与函数调用在程序之外执行，这里视为块尾的屏障指令
+     * @param program
+     * @return std::vector<BasicBlock>
+     */
+    static std::vector<BasicBlock> buildBlocks(const std::vector<OpCodeImpl::Instruction>& program);
+
+    /**
+     * 优化单个程序
+     * @param program
+     * @param kind
+     * @param options
+     * @return Stats
+     */
+    static Stats optimize(std::vector<OpCodeImpl::Instruction>& program, ProgramKind kind,
+                          const Options& options);
+    static Stats optimize(std::vector<OpCodeImpl::Instruction>& program, ProgramKind kind) {
+        return optimize(program, kind, Options());
+    }
+
+    /**
+     * 优化入口程序以及 VM 中所有函数与跳转块
+     * @param vm
+     * @param entry
+     * @param options
+     * @return Stats
+     */
+    static Stats optimizeVM(RegisterVM& vm, std::vector<OpCodeImpl::Instruction>& entry,
+                            const Options& options);
+    static Stats optimizeVM(RegisterVM& vm, std::vector<OpCodeImpl::Instruction>& entry) {
+        return optimizeVM(vm, entry, Options());
+    }
+
+private:
+    /**
+     * 内联：把只含简单寄存器运算、RET 只在末尾的小函数展开到调用点
+     * 被调函数改写、调用点之后仍存活的寄存器改名为空闲寄存器，保持只有 r0 带回调用方；
+     * 调用点按被调函数的静态调用次数（热度）与大小排序，在每个程序的增长预算内展开
+     * @param vm
+     * @param entry
+     * @param options
+     * @return PassStats
+     */
+    static PassStats inlineCalls(RegisterVM& vm, std::vector<OpCodeImpl::Instruction>& entry, const Options& options);
+
+    /**
+     * 常量折叠，并把已知常量的寄存器操作数改写为立即数
+     * traps_visible 时可能陷入的指令保持原样，其后的常量事实全部作废
+     */
+    static size_t foldConstants(std::vector<OpCodeImpl::Instruction>& program, bool traps_visible);
+
+    /**
+     * 复制传播，删除冗余 MOVRR；traps_visible 时可能陷入的指令之后的复制事实全部作废
+     */
+    static size_t propagateCopies(std::vector<OpCodeImpl::Instruction>& program, bool traps_visible, size_t& removed);
+
+    /**
+     * 强度削减，乘 2 的幂改为移位，恒等运算删除
+     */
+    static size_t reduceStrength(std::vector<OpCodeImpl::Instruction>& program, size_t& removed);
+
+    /**
+     * 把不可能触发陷阱的 DIVI 改写为 DIVIQ，整数比较的 IFRR/IFRI 改写为融合比较跳转
+     */
+    static size_t quicken(std::vector<OpCodeImpl::Instruction>& program);
+
+    /**
+     * 尾调用：函数中紧跟 RET 或位于末尾的 CALL 改写为复用当前帧的 TAILCALL
+     */
+    static size_t formTailCalls(std::vector<OpCodeImpl::Instruction>& program, size_t& removed);
+
+    /**
+     * 基于活跃性的死代码消除；traps_visible 时可能陷入的指令处全部寄存器存活
+     */
+    static size_t eliminateDeadCode(std::vector<OpCodeImpl::Instruction>& program, ProgramKind kind, bool traps_visible);
+};
@@ -0,0 +1,146 @@
+/******************************************************
+-     Date:  2026.10.19 19:40
+-     File:  profiler.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "profiler.hpp"
+#include <fstream>
+
+const char* Profiler::clockName() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return "rdtsc";
+#else
+    return "ns";
+#endif
+}
+
+Profiler::CallStats* Profiler::callStats(FrameKind kind, size_t index) {
+    std::vector<CallStats>* table = nullptr;
+    if (kind == FrameKind::Function) table = &functions_;
+    else if (kind == FrameKind::VmCall) table = &vmcalls_;
+    else return nullptr;
+    if (table->size() <= index) table->resize(index + 1);
+    return &(*table)[index];
+}
+
+void Profiler::enter(FrameKind kind, size_t index) {
+    const size_t parent = stack_.empty() ? 0 : stack_.back().node;
+    const uint64_t key = (static_cast<uint64_t>(index) << 2) | static_cast<uint64_t>(kind);
+    auto it = nodes_[parent].children.find(key);
+    size_t node;
+    if (it == nodes_[parent].children.end()) {
+        node = nodes_.size();
+        Node created;
+        created.kind = kind;
+        created.index = index;
+        created.parent = parent;
+        nodes_.push_back(std::move(created));
+        nodes_[parent].children.emplace(key, node);
+    } else {
+        node = it->second;
+    }
+
+    if (CallStats* stats = callStats(kind, index)) {
+        stats->calls++;
+        stats->active++;
+    }
+    stack_.push_back({node, now(), 0});
+}
+
+void Profiler::exit() {
+    if (stack_.empty()) return;
+    const uint64_t tick = now();
+    Active frame = stack_.back();
+    stack_.pop_back();
+
+    const uint64_t inclusive = tick - frame.start;
+    Node& node = nodes_[frame.node];
+    node.self += inclusive > frame.child_cycles ? inclusive - frame.child_cycles : 0;
+    if (!stack_.empty()) stack_.back().child_cycles += inclusive;
+
+    if (CallStats* stats = callStats(node.kind, node.index)) {
+        if (--stats->active == 0) stats->inclusive += inclusive;
+    }
+    // 入口程序结束，结算最后一条指令，两次运行之间的时间不计入
+    if (stack_.empty() && last_op_ >= 0) {
+        ops_[last_op_].cycles += tick - last_tick_;
+        last_op_ = -1;
+    }
+}
+
+void Profiler::reset() {
+    for (auto& op : ops_) op = OpStats{};
+    functions_.clear();
+    vmcalls_.clear();
+    nodes_.assign(1, Node{});
+    stack_.clear();
+    last_tick_ = 0;
+    last_op_ = -1;
+}
+
+std::string Profiler::pathOf(size_t node) const {
+    std::string path;
+    while (node != 0) {
+        const Node& n = nodes_[node];
+        std::string name;
+        switch (n.kind) {
+            case FrameKind::Entry: name = "entry"; break;
+            case FrameKind::Function: name = "func#" + std::to_string(n.index); break;
+            case FrameKind::VmCall: name = "vmcall#" + std::to_string(n.index); break;
+        }
+        path = path.empty() ? name : name + ";" + path;
+        node = n.parent;
+    }
+    return path;
+}
+
+void Profiler::writeFolded(std::ostream& out) const {
+    for (size_t i = 1; i < nodes_.size(); ++i) {
+        if (nodes_[i].self == 0) continue;
+        out << pathOf(i) << " " << nodes_[i].self << "\n";
+    }
+}
+
+void Profiler::writeJson(std::ostream& out) const {
+    out << "{\n  \"clock\": \"" << clockName() << "\",\n  \"opcodes\": [";
+    bool first = true;
+    for (int op = 0; op < 256; ++op) {
+        if (ops_[op].count == 0) continue;
+        out << (first ? "\n" : ",\n") << "    {\"name\": \"" << OpCodeImpl::name(static_cast<OpCodeImpl::OpCode>(op))
+            << "\", \"count\": " << ops_[op].count << ", \"cycles\": " << ops_[op].cycles << "}";
+        first = false;
+    }
+    out << "\n  ],\n  \"functions\": [";
+    first = true;
+    for (size_t i = 0; i < functions_.size(); ++i) {
+        if (functions_[i].calls == 0) continue;
+        out << (first ? "\n" : ",\n") << "    {\"index\": " << i << ", \"calls\": " << functions_[i].calls
+            << ", \"inclusive_cycles\": " << functions_[i].inclusive << "}";
+        first = false;
+    }
+    out << "\n  ],\n  \"vmcalls\": [";
+    first = true;
+    for (size_t i = 0; i < vmcalls_.size(); ++i) {
+        if (vmcalls_[i].calls == 0) continue;
+        out << (first ? "\n" : ",\n") << "    {\"index\": " << i << ", \"calls\": " << vmcalls_[i].calls
+            << ", \"total_cycles\": " << vmcalls_[i].inclusive
+            << ", \"mean_cycles\": " << vmcalls_[i].inclusive / vmcalls_[i].calls << "}";
+        first = false;
+    }
+    out << "\n  ]\n}\n";
+}
+
+bool Profiler::writeFiles(const std::string& folded_path, const std::string& json_path) const {
+    if (!folded_path.empty()) {
+        std::ofstream out(folded_path);
+        if (!out) return false;
+        writeFolded(out);
+    }
+    if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        if (!out) return false;
+        writeJson(out);
+    }
+    return true;
+}
@@ -0,0 +1,177 @@
+/******************************************************
+-     Date:  2026.10.19 19:40
+-     File:  profiler.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include "../opcode.hpp"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * 执行剖析器
+ * 仅在定义 LMVM_PROFILE 时编入解释器（CMake 选项 ENABLE_PROFILER），
+ * 关闭时埋点宏展开为空，没有任何开销
+ */
+class Profiler {
+public:
+    // 调用栈帧种类
+    enum class FrameKind : uint8_t {
+        Entry,    // 入口程序
+        Function, // FuncLists 中的函数
+        VmCall    // VMCALL 处理函数
+    };
+
+    /**
+     * 读取时钟（x86 上为 rdtsc 周期数，其他平台为纳秒）
+     * @return uint64_t
+     */
+    static uint64_t now() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    /**
+     * 时钟单位名称
+     * @return const char*
+     */
+    static const char* clockName();
+
+    /**
+     * 记录一条指令，上一条指令的耗时记到上一条的操作码上
+     * @param op
+     * @return void
+     */
+    void onInstruction(OpCodeImpl::OpCode op) {
+        const uint64_t tick = now();
+        if (last_op_ >= 0) ops_[last_op_].cycles += tick - last_tick_;
+        last_op_ = static_cast<int>(op);
+        ops_[last_op_].count++;
+        last_tick_ = tick;
+    }
+
+    /**
+     * 进入一帧
+     * @param kind
+     * @param index
+     * @return void
+     */
+    void enter(FrameKind kind, size_t index);
+
+    /**
+     * 离开当前帧
+     * @return void
+     */
+    void exit();
+
+    /**
+     * 清空所有统计
+     * @return void
+     */
+    void reset();
+
+    /**
+     * 输出火焰图折叠栈格式（每行 "entry;func#1;vmcall#0 自身耗时"）
+     * @param out
+     * @return void
+     */
+    void writeFolded(std::ostream& out) const;
+
+    /**
+     * 输出 JSON 汇总
+     * @param out
+     * @return void
+     */
+    void writeJson(std::ostream& out) const;
+
+    /**
+     * 写入文件
+     * @param folded_path 为空时不写
+     * @param json_path 为空时不写
+     * @return bool
+     */
+    bool writeFiles(const std::string& folded_path, const std::string& json_path) const;
+
+    /**
+     * 帧作用域，异常展开时也能正确离开
+     */
+    class Scope {
+    public:
+        Scope(Profiler& profiler, FrameKind kind, size_t index) : profiler_(profiler) {
+            profiler_.enter(kind, index);
+        }
+        ~Scope() { profiler_.exit(); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        Profiler& profiler_;
+    };
+
+private:
+    struct OpStats {
+        uint64_t count = 0;
+        uint64_t cycles = 0; // 独占耗时
+    };
+
+    struct CallStats {
+        uint64_t calls = 0;
+        uint64_t inclusive = 0; // 含子调用的耗时，递归只计最外层
+        uint32_t active = 0;    // 正在执行的层数
+    };
+
+    // 调用路径树节点
+    struct Node {
+        FrameKind kind = FrameKind::Entry;
+        size_t index = 0;
+        size_t parent = 0;
+        uint64_t self = 0; // 自身耗时
+        std::unordered_map<uint64_t, size_t> children;
+    };
+
+    struct Active {
+        size_t node;
+        uint64_t start;
+        uint64_t child_cycles;
+    };
+
+    OpStats ops_[256];
+    std::vector<CallStats> functions_;
+    std::vector<CallStats> vmcalls_;
+    std::vector<Node> nodes_{Node{}}; // 0 号为虚拟根
+    std::vector<Active> stack_;
+    uint64_t last_tick_ = 0;
+    int last_op_ = -1;
+
+    /**
+     * 获取帧的统计项
+     */
+    CallStats* callStats(FrameKind kind, size_t index);
+
+    /**
+     * 节点所在路径的名称
+     */
+    std::string pathOf(size_t node) const;
+};
+
+#ifdef LMVM_PROFILE
+#define LMVM_PROFILE_OP(vm, op) (vm).profiler.onInstruction(op)
+#define LMVM_PROFILE_SCOPE(vm, kind, index) Profiler::Scope lmvm_profile_scope_((vm).profiler, kind, index)
+#else
+#define LMVM_PROFILE_OP(vm, op) ((void)0)
+#define LMVM_PROFILE_SCOPE(vm, kind, index) ((void)0)
+#endif
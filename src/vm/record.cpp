@@ -0,0 +1,20 @@
+/******************************************************
+-     Date:  2026.10.24 15:20
+-     File:  record.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "record.hpp"
+
+int64_t Shape::offset_of(int64_t field) const {
+    for (const Shape* shape = this; shape->parent_ != nullptr; shape = shape->parent_) {
+        if (shape->field_ == field) return shape->field_count_ - 1;
+    }
+    return -1;
+}
+
+const Shape* Shape::transition(int64_t field) const {
+    auto& child = transitions_[field];
+    if (!child) child = std::make_unique<Shape>(this, field);
+    return child.get();
+}
@@ -0,0 +1,133 @@
+/******************************************************
+-     Date:  2026.10.24 15:20
+-     File:  record.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include "models.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 隐藏类：记录按相同顺序添加相同字段时共享同一个 Shape
+ * 每个 Shape 在父 Shape 的基础上多一个字段，子 Shape 挂在父 Shape 的转移表上，形成一棵树；
+ * 字段在记录中的偏移就是它在链上的位置。Shape 由根节点所在的 ShapeTree 持有，与虚拟机同生命周期
+ */
+class Shape {
+public:
+    /**
+     * 构造函数
+     * @param parent 根节点为 nullptr
+     * @param field 新增的字段编号
+     */
+    Shape(const Shape* parent, int64_t field)
+        : parent_(parent), field_(field), field_count_(parent ? parent->field_count_ + 1 : 0) {}
+
+    Shape(const Shape&) = delete;
+    Shape& operator=(const Shape&) = delete;
+
+    /**
+     * 字段的偏移，不存在时返回 -1
+     * @param field
+     * @return int64_t
+     */
+    [[nodiscard]] int64_t offset_of(int64_t field) const;
+
+    /**
+     * 添加字段后的 Shape，转移不存在时创建
+     * @param field 必须不在当前 Shape 中
+     * @return const Shape*
+     */
+    const Shape* transition(int64_t field) const;
+
+    /**
+     * 字段个数
+     * @return uint32_t
+     */
+    [[nodiscard]] uint32_t field_count() const { return field_count_; }
+
+private:
+    const Shape* parent_;
+    int64_t field_;         // 本节点新增的字段，偏移为 field_count_ - 1
+    uint32_t field_count_;
+    mutable std::unordered_map<int64_t, std::unique_ptr<Shape>> transitions_; // 转移树
+};
+
+/**
+ * 记录：Shape 加上按偏移存放的字段值，值为寄存器中的原始 64 位
+ */
+class LmRecord : public LmHeapObject {
+public:
+    /**
+     * 构造函数
+     * @param shape 空记录的 Shape（转移树的根）
+     * @param capacity 预计字段数
+     */
+    LmRecord(const Shape* shape, size_t capacity) : LmHeapObject(HeapObjType::Record), shape_(shape) {
+        slots_.reserve(capacity);
+    }
+
+    /**
+     * 获取 Shape
+     * @return const Shape*
+     */
+    [[nodiscard]] const Shape* shape() const { return shape_; }
+
+    /**
+     * 读取偏移处的字段
+     * @param offset
+     * @return int64_t
+     */
+    [[nodiscard]] int64_t get(uint32_t offset) const { return slots_[offset]; }
+
+    /**
+     * 写入偏移处的字段
+     * @param offset
+     * @param value
+     * @return void
+     */
+    void set(uint32_t offset, int64_t value) { slots_[offset] = value; }
+
+    /**
+     * 追加字段并切换到添加后的 Shape
+     * @param shape 必须是当前 Shape 的转移
+     * @param value
+     * @return void
+     */
+    void add(const Shape* shape, int64_t value) {
+        slots_.push_back(value);
+        shape_ = shape;
+    }
+
+private:
+    const Shape* shape_;
+    std::vector<int64_t> slots_;
+};
+
+/**
+ * GETFIELD/SETFIELD 的调用点内联缓存，最多记住 WAYS 个 Shape（单态/多态），满了以后轮换替换
+ * 命中时只需比较 Shape 并按偏移读写；SETFIELD 添加字段时同时记住转移后的 Shape
+ */
+struct FieldCache {
+    static constexpr size_t WAYS = 4;
+
+    struct Entry {
+        const Shape* shape = nullptr; // 记录当前的 Shape
+        const Shape* next = nullptr;  // 写入后的 Shape，字段已存在时与 shape 相同
+        uint32_t offset = 0;
+    };
+
+    Entry entries[WAYS];
+    uint32_t count = 0; // 累计填入次数，决定下一个替换位置
+
+    /**
+     * 填入一项
+     * @param entry
+     * @return void
+     */
+    void insert(const Entry& entry) { entries[count++ % WAYS] = entry; }
+};
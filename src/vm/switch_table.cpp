@@ -0,0 +1,80 @@
+/******************************************************
+-     Date:  2026.10.26 10:10
+-     File:  switch_table.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "switch_table.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    void put32(std::vector<int8_t>& out, int32_t value) {
+        const auto bits = static_cast<uint32_t>(value);
+        for (int i = 0; i < 4; ++i) out.push_back(static_cast<int8_t>(bits >> (8 * i)));
+    }
+
+    int32_t get32(const int8_t* in) {
+        uint32_t bits = 0;
+        for (int i = 0; i < 4; ++i) bits |= static_cast<uint32_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+        return static_cast<int32_t>(bits);
+    }
+}
+
+SwitchTable::SwitchTable(const std::vector<int8_t>& data, int64_t default_block) : default_(default_block) {
+    std::vector<Case> cases = decode(data);
+    if (cases.empty()) {
+        dense_ = true;
+        return;
+    }
+    const int64_t low = cases.front().first;
+    const int64_t high = cases.back().first;
+    const auto span = static_cast<uint64_t>(high - low) + 1;
+    dense_ = span <= SMALL_SPAN || span <= 2 * static_cast<uint64_t>(cases.size());
+    if (dense_) {
+        low_ = low;
+        blocks_.assign(span, default_);
+        for (const auto& [key, block] : cases) blocks_[static_cast<size_t>(key - low)] = block;
+        return;
+    }
+    keys_.reserve(cases.size());
+    blocks_.reserve(cases.size());
+    for (const auto& [key, block] : cases) {
+        keys_.push_back(key);
+        blocks_.push_back(block);
+    }
+}
+
+std::vector<int8_t> SwitchTable::encode(const std::vector<Case>& cases) {
+    std::vector<int8_t> data;
+    data.reserve(cases.size() * CASE_BYTES);
+    for (const auto& [key, block] : cases) {
+        put32(data, key);
+        put32(data, block);
+    }
+    return data;
+}
+
+std::vector<SwitchTable::Case> SwitchTable::decode(const std::vector<int8_t>& data) {
+    if (data.size() % CASE_BYTES != 0) {
+        throw std::runtime_error("switch case list is not a multiple of " + std::to_string(CASE_BYTES) + " bytes");
+    }
+    std::vector<Case> cases;
+    cases.reserve(data.size() / CASE_BYTES);
+    for (size_t at = 0; at < data.size(); at += CASE_BYTES) {
+        cases.emplace_back(get32(data.data() + at), get32(data.data() + at + 4));
+    }
+    std::sort(cases.begin(), cases.end());
+    const auto dup = std::adjacent_find(cases.begin(), cases.end(),
+                                        [](const Case& a, const Case& b) { return a.first == b.first; });
+    if (dup != cases.end()) throw std::runtime_error("duplicate switch case: " + std::to_string(dup->first));
+    return cases;
+}
+
+int64_t SwitchTable::search(int64_t key) const {
+    if (key < INT32_MIN || key > INT32_MAX) return default_;
+    const auto it = std::lower_bound(keys_.begin(), keys_.end(), static_cast<int32_t>(key));
+    if (it == keys_.end() || *it != key) return default_;
+    return blocks_[static_cast<size_t>(it - keys_.begin())];
+}
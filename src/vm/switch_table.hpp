@@ -0,0 +1,79 @@
+/******************************************************
+-     Date:  2026.10.26 10:10
+-     File:  switch_table.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * SWITCH 的跳转表，由指令 data 中的分支列表编译得到
+ * 分支值至少占跨度的一半时建成以最小值为基址的平铺数组，一次减法与比较即可取到跳转块；
+ * 稀疏时按分支值排序后二分查找
+ */
+class SwitchTable {
+public:
+    static constexpr size_t CASE_BYTES = 8;  // 每个分支：int32 分支值 + int32 跳转块下标，小端
+    static constexpr size_t SMALL_SPAN = 16; // 分支值跨度不超过它时总是平铺
+
+    using Case = std::pair<int32_t, int32_t>; // 分支值，跳转块下标
+
+    /**
+     * 编译跳转表，分支列表不合法时抛出 std::runtime_error
+     * @param data 指令 data 中的分支列表
+     * @param default_block 没有匹配分支时的跳转块，-1 表示不跳转
+     */
+    SwitchTable(const std::vector<int8_t>& data, int64_t default_block);
+
+    /**
+     * 把分支列表编码为指令 data
+     * @param cases
+     * @return std::vector<int8_t>
+     */
+    static std::vector<int8_t> encode(const std::vector<Case>& cases);
+
+    /**
+     * 解码指令 data 中的分支列表，长度不是 CASE_BYTES 的倍数或分支值重复时抛出 std::runtime_error
+     * @param data
+     * @return std::vector<Case>
+     */
+    static std::vector<Case> decode(const std::vector<int8_t>& data);
+
+    /**
+     * 分支值对应的跳转块，没有匹配分支时返回默认块（可能为 -1）
+     * @param key
+     * @return int64_t
+     */
+    [[nodiscard]] int64_t target(int64_t key) const {
+        if (dense_) {
+            // 无符号减法把小于基址的值也变成越界，一次比较
+            const uint64_t slot = static_cast<uint64_t>(key) - static_cast<uint64_t>(low_);
+            return slot < blocks_.size() ? blocks_[slot] : default_;
+        }
+        return search(key);
+    }
+
+    /**
+     * 是否编译为平铺数组
+     * @return bool
+     */
+    [[nodiscard]] bool dense() const { return dense_; }
+
+private:
+    bool dense_ = false;
+    int64_t low_ = 0;              // 平铺数组的基址
+    int64_t default_ = -1;
+    std::vector<int32_t> keys_;    // 稀疏时排序后的分支值
+    std::vector<int64_t> blocks_;  // 平铺数组的各槽位（空洞为默认块），或与 keys_ 对应的跳转块
+
+    /**
+     * 稀疏表的二分查找
+     * @param key
+     * @return int64_t
+     */
+    [[nodiscard]] int64_t search(int64_t key) const;
+};
@@ -0,0 +1,128 @@
+/******************************************************
+-     Date:  2026.10.27 15:30
+-     File:  task.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "task.hpp"
+#include "handler.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#define LMVM_HAS_UCONTEXT 1
+#endif
+
+namespace {
+    // 析构时从挂起点抛出，只在任务栈内传播；不继承 std::exception，不会被中途的 catch 吞掉
+    struct TaskCancelled {};
+
+    // makecontext 只能传 int 参数，启动中的任务经它交给入口
+    thread_local VmTask* starting_task = nullptr;
+}
+
+#ifdef LMVM_HAS_UCONTEXT
+struct VmTask::Context {
+    ucontext_t host{};
+    ucontext_t task{};
+    void* stack = nullptr;
+    size_t mapped = 0;
+
+    ~Context() {
+        if (stack != nullptr) munmap(stack, mapped);
+    }
+};
+
+VmTask::VmTask(RegisterVM& vm, const std::vector<OpCodeImpl::Instruction>& entry, size_t stack_size)
+    : vm_(vm), entry_(entry), context_(std::make_unique<Context>()) {
+    // 栈底留一页不可访问的保护页，溢出时立即出错而不是改写别的内存
+    const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t usable = (stack_size + page - 1) / page * page;
+    context_->mapped = usable + page;
+    void* stack = mmap(nullptr, context_->mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (stack == MAP_FAILED) throw std::runtime_error("failed to allocate task stack");
+    context_->stack = stack;
+    if (mprotect(stack, page, PROT_NONE) != 0) throw std::runtime_error("failed to protect task stack");
+
+    if (getcontext(&context_->task) != 0) throw std::runtime_error("getcontext failed");
+    context_->task.uc_stack.ss_sp = static_cast<char*>(stack) + page;
+    context_->task.uc_stack.ss_size = usable;
+    context_->task.uc_link = &context_->host; // 入口返回时回到最近一次 resume 的宿主
+    makecontext(&context_->task, &VmTask::start, 0);
+    stack_floor_ = reinterpret_cast<uintptr_t>(context_->task.uc_stack.ss_sp) + RegisterVM::STACK_RESERVE;
+    vm_.fuel = 0;
+}
+
+VmTask::~VmTask() {
+    if (state_ != State::Suspended) return;
+    cancelling_ = true;
+    try {
+        resume(0);
+    } catch (...) {
+        // 展开中抛出的异常在析构时无处报告
+    }
+}
+
+VmTask::State VmTask::resume(int64_t fuel) {
+    if (state_ == State::Finished) throw std::runtime_error("task has already finished");
+    if (vm_.task != nullptr) throw std::runtime_error("VM is already running in a task");
+    // 燃料在挂起时为负，补充后先抵掉欠下的部分；溢出时按不限制处理
+    vm_.fuel = fuel > RegisterVM::UNLIMITED_FUEL - std::max<int64_t>(vm_.fuel, 0) ? RegisterVM::UNLIMITED_FUEL
+                                                                                   : vm_.fuel + fuel;
+    RegisterVM* previous_vm = Handler::current_vm;
+    Handler::current_vm = &vm_;
+    vm_.task = this;
+    // 解释帧运行在任务栈上，按它的栈底检查栈空间
+    const uintptr_t stack_floor = vm_.stack_floor;
+    vm_.stack_floor = stack_floor_;
+    if (state_ == State::Ready) starting_task = this;
+    state_ = State::Suspended; // 任务栈上结束时改为 Finished
+    swapcontext(&context_->host, &context_->task);
+    vm_.stack_floor = stack_floor;
+    vm_.task = nullptr;
+    Handler::current_vm = previous_vm;
+    if (state_ == State::Finished) vm_.fuel = RegisterVM::UNLIMITED_FUEL;
+    if (error_) {
+        std::exception_ptr error = std::exchange(error_, nullptr);
+        std::rethrow_exception(error);
+    }
+    return state_;
+}
+
+void VmTask::suspend() {
+    swapcontext(&context_->task, &context_->host);
+    if (cancelling_) throw TaskCancelled{};
+}
+
+void VmTask::start() {
+    VmTask* self = std::exchange(starting_task, nullptr);
+    try {
+        if (self->vm_.verified_entry == &self->entry_) self->vm_.runVerified(self->entry_);
+        else self->vm_.run(self->entry_);
+    } catch (const TaskCancelled&) {
+        // 解释帧已经展开
+    } catch (...) {
+        self->error_ = std::current_exception();
+    }
+    self->state_ = State::Finished;
+}
+#else
+struct VmTask::Context {};
+
+VmTask::VmTask(RegisterVM& vm, const std::vector<OpCodeImpl::Instruction>& entry, size_t)
+    : vm_(vm), entry_(entry) {
+    throw std::runtime_error("VmTask requires ucontext support on this platform");
+}
+
+VmTask::~VmTask() = default;
+
+VmTask::State VmTask::resume(int64_t) { return state_; }
+
+void VmTask::suspend() {}
+
+void VmTask::start() {}
+#endif
@@ -0,0 +1,84 @@
+/******************************************************
+-     Date:  2026.10.27 15:30
+-     File:  task.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include "vm.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <vector>
+
+/**
+ * 可挂起的执行任务：在独立的栈上运行虚拟机，燃料耗尽时挂起并回到宿主，补充燃料后从挂起处继续
+ * 解释器按跳转块与函数递归，挂起时这些解释帧原样留在任务的栈上。同一进程可以为每个租户建一个任务，
+ * 按时间片轮流 resume；任务运行期间 Handler::current_vm 指向它的虚拟机，VMCALL 作用在正确的租户上
+ *
+ * 任务必须在创建它的线程上 resume；挂起中的任务析构时在其栈上展开全部解释帧，虚拟机可以继续使用
+ */
+class VmTask {
+public:
+    static constexpr size_t DEFAULT_STACK_SIZE = 8 << 20; // 与主线程默认栈相同，按需提交
+
+    enum class State {
+        Ready,     // 尚未开始
+        Suspended, // 燃料耗尽，等待 resume
+        Finished   // 入口程序结束、VMCALL 2 退出或抛出异常
+    };
+
+    /**
+     * 构造函数，虚拟机的燃料清零，由 resume 补充，任务结束后恢复为不限制；entry 已通过校验时以 runVerified 运行
+     * @param vm
+     * @param entry 任务结束前必须保持有效
+     * @param stack_size
+     */
+    VmTask(RegisterVM& vm, const std::vector<OpCodeImpl::Instruction>& entry, size_t stack_size = DEFAULT_STACK_SIZE);
+
+    /**
+     * 析构函数，挂起中的任务先展开其解释帧
+     */
+    ~VmTask();
+
+    VmTask(const VmTask&) = delete;
+    VmTask& operator=(const VmTask&) = delete;
+
+    /**
+     * 补充燃料并运行到挂起或结束；虚拟机抛出的异常在这里重新抛出，任务随之结束
+     * @param fuel 本时间片的燃料，先抵掉挂起时欠下的部分
+     * @return State Suspended 或 Finished
+     */
+    State resume(int64_t fuel);
+
+    /**
+     * 当前状态
+     * @return State
+     */
+    [[nodiscard]] State state() const { return state_; }
+
+private:
+    friend class RegisterVM;
+    struct Context;
+
+    RegisterVM& vm_;
+    const std::vector<OpCodeImpl::Instruction>& entry_;
+    State state_ = State::Ready;
+    uintptr_t stack_floor_ = 0; // 任务栈底加上预留，解释帧不能越过
+    bool cancelling_ = false;   // 析构时要求挂起点抛出展开
+    std::exception_ptr error_;  // 任务栈上抛出的异常，回到宿主后重新抛出
+    std::unique_ptr<Context> context_;
+
+    /**
+     * 由 RegisterVM::outOfFuel 调用：切回宿主，恢复后若正在析构则抛出以展开解释帧
+     * @return void
+     */
+    void suspend();
+
+    /**
+     * 任务栈的入口
+     * @return void
+     */
+    static void start();
+};
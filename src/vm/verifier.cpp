@@ -0,0 +1,205 @@
+/******************************************************
+-     Date:  2026.10.19 14:20
+-     File:  verifier.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "verifier.hpp"
+#include "vm.hpp"
+#include <algorithm>
+
+void Verifier::fail(const std::string& name, size_t index, const std::string& reason) {
+    throw VerifyError("Verify Error: " + name + "[" + std::to_string(index) + "]: " + reason);
+}
+
+int64_t Verifier::verify(const RegisterVM& vm, const std::vector<OpCodeImpl::Instruction>& entry) {
+    int64_t max_mem = verifyProgram(vm, entry, "entry");
+    for (size_t i = 0; i < vm.FuncLists.size(); ++i) {
+        // 延迟加载的函数在首次调用时单独校验
+        if (i < vm.pending_funcs.size() && vm.pending_funcs[i]) continue;
+        max_mem = std::max(max_mem, verifyProgram(vm, vm.FuncLists[i], "func#" + std::to_string(i)));
+    }
+    for (size_t i = 0; i < vm.CallLists.size(); ++i) {
+        max_mem = std::max(max_mem, verifyProgram(vm, vm.CallLists[i], "call#" + std::to_string(i)));
+    }
+    return max_mem;
+}
+
+int64_t Verifier::verifyProgram(const RegisterVM& vm, const std::vector<OpCodeImpl::Instruction>& program,
+                                const std::string& name) {
+    using OpCode = OpCodeImpl::OpCode;
+    int64_t max_mem = -1;
+
+    for (size_t i = 0; i < program.size(); ++i) {
+        const OpCodeImpl::Instruction& instr = program[i];
+        if (instr.rd >= NUM_REGS || instr.rs >= NUM_REGS) {
+            fail(name, i, "invalid register number");
+        }
+
+        auto check_mem = [&] {
+            if (instr.mem < 0 || instr.mem > MAX_STATIC_HEAP_ADDR) fail(name, i, "heap address out of range");
+            max_mem = std::max(max_mem, instr.mem);
+        };
+
+        switch (instr.op) {
+            case OpCode::HALT:
+            case OpCode::RET:
+            case OpCode::MOVRI:
+            case OpCode::MOVRM:
+            case OpCode::MOVRR:
+            case OpCode::ADDR: case OpCode::ADDI:
+            case OpCode::SUBR: case OpCode::SUBI:
+            case OpCode::MULR: case OpCode::MULI:
+            case OpCode::DIVR: case OpCode::DIVI:
+                break;
+            case OpCode::MOVMI:
+            case OpCode::MOVMR:
+            case OpCode::ADDM:
+            case OpCode::SUBM:
+            case OpCode::MULM:
+            case OpCode::DIVM:
+                check_mem();
+                break;
+            case OpCode::MOVMM:
+                check_mem();
+                if (instr.imm < 0 || instr.imm >= NUM_REGS) fail(name, i, "invalid source register in imm");
+                break;
+            case OpCode::NEW:
+                if (instr.data.empty()) fail(name, i, "NEW without data");
+                break;
+            case OpCode::CALL: case OpCode::TAILCALL:
+                if (instr.imm < 0 || static_cast<size_t>(instr.imm) >= vm.FuncLists.size()) {
+                    fail(name, i, "call target out of range: " + std::to_string(instr.imm));
+                }
+                break;
+            case OpCode::NEWF:
+                if (instr.imm < 0 || static_cast<size_t>(instr.imm) >= vm.FuncLists.size()) {
+                    fail(name, i, "function index out of range: " + std::to_string(instr.imm));
+                }
+                for (int8_t reg : instr.data) {
+                    if (reg < 0 || reg >= NUM_REGS) fail(name, i, "invalid capture register: " + std::to_string(reg));
+                }
+                break;
+            case OpCode::CALLR:
+                // 函数对象与捕获值个数只能在运行期检查
+                if (instr.imm < 0 || instr.imm > NUM_REGS) fail(name, i, "invalid capture register in imm");
+                break;
+            case OpCode::IFRR:
+                if (instr.imm < 0 || static_cast<size_t>(instr.imm) >= vm.CallLists.size()) {
+                    fail(name, i, "branch target out of range: " + std::to_string(instr.imm));
+                }
+                if (instr.data.empty()) fail(name, i, "IFRR without comparison code");
+                if (instr.data[0] < 0 || instr.data[0] >= 2 * OpCodeImpl::CMP_COUNT) {
+                    fail(name, i, "unknown comparison code: " + std::to_string(instr.data[0]));
+                }
+                break;
+            case OpCode::IFRI:
+                if (instr.imm < 0 || static_cast<size_t>(instr.imm) >= vm.CallLists.size()) {
+                    fail(name, i, "branch target out of range: " + std::to_string(instr.imm));
+                }
+                if (instr.data.empty()) fail(name, i, "IFRI without comparison code");
+                // 立即数是整数，没有按 double 比较的形式
+                if (instr.data[0] < 0 || instr.data[0] >= OpCodeImpl::CMP_COUNT) {
+                    fail(name, i, "unknown comparison code: " + std::to_string(instr.data[0]));
+                }
+                break;
+            case OpCode::JEQ: case OpCode::JNE: case OpCode::JGT: case OpCode::JLT: case OpCode::JGE: case OpCode::JLE:
+            case OpCode::JEQI: case OpCode::JNEI: case OpCode::JGTI: case OpCode::JLTI: case OpCode::JGEI: case OpCode::JLEI:
+                if (instr.imm < 0 || static_cast<size_t>(instr.imm) >= vm.CallLists.size()) {
+                    fail(name, i, "branch target out of range: " + std::to_string(instr.imm));
+                }
+                break;
+            case OpCode::SWITCH: {
+                if (instr.imm < -1 || instr.imm >= static_cast<int64_t>(vm.CallLists.size())) {
+                    fail(name, i, "default branch target out of range: " + std::to_string(instr.imm));
+                }
+                std::vector<SwitchTable::Case> cases;
+                try {
+                    cases = SwitchTable::decode(instr.data);
+                } catch (const std::runtime_error& e) {
+                    fail(name, i, e.what());
+                }
+                for (const auto& [key, block] : cases) {
+                    if (block < 0 || static_cast<size_t>(block) >= vm.CallLists.size()) {
+                        fail(name, i, "branch target out of range for case " + std::to_string(key) + ": " + std::to_string(block));
+                    }
+                }
+                break;
+            }
+            case OpCode::TRY:
+                if (instr.imm < 0 || static_cast<size_t>(instr.imm) >= vm.CallLists.size()) {
+                    fail(name, i, "trap handler out of range: " + std::to_string(instr.imm));
+                }
+                break;
+            case OpCode::ENDTRY:
+                break;
+            case OpCode::AFILL: case OpCode::ACOPY:
+            case OpCode::AADDR: case OpCode::AADDA:
+            case OpCode::ASUBR: case OpCode::ASUBA:
+            case OpCode::AMULR: case OpCode::AMULA:
+            case OpCode::ASUM: case OpCode::AMIN: case OpCode::AMAX:
+            case OpCode::AFIND: case OpCode::ACMP:
+                // 数组地址在寄存器中，只能在运行期检查
+                break;
+            case OpCode::LDI8: case OpCode::LDI32: case OpCode::LDI64: case OpCode::LDF64:
+            case OpCode::STI8: case OpCode::STI32: case OpCode::STI64: case OpCode::STF64:
+                if (instr.imm < 0 || instr.imm >= NUM_REGS) fail(name, i, "invalid index register in imm");
+                break;
+            case OpCode::ADDF: case OpCode::SUBF: case OpCode::MULF: case OpCode::DIVF:
+                break;
+            case OpCode::LDX: case OpCode::STX:
+                // 对象类型与下标范围取决于寄存器中的地址，只能在运行期检查
+                break;
+            case OpCode::LDC:
+                if (instr.imm < 0 || !vm.constants || static_cast<uint64_t>(instr.imm) >= vm.constants->size()) {
+                    fail(name, i, "constant index out of range: " + std::to_string(instr.imm));
+                }
+                break;
+            case OpCode::MNEW:
+                if (instr.imm < 0) fail(name, i, "negative map capacity");
+                break;
+            case OpCode::NEWR:
+                if (instr.imm < 0) fail(name, i, "negative record capacity");
+                break;
+            case OpCode::GETFIELD: case OpCode::SETFIELD:
+                if (instr.imm < 0) fail(name, i, "negative field id");
+                break;
+            case OpCode::MGET: case OpCode::MPUT: case OpCode::MDEL:
+                if ((instr.imm & ~(OpCodeImpl::MAP_KEY_STRING | OpCodeImpl::MAP_KEY_REG)) != 0) {
+                    fail(name, i, "invalid map key operand in imm");
+                }
+                break;
+            case OpCode::MNEXT:
+                if (instr.imm < 0 || instr.imm >= NUM_REGS) fail(name, i, "invalid cursor register in imm");
+                if (instr.imm == instr.rd) fail(name, i, "MNEXT cursor register must differ from rd");
+                break;
+            case OpCode::CVT:
+                if (instr.imm < 0 || instr.imm >= OpCodeImpl::CVT_MODE_COUNT) {
+                    fail(name, i, "unknown CVT mode: " + std::to_string(instr.imm));
+                }
+                break;
+            case OpCode::NEWT:
+                if (instr.imm < 0 || instr.imm >= LmTypedArray::KIND_COUNT) {
+                    fail(name, i, "unknown typed array kind: " + std::to_string(instr.imm));
+                } else if (instr.data.size() % LmTypedArray::element_width(LmTypedArray::type_of(instr.imm)) != 0) {
+                    fail(name, i, "typed array data is not a multiple of the element width");
+                }
+                break;
+            case OpCode::DIVIQ:
+                if (instr.imm == 0 || instr.imm == -1) fail(name, i, "DIVIQ divisor may trap");
+                break;
+            case OpCode::SHLI:
+                if (instr.imm < 0 || instr.imm > 63) fail(name, i, "shift amount out of range");
+                break;
+            case OpCode::VMCALL:
+                if (instr.imm < 0 || instr.imm > UINT8_MAX
+                    || RegisterVM::vm_call_handlers.find(static_cast<uint8_t>(instr.imm)) == RegisterVM::vm_call_handlers.end()) {
+                    fail(name, i, "VMCALL handler not registered: " + std::to_string(instr.imm));
+                }
+                break;
+            default:
+                fail(name, i, "unknown opcode: " + std::to_string(static_cast<int>(instr.op)));
+        }
+    }
+    return max_mem;
+}
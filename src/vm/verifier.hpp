@@ -0,0 +1,61 @@
+/******************************************************
+-     Date:  2026.10.19 14:20
+-     File:  verifier.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include "../opcode.hpp"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class RegisterVM;
+
+/**
+ * 校验失败异常，携带出错的程序与指令位置
+ */
+class VerifyError : public std::runtime_error {
+public:
+    explicit VerifyError(const std::string& what) : std::runtime_error(what) {}
+};
+
+/**
+ * 加载期字节码校验器
+ * 一次性检查寄存器编号、跳转/调用目标、比较码与操作数，
+ * 通过后解释器可以去掉逐条指令的检查
+ */
+class Verifier {
+public:
+    // 程序中允许静态引用的最大堆地址
+    static constexpr int64_t MAX_STATIC_HEAP_ADDR = 1 << 20;
+
+    /**
+     * 校验入口程序以及 VM 中所有函数与跳转块
+     * @param vm
+     * @param entry
+     * @return int64_t 程序静态引用的最大堆地址，没有时返回 -1
+     */
+    static int64_t verify(const RegisterVM& vm, const std::vector<OpCodeImpl::Instruction>& entry);
+
+    /**
+     * 校验单个程序
+     * @param vm
+     * @param program
+     * @param name 用于错误信息的程序名
+     * @return int64_t 程序静态引用的最大堆地址，没有时返回 -1
+     */
+    static int64_t verifyProgram(const RegisterVM& vm, const std::vector<OpCodeImpl::Instruction>& program,
+                                 const std::string& name);
+
+private:
+    /**
+     * 抛出校验错误
+     * @param name
+     * @param index
+     * @param reason
+     * @return void
+     */
+    [[noreturn]] static void fail(const std::string& name, size_t index, const std::string& reason);
+};
@@ -5,10 +5,55 @@
 -     This project is followed GPL-3.0 license
 ********************************************************/
 #include "vm.hpp"
+#include "array_ops.hpp"
+#include "verifier.hpp"
+#include "task.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <iostream>
 #include <string>
+#include <type_traits>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <pthread.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#endif
 
 std::map<uint8_t, std::function<void(const OpCodeImpl::Instruction*)>> RegisterVM::vm_call_handlers;
+
+namespace {
+    /**
+     * 当前线程栈的最低地址加上 STACK_RESERVE，解释帧越过它时抛出 VmStackOverflow；平台不支持时为 0（不检查）
+     * @return uintptr_t
+     */
+    uintptr_t hostStackFloor() {
+        thread_local const uintptr_t floor = []() -> uintptr_t {
+#if defined(__linux__)
+            pthread_attr_t attr;
+            if (pthread_getattr_np(pthread_self(), &attr) != 0) return 0;
+            void* low = nullptr;
+            size_t size = 0;
+            const int rc = pthread_attr_getstack(&attr, &low, &size);
+            pthread_attr_destroy(&attr);
+            return rc == 0 ? reinterpret_cast<uintptr_t>(low) + RegisterVM::STACK_RESERVE : 0;
+#elif defined(__APPLE__)
+            const auto high = reinterpret_cast<uintptr_t>(pthread_get_stackaddr_np(pthread_self()));
+            return high - pthread_get_stacksize_np(pthread_self()) + RegisterVM::STACK_RESERVE;
+#elif defined(_WIN32)
+            ULONG_PTR low = 0;
+            ULONG_PTR high = 0;
+            GetCurrentThreadStackLimits(&low, &high);
+            return static_cast<uintptr_t>(low) + RegisterVM::STACK_RESERVE;
+#else
+            return 0;
+#endif
+        }();
+        return floor;
+    }
+}
 #ifdef _MSC_VER
 template<typename T1, typename T2>
 const typename RegisterVM::CmpFunc<T1, T2> RegisterVM::cmp_table[6] = {
@@ -31,6 +76,41 @@ const RegisterVM::CmpFunc<int64_t, int64_t> RegisterVM::cmp_table<int64_t, int64
 };
 #endif
 
+namespace {
+    constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+    constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+    // 指纹的种子：0 为入口程序，1/2 为函数表/跳转块表的第 index 项
+    uint64_t programSeed(uint64_t table, size_t index) {
+        return (table << 56) ^ static_cast<uint64_t>(index);
+    }
+
+    /**
+     * 单个程序的指纹，覆盖校验器检查过的全部字段；NEW/NEWT 的 data 是任意载荷，只计长度，
+     * 避免大块常量数据让每次 runVerified 都变慢
+     */
+    uint64_t programHash(uint64_t seed, const std::vector<OpCodeImpl::Instruction>& program) {
+        uint64_t hash = FNV_OFFSET;
+        auto mix = [&](uint64_t value) {
+            hash ^= value;
+            hash *= FNV_PRIME;
+        };
+        mix(seed);
+        mix(program.size());
+        for (const auto& instr : program) {
+            mix(static_cast<uint64_t>(instr.op) | (static_cast<uint64_t>(instr.rd) << 8) | (static_cast<uint64_t>(instr.rs) << 16)
+                | (static_cast<uint64_t>(static_cast<uint32_t>(instr.srcOffset)) << 32));
+            mix(static_cast<uint64_t>(instr.imm));
+            mix(static_cast<uint64_t>(instr.mem));
+            mix(static_cast<uint64_t>(static_cast<uint32_t>(instr.dstOffset)) | (static_cast<uint64_t>(instr.size) << 32));
+            mix(instr.data.size());
+            if (instr.op == OpCodeImpl::OpCode::NEW || instr.op == OpCodeImpl::OpCode::NEWT) continue;
+            for (int8_t byte : instr.data) mix(static_cast<uint8_t>(byte));
+        }
+        return hash;
+    }
+}
+
 void RegisterVM::vm_error(const OpCodeImpl::Instruction& instr) {
     std::cout << "VM Error: ";
     if (instr.rd >= NUM_REGS || instr.rs >= NUM_REGS)
@@ -38,20 +118,419 @@ void RegisterVM::vm_error(const OpCodeImpl::Instruction& instr) {
     exit(1);
 }
 
+RegisterVM::~RegisterVM() {
+    for (const auto& cache : call_caches) {
+        if (cache.function != nullptr) cache.function->del_ref();
+    }
+    for (auto* code : code_objects) {
+        if (code != nullptr) code->del_ref();
+    }
+}
+
 size_t RegisterVM::newFunc(const std::vector<OpCodeImpl::Instruction>& program) {
+    verified_entry = nullptr;
     size_t index = FuncLists.size();
     FuncLists.push_back(program);
     return index;
 }
 
+size_t RegisterVM::newLazyFuncs(size_t count, FuncLoader loader) {
+    if (func_loader) {
+        throw std::runtime_error("lazy functions already registered");
+    }
+    verified_entry = nullptr;
+    lazy_func_base = FuncLists.size();
+    FuncLists.resize(lazy_func_base + count);
+    pending_funcs.assign(FuncLists.size(), 0);
+    std::fill(pending_funcs.begin() + static_cast<std::ptrdiff_t>(lazy_func_base), pending_funcs.end(), 1);
+    pending_func_count = count;
+    func_loader = std::move(loader);
+    return lazy_func_base;
+}
+
+void RegisterVM::loadFunc(size_t index) {
+    std::vector<OpCodeImpl::Instruction> program = func_loader(index - lazy_func_base);
+    // 入口已校验时运行在无检查模式，新函数必须先通过校验才能执行
+    if (verified_entry != nullptr) {
+        const int64_t max_mem = Verifier::verifyProgram(*this, program, "func#" + std::to_string(index));
+        reserveStaticHeap(max_mem >= 0 ? static_cast<size_t>(max_mem) + 1 : 0);
+    }
+    // 延迟加载属于校验过的程序，更新指纹中该函数的一项
+    if (verified_entry != nullptr) verified_hash ^= programHash(programSeed(1, index), FuncLists[index]) ^ programHash(programSeed(1, index), program);
+    FuncLists[index] = std::move(program);
+    pending_funcs[index] = 0;
+    if (--pending_func_count == 0) {
+        func_loader = nullptr;
+        pending_funcs.clear();
+    }
+}
+
+void RegisterVM::loadAllFuncs() {
+    for (size_t i = 0; i < pending_funcs.size() && pending_func_count > 0; ++i) {
+        if (pending_funcs[i]) loadFunc(i);
+    }
+}
+
 void RegisterVM::run(const std::vector<OpCodeImpl::Instruction>& program){
+    LMVM_PROFILE_SCOPE(*this, Profiler::FrameKind::Entry, 0);
+    exit_status.reset();
+    // 在任务中运行时由 VmTask 按任务栈设置
+    if (task == nullptr) stack_floor = hostStackFloor();
+    try {
+        execute<true>(program);
+    } catch (const VmExit& e) {
+        exit_status = e.code();
+    }
+}
+
+void RegisterVM::verify(const std::vector<OpCodeImpl::Instruction>& entry) {
+    int64_t max_mem = Verifier::verify(*this, entry);
+    markVerified(entry, max_mem >= 0 ? static_cast<size_t>(max_mem) + 1 : 0);
+}
+
+void RegisterVM::reserveStaticHeap(size_t static_heap_slots) {
+    if (heap_limit != 0 && static_heap_slots > heap_limit) {
+        throw std::runtime_error("static heap address exceeds heap limit");
+    }
+    // 程序静态引用的堆槽位预先占好，运行期不再检查 mem < heap.size()
+    if (static_heap_slots > heap.size()) {
+        heap.resize(static_heap_slots, nullptr);
+    }
+}
+
+void RegisterVM::markVerified(const std::vector<OpCodeImpl::Instruction>& entry, size_t static_heap_slots) {
+    reserveStaticHeap(static_heap_slots);
+    // 将 VMCALL 分发器展开为平坦表，运行期直接下标访问
+    vm_call_table.assign(UINT8_MAX + 1, nullptr);
+    for (const auto& [index, handler] : vm_call_handlers) {
+        vm_call_table[index] = &handler;
+    }
+    verified_entry = &entry;
+    verified_hash = programsHash(entry);
+}
+
+uint64_t RegisterVM::programsHash(const std::vector<OpCodeImpl::Instruction>& entry) const {
+    uint64_t hash = programHash(programSeed(0, 0), entry);
+    for (size_t i = 0; i < FuncLists.size(); ++i) hash ^= programHash(programSeed(1, i), FuncLists[i]);
+    for (size_t i = 0; i < CallLists.size(); ++i) hash ^= programHash(programSeed(2, i), CallLists[i]);
+    return hash;
+}
+
+void RegisterVM::runVerified(const std::vector<OpCodeImpl::Instruction>& program) {
+    if (verified_entry != &program) {
+        throw std::runtime_error("program must pass verify() before runVerified()");
+    }
+    if (programsHash(program) != verified_hash) {
+        throw std::runtime_error("program was modified after verify(), verify it again");
+    }
+    LMVM_PROFILE_SCOPE(*this, Profiler::FrameKind::Entry, 0);
+    exit_status.reset();
+    // 在任务中运行时由 VmTask 按任务栈设置
+    if (task == nullptr) stack_floor = hostStackFloor();
+    try {
+        execute<false>(program);
+    } catch (const VmExit& e) {
+        exit_status = e.code();
+    }
+}
+
+void RegisterVM::outOfFuel() {
+    if (task == nullptr) throw VmOutOfFuel();
+    // 在任务的栈上挂起，宿主补充燃料后从这里继续
+    while (fuel < 0) task->suspend();
+}
+
+int64_t RegisterVM::convert(int64_t mode, int64_t value) {
+    using CvtMode = OpCodeImpl::CvtMode;
+    switch (static_cast<CvtMode>(mode)) {
+        case CvtMode::IntToF64:
+            return std::bit_cast<int64_t>(static_cast<double>(value));
+        case CvtMode::F64ToInt: {
+            const auto d = std::bit_cast<double>(value);
+            if (std::isnan(d)) return 0;
+            if (d >= 0x1p63) return INT64_MAX;
+            if (d < -0x1p63) return INT64_MIN;
+            return static_cast<int64_t>(d);
+        }
+        case CvtMode::Box:
+            return TaggedUtil::encode_Double(std::bit_cast<double>(value));
+        case CvtMode::Unbox:
+            if (TaggedUtil::is_Double(value)) return std::bit_cast<int64_t>(TaggedUtil::decode_Double(value));
+            if (TaggedUtil::get_tagged_type(value) == TaggedType::Smi) {
+                return std::bit_cast<int64_t>(static_cast<double>(TaggedUtil::decode_Smi(value)));
+            }
+            return std::bit_cast<int64_t>(std::numeric_limits<double>::quiet_NaN());
+    }
+    throw std::runtime_error("unknown CVT mode: " + std::to_string(mode));
+}
+
+template<bool kChecked, bool kStore>
+#ifdef __GNUC__
+[[gnu::always_inline]]
+#endif
+inline uint8_t* RegisterVM::typedElement(const OpCodeImpl::Instruction* instr, HeapObjType type) {
+    if constexpr (kChecked) {
+        if (instr->imm < 0 || instr->imm >= NUM_REGS) throw std::runtime_error("Invalid register number");
+    }
+    const auto addr = static_cast<uint64_t>(registers[instr->rs]);
+    LmHeapObject* obj = addr < heap.size() ? heap[addr] : nullptr;
+    if (obj == nullptr || obj->get_type() != type) [[unlikely]] {
+        throw std::runtime_error("typed array operand has the wrong type: r" + std::to_string(instr->rs) + " = "
+                                 + std::to_string(registers[instr->rs]));
+    }
+    if (kStore && obj->is_pinned()) [[unlikely]] {
+        throw std::runtime_error("typed array operand is a constant: r" + std::to_string(instr->rs));
+    }
+    auto* arr = static_cast<LmTypedArray*>(obj);
+    const auto index = static_cast<uint64_t>(registers[instr->imm]);
+    if (index >= arr->length()) [[unlikely]] {
+        throw std::runtime_error("typed array index out of range: " + std::to_string(registers[instr->imm]));
+    }
+    return arr->data() + index * LmTypedArray::element_width(type);
+}
+
+template<typename T, bool kChecked>
+inline void RegisterVM::typedLoad(const OpCodeImpl::Instruction* instr, HeapObjType type) {
+    T value;
+    std::memcpy(&value, typedElement<kChecked, false>(instr, type), sizeof(T));
+    registers[instr->rd] = static_cast<int64_t>(value);
+}
+
+template<typename T, bool kChecked>
+inline void RegisterVM::typedStore(const OpCodeImpl::Instruction* instr, HeapObjType type) {
+    const auto value = static_cast<T>(registers[instr->rd]);
+    std::memcpy(typedElement<kChecked, true>(instr, type), &value, sizeof(T));
+}
+
+#ifdef __GNUC__
+[[gnu::always_inline]]
+#endif
+inline LmRecord& RegisterVM::recordAt(uint8_t reg) {
+    const auto addr = static_cast<uint64_t>(registers[reg]);
+    LmHeapObject* obj = addr < heap.size() ? heap[addr] : nullptr;
+    if (obj == nullptr || obj->get_type() != HeapObjType::Record) [[unlikely]] {
+        throw std::runtime_error("record operand is not a record: r" + std::to_string(reg) + " = "
+                                 + std::to_string(registers[reg]));
+    }
+    return *static_cast<LmRecord*>(obj);
+}
+
+namespace {
+    [[noreturn]] void indexedError(const char* what, uint8_t reg, int64_t value) {
+        throw std::runtime_error(std::string(what) + ": r" + std::to_string(reg) + " = " + std::to_string(value));
+    }
+
+    // 紧凑数组与 LmBuffer 的元素字节，LmArray 以外的可索引对象都是 LmBuffer
+    template<typename T>
+    T* bufferElement(LmHeapObject* obj, size_t length, int64_t index) {
+        if (static_cast<uint64_t>(index) >= length) [[unlikely]] {
+            throw std::runtime_error("indexed access out of range: " + std::to_string(index));
+        }
+        return reinterpret_cast<T*>(static_cast<LmBuffer*>(obj)->data()) + index;
+    }
+}
+
+#ifdef __GNUC__
+[[gnu::always_inline]]
+#endif
+inline int64_t RegisterVM::loadIndexed(uint8_t base, int64_t index) {
+    const auto addr = static_cast<uint64_t>(registers[base]);
+    LmHeapObject* obj = addr < heap.size() ? heap[addr] : nullptr;
+    if (obj == nullptr) [[unlikely]] indexedError("indexed operand is not an object", base, registers[base]);
+    switch (obj->get_type()) {
+        case HeapObjType::Array: {
+            const auto* arr = static_cast<const LmArray*>(obj);
+            if (static_cast<uint64_t>(index) >= arr->get_size()) [[unlikely]] {
+                throw std::runtime_error("indexed access out of range: " + std::to_string(index));
+            }
+            const TaggedVal val = arr->data()[index];
+            if (TaggedUtil::get_tagged_type(val) != TaggedType::Smi) [[unlikely]] {
+                throw std::runtime_error("indexed load of a non-Smi element: " + std::to_string(index));
+            }
+            return TaggedUtil::decode_Smi(val);
+        }
+        case HeapObjType::Buffer:
+            return *bufferElement<uint8_t>(obj, static_cast<LmBuffer*>(obj)->get_size(), index);
+        case HeapObjType::Int8Array:
+            return *bufferElement<int8_t>(obj, static_cast<LmTypedArray*>(obj)->length(), index);
+        case HeapObjType::Int32Array: {
+            int32_t value;
+            std::memcpy(&value, bufferElement<int32_t>(obj, static_cast<LmTypedArray*>(obj)->length(), index), sizeof(value));
+            return value;
+        }
+        case HeapObjType::Int64Array: case HeapObjType::Float64Array: {
+            int64_t value;
+            std::memcpy(&value, bufferElement<int64_t>(obj, static_cast<LmTypedArray*>(obj)->length(), index), sizeof(value));
+            return value;
+        }
+        default:
+            indexedError("indexed operand is not indexable", base, registers[base]);
+    }
+}
+
+#ifdef __GNUC__
+[[gnu::always_inline]]
+#endif
+inline void RegisterVM::storeIndexed(uint8_t base, int64_t index, int64_t value) {
+    const auto addr = static_cast<uint64_t>(registers[base]);
+    LmHeapObject* obj = addr < heap.size() ? heap[addr] : nullptr;
+    if (obj == nullptr) [[unlikely]] indexedError("indexed operand is not an object", base, registers[base]);
+    if (obj->is_pinned()) [[unlikely]] indexedError("indexed operand is a constant", base, registers[base]);
+    switch (obj->get_type()) {
+        case HeapObjType::Array: {
+            auto* arr = static_cast<LmArray*>(obj);
+            if (static_cast<uint64_t>(index) >= arr->get_size()) [[unlikely]] {
+                throw std::runtime_error("indexed access out of range: " + std::to_string(index));
+            }
+            TaggedVal& slot = arr->data()[index];
+            if (TaggedUtil::is_HeapObject(slot)) TaggedUtil::decode_HeapObject(slot)->del_ref();
+            slot = TaggedUtil::encode_Smi(value);
+            return;
+        }
+        case HeapObjType::Buffer:
+            *bufferElement<uint8_t>(obj, static_cast<LmBuffer*>(obj)->get_size(), index) = static_cast<uint8_t>(value);
+            return;
+        case HeapObjType::Int8Array:
+            *bufferElement<int8_t>(obj, static_cast<LmTypedArray*>(obj)->length(), index) = static_cast<int8_t>(value);
+            return;
+        case HeapObjType::Int32Array: {
+            const auto narrow = static_cast<int32_t>(value);
+            std::memcpy(bufferElement<int32_t>(obj, static_cast<LmTypedArray*>(obj)->length(), index), &narrow, sizeof(narrow));
+            return;
+        }
+        case HeapObjType::Int64Array: case HeapObjType::Float64Array:
+            std::memcpy(bufferElement<int64_t>(obj, static_cast<LmTypedArray*>(obj)->length(), index), &value, sizeof(value));
+            return;
+        default:
+            indexedError("indexed operand is not indexable", base, registers[base]);
+    }
+}
+
+template<bool kChecked>
+#ifdef __GNUC__
+[[gnu::always_inline]]
+#endif
+inline int64_t RegisterVM::constantAddress(const OpCodeImpl::Instruction* instr) {
+    if constexpr (kChecked) {
+        if (instr->imm < 0 || !constants || static_cast<uint64_t>(instr->imm) >= constants->size()) {
+            throw std::runtime_error("constant index out of range: " + std::to_string(instr->imm));
+        }
+    }
+    const auto index = static_cast<size_t>(instr->imm);
+    // 程序可能释放或覆盖过这个槽位，比较一次对象指针
+    if (index < constant_slots.size()) [[likely]] {
+        const size_t addr = constant_slots[index];
+        if (addr != 0 && heap[addr] == constants->at(index)) [[likely]] return static_cast<int64_t>(addr);
+    }
+    return static_cast<int64_t>(bindConstant(index));
+}
+
+#ifdef __GNUC__
+[[gnu::always_inline]]
+#endif
+inline FieldCache& RegisterVM::fieldCache(const OpCodeImpl::Instruction* instr) {
+    // 指令被复制到别处时编号可能与其他调用点共用，缓存项都带 Shape 校验，只影响命中率
+    if (instr->cache == 0 || instr->cache >= field_caches.size()) [[unlikely]] {
+        if (field_caches.empty()) field_caches.emplace_back(); // 0 号不用
+        instr->cache = static_cast<uint32_t>(field_caches.size());
+        field_caches.emplace_back();
+    }
+    return field_caches[instr->cache];
+}
+
+#ifdef __GNUC__
+[[gnu::always_inline]]
+#endif
+inline void RegisterVM::getField(const OpCodeImpl::Instruction* instr) {
+    LmRecord& record = recordAt(instr->rs);
+    const FieldCache& cache = fieldCache(instr);
+    for (const auto& entry : cache.entries) {
+        if (entry.shape == record.shape()) {
+            registers[instr->rd] = record.get(entry.offset);
+            return;
+        }
+    }
+    fieldCacheMiss(instr, record, false);
+}
+
+#ifdef __GNUC__
+[[gnu::always_inline]]
+#endif
+inline void RegisterVM::setField(const OpCodeImpl::Instruction* instr) {
+    LmRecord& record = recordAt(instr->rs);
+    const FieldCache& cache = fieldCache(instr);
+    for (const auto& entry : cache.entries) {
+        if (entry.shape == record.shape()) {
+            if (entry.next == entry.shape) record.set(entry.offset, registers[instr->rd]);
+            else record.add(entry.next, registers[instr->rd]);
+            return;
+        }
+    }
+    fieldCacheMiss(instr, record, true);
+}
+
+#ifdef __GNUC__
+[[gnu::always_inline]]
+#endif
+inline const CallCache& RegisterVM::callTarget(const OpCodeImpl::Instruction* instr) {
+    if (instr->cache == 0 || instr->cache >= call_caches.size()) [[unlikely]] {
+        if (call_caches.empty()) call_caches.emplace_back(); // 0 号不用
+        instr->cache = static_cast<uint32_t>(call_caches.size());
+        call_caches.emplace_back();
+    }
+    const auto addr = static_cast<uint64_t>(registers[instr->rs]);
+    LmHeapObject* obj = addr < heap.size() ? heap[addr] : nullptr;
+    const CallCache& cache = call_caches[instr->cache];
+    // 缓存编号存在指令里，跨虚拟机运行或复制后的程序可能让 imm 不同的调用点共用编号
+    if (obj == cache.function && obj != nullptr && cache.base == instr->imm) [[likely]] return cache;
+    return callCacheMiss(instr, obj);
+}
+
+#ifdef __GNUC__
+[[gnu::always_inline]]
+#endif
+inline int64_t RegisterVM::switchTarget(const OpCodeImpl::Instruction* instr) {
+    // 只用这条指令自己编译的表：复制的指令与别的虚拟机上运行过的指令都重新编译
+    const SwitchTable& table = instr->cache != 0 && instr->cache < switch_tables.size()
+                                       && switch_tables[instr->cache].source == instr
+                                   ? switch_tables[instr->cache].table
+                                   : compileSwitch(instr);
+    return table.target(registers[instr->rd]);
+}
+
+template<bool kChecked>
+void RegisterVM::execute(const std::vector<OpCodeImpl::Instruction>& program){
     const size_t prog_size = program.size();
     if (prog_size == 0) return;
+    // 进入跳转块与函数是仅有的回边和调用，在这里按整个程序的长度预扣燃料，帧内逐条执行时不再检查
+    if ((fuel -= static_cast<int64_t>(prog_size)) < 0) [[unlikely]] outOfFuel();
 
     const OpCodeImpl::Instruction* instr_ptr = program.data();
     const OpCodeImpl::Instruction* end_ptr = instr_ptr + prog_size;
 
+    // 跳转块与函数都在这里递归，超过深度上限或越过栈底预留时在栈溢出之前抛出
+    const char stack_probe = 0;
+    if (frame_depth >= max_frame_depth || reinterpret_cast<uintptr_t>(&stack_probe) < stack_floor) [[unlikely]] {
+        throw VmStackOverflow(frame_depth);
+    }
+
+    // 帧退出时丢弃本帧安装但未结束的陷阱处理块，并累加本帧执行的指令数
+    struct FrameGuard {
+        RegisterVM& vm;
+        uint64_t retired = 0;
+        explicit FrameGuard(RegisterVM& vm) : vm(vm) { ++vm.frame_depth; }
+        ~FrameGuard() {
+            vm.instructions_retired += retired;
+            while (!vm.trap_handlers.empty() && vm.trap_handlers.back().depth >= vm.frame_depth) {
+                vm.trap_handlers.pop_back();
+            }
+            --vm.frame_depth;
+        }
+    } guard(*this);
+
     while (instr_ptr < end_ptr) {
+        LMVM_PROFILE_OP(*this, instr_ptr->op);
+        ++guard.retired;
         switch (instr_ptr->op) {
             case OpCodeImpl::OpCode::NEW: {
                 newOnHeap(instr_ptr);
@@ -67,7 +546,7 @@ void RegisterVM::run(const std::vector<OpCodeImpl::Instruction>& program){
                 break;
             }
             case OpCodeImpl::OpCode::MOVMI: {
-                if (instr_ptr->mem < heap.size()) {
+                if (!kChecked || instr_ptr->mem < heap.size()) {
                     if (heap[instr_ptr->mem] != nullptr) {
                         heap[instr_ptr->mem]->del_ref();
                     }
@@ -78,7 +557,7 @@ void RegisterVM::run(const std::vector<OpCodeImpl::Instruction>& program){
                 break;
             }
             case OpCodeImpl::OpCode::MOVMM: {
-                if (instr_ptr->mem < heap.size()) {
+                if (!kChecked || instr_ptr->mem < heap.size()) {
                     if (heap[instr_ptr->mem] != nullptr) {
                         heap[instr_ptr->mem]->del_ref();
                     }
@@ -89,7 +568,7 @@ void RegisterVM::run(const std::vector<OpCodeImpl::Instruction>& program){
                 break;
             }
             case OpCodeImpl::OpCode::MOVMR: {
-                if (instr_ptr->mem < heap.size()) {
+                if (!kChecked || instr_ptr->mem < heap.size()) {
                     if (heap[instr_ptr->mem] != nullptr) {
                         heap[instr_ptr->mem]->del_ref();
                     }
@@ -108,7 +587,7 @@ void RegisterVM::run(const std::vector<OpCodeImpl::Instruction>& program){
                 break;
             }
             case OpCodeImpl::OpCode::ADDM: {
-                if (instr_ptr->mem < heap.size() && heap[instr_ptr->mem] != nullptr) {
+                if ((!kChecked || instr_ptr->mem < heap.size()) && heap[instr_ptr->mem] != nullptr) {
                     auto* arr = dynamic_cast<LmArray*>(heap[instr_ptr->mem]);
                     if (arr && arr->get_size() > 0) {
                         TaggedVal val = arr->get(0);
@@ -128,7 +607,7 @@ void RegisterVM::run(const std::vector<OpCodeImpl::Instruction>& program){
                 break;
             }
             case OpCodeImpl::OpCode::SUBM: {
-                if (instr_ptr->mem < heap.size() && heap[instr_ptr->mem] != nullptr) {
+                if ((!kChecked || instr_ptr->mem < heap.size()) && heap[instr_ptr->mem] != nullptr) {
                     auto* arr = dynamic_cast<LmArray*>(heap[instr_ptr->mem]);
                     if (arr && arr->get_size() > 0) {
                         TaggedVal val = arr->get(0);
@@ -148,7 +627,7 @@ void RegisterVM::run(const std::vector<OpCodeImpl::Instruction>& program){
                 break;
             }
             case OpCodeImpl::OpCode::MULM: {
-                if (instr_ptr->mem < heap.size() && heap[instr_ptr->mem] != nullptr) {
+                if ((!kChecked || instr_ptr->mem < heap.size()) && heap[instr_ptr->mem] != nullptr) {
                     auto* arr = dynamic_cast<LmArray*>(heap[instr_ptr->mem]);
                     if (arr && arr->get_size() > 0) {
                         TaggedVal val = arr->get(0);
@@ -159,39 +638,213 @@ void RegisterVM::run(const std::vector<OpCodeImpl::Instruction>& program){
                 }
                 break;
             }
+            case OpCodeImpl::OpCode::SHLI: {
+                // 校验保证 0..63；未校验的程序按 64 取模，与常量折叠一致，不做未定义的移位
+                registers[instr_ptr->rd] <<= instr_ptr->imm & 63;
+                break;
+            }
             case OpCodeImpl::OpCode::DIVR: {
-                registers[instr_ptr->rd] /= registers[instr_ptr->rs];
+                const int64_t divisor = registers[instr_ptr->rs];
+                if (TrapCode trap = divideTrap(registers[instr_ptr->rd], divisor); trap != TrapCode::None) [[unlikely]] {
+                    raiseTrap(trap);
+                    goto unwind;
+                }
+                registers[instr_ptr->rd] /= divisor;
                 break;
             }
             case OpCodeImpl::OpCode::DIVI: {
+                if (TrapCode trap = divideTrap(registers[instr_ptr->rd], instr_ptr->imm); trap != TrapCode::None) [[unlikely]] {
+                    raiseTrap(trap);
+                    goto unwind;
+                }
+                registers[instr_ptr->rd] /= instr_ptr->imm;
+                break;
+            }
+            case OpCodeImpl::OpCode::DIVIQ: {
                 registers[instr_ptr->rd] /= instr_ptr->imm;
                 break;
             }
             case OpCodeImpl::OpCode::DIVM: {
-                if (instr_ptr->mem < heap.size() && heap[instr_ptr->mem] != nullptr) {
+                if ((!kChecked || instr_ptr->mem < heap.size()) && heap[instr_ptr->mem] != nullptr) {
                     auto* arr = dynamic_cast<LmArray*>(heap[instr_ptr->mem]);
                     if (arr && arr->get_size() > 0) {
                         TaggedVal val = arr->get(0);
                         if (TaggedUtil::get_tagged_type(val) == TaggedType::Smi) {
-                            registers[instr_ptr->rd] /= TaggedUtil::decode_Smi(val);
+                            const int64_t divisor = TaggedUtil::decode_Smi(val);
+                            if (TrapCode trap = divideTrap(registers[instr_ptr->rd], divisor); trap != TrapCode::None) [[unlikely]] {
+                                raiseTrap(trap);
+                                goto unwind;
+                            }
+                            registers[instr_ptr->rd] /= divisor;
                         }
                     }
                 }
                 break;
             }
+            case OpCodeImpl::OpCode::TRY: {
+                trap_handlers.push_back({static_cast<size_t>(instr_ptr->imm), frame_depth});
+                break;
+            }
+            case OpCodeImpl::OpCode::ENDTRY: {
+                if (!trap_handlers.empty() && trap_handlers.back().depth == frame_depth) {
+                    trap_handlers.pop_back();
+                }
+                break;
+            }
             case OpCodeImpl::OpCode::IFRR: {
-                if(cmpIfBool<int64_t,int64_t>(instr_ptr->data[0],registers[instr_ptr->rd],registers[instr_ptr->rs])) {
-                    run(CallLists[instr_ptr->imm]);
+                bool taken;
+                if constexpr (kChecked) {
+                    taken = cmpIfBool<int64_t,int64_t>(instr_ptr->data[0],registers[instr_ptr->rd],registers[instr_ptr->rs]);
+                } else {
+                    taken = reg_cmp_table[instr_ptr->data[0]](registers[instr_ptr->rd],registers[instr_ptr->rs]);
+                }
+                if(taken) {
+                    execute<kChecked>(CallLists[instr_ptr->imm]);
+                    if (pending_trap != TrapCode::None) [[unlikely]] goto unwind;
                     if(instr_ptr->size == 19000)return; //临时定义一个用于返回的跳转
                 }
                 break;
             }
+            case OpCodeImpl::OpCode::IFRI: {
+                if constexpr (kChecked) {
+                    if (instr_ptr->data.empty() || instr_ptr->data[0] < 0 || instr_ptr->data[0] >= OpCodeImpl::CMP_COUNT) {
+                        throw std::runtime_error("Unknown bool_cmp");
+                    }
+                }
+                if (reg_cmp_table[instr_ptr->data[0]](registers[instr_ptr->rd], instr_ptr->srcOffset)) goto enter_block;
+                break;
+            }
+            // 融合比较跳转：条件直接由操作码决定，不查比较表
+            case OpCodeImpl::OpCode::JEQ: if (registers[instr_ptr->rd] == registers[instr_ptr->rs]) goto enter_block; break;
+            case OpCodeImpl::OpCode::JNE: if (registers[instr_ptr->rd] != registers[instr_ptr->rs]) goto enter_block; break;
+            case OpCodeImpl::OpCode::JGT: if (registers[instr_ptr->rd] > registers[instr_ptr->rs]) goto enter_block; break;
+            case OpCodeImpl::OpCode::JLT: if (registers[instr_ptr->rd] < registers[instr_ptr->rs]) goto enter_block; break;
+            case OpCodeImpl::OpCode::JGE: if (registers[instr_ptr->rd] >= registers[instr_ptr->rs]) goto enter_block; break;
+            case OpCodeImpl::OpCode::JLE: if (registers[instr_ptr->rd] <= registers[instr_ptr->rs]) goto enter_block; break;
+            case OpCodeImpl::OpCode::JEQI: if (registers[instr_ptr->rd] == instr_ptr->srcOffset) goto enter_block; break;
+            case OpCodeImpl::OpCode::JNEI: if (registers[instr_ptr->rd] != instr_ptr->srcOffset) goto enter_block; break;
+            case OpCodeImpl::OpCode::JGTI: if (registers[instr_ptr->rd] > instr_ptr->srcOffset) goto enter_block; break;
+            case OpCodeImpl::OpCode::JLTI: if (registers[instr_ptr->rd] < instr_ptr->srcOffset) goto enter_block; break;
+            case OpCodeImpl::OpCode::JGEI: if (registers[instr_ptr->rd] >= instr_ptr->srcOffset) goto enter_block; break;
+            case OpCodeImpl::OpCode::JLEI: if (registers[instr_ptr->rd] <= instr_ptr->srcOffset) goto enter_block; break;
+            case OpCodeImpl::OpCode::SWITCH: {
+                const int64_t block = switchTarget(instr_ptr);
+                if (block >= 0) {
+                    if constexpr (kChecked) {
+                        if (static_cast<size_t>(block) >= CallLists.size()) {
+                            throw std::runtime_error("branch target out of range: " + std::to_string(block));
+                        }
+                    }
+                    execute<kChecked>(CallLists[block]);
+                    if (pending_trap != TrapCode::None) [[unlikely]] goto unwind;
+                    if (instr_ptr->size == 19000) return; // 与 IFRR 相同的返回标记
+                }
+                break;
+            }
             case OpCodeImpl::OpCode::VMCALL: {
-                registerUnionHandler(instr_ptr);
+                LMVM_PROFILE_SCOPE(*this, Profiler::FrameKind::VmCall, static_cast<size_t>(instr_ptr->imm));
+                if constexpr (kChecked) {
+                    registerUnionHandler(instr_ptr);
+                } else {
+                    (*vm_call_table[instr_ptr->imm])(instr_ptr);
+                }
                 break;
             }
             case OpCodeImpl::OpCode::CALL: {
-                funcCalling(instr_ptr);
+                funcCalling<kChecked>(static_cast<size_t>(instr_ptr->imm), nullptr, 0);
+                if (pending_trap != TrapCode::None) [[unlikely]] goto unwind;
+                break;
+            }
+            case OpCodeImpl::OpCode::CALLR: {
+                // 被调函数中同一调用点可能改写缓存，先取出下标与函数对象
+                const CallCache& target = callTarget(instr_ptr);
+                funcCalling<kChecked>(target.index, target.function, instr_ptr->imm);
+                if (pending_trap != TrapCode::None) [[unlikely]] goto unwind;
+                break;
+            }
+            case OpCodeImpl::OpCode::TAILCALL: {
+                // 复用当前帧：丢弃本帧的陷阱处理块，从被调函数开头继续，不再嵌套 execute 与保存寄存器
+                const auto index = static_cast<size_t>(instr_ptr->imm);
+                if constexpr (kChecked) {
+                    if (index >= FuncLists.size()) throw std::runtime_error("call target out of range: " + std::to_string(instr_ptr->imm));
+                }
+                if (pending_func_count != 0 && index < pending_funcs.size() && pending_funcs[index]) [[unlikely]] {
+                    loadFunc(index);
+                }
+                while (!trap_handlers.empty() && trap_handlers.back().depth >= frame_depth) trap_handlers.pop_back();
+                const std::vector<OpCodeImpl::Instruction>& callee = FuncLists[index];
+                if ((fuel -= static_cast<int64_t>(callee.size())) < 0) [[unlikely]] outOfFuel();
+                instr_ptr = callee.data();
+                end_ptr = instr_ptr + callee.size();
+                continue;
+            }
+            case OpCodeImpl::OpCode::NEWF: newFunction(instr_ptr); break;
+            case OpCodeImpl::OpCode::AFILL: case OpCodeImpl::OpCode::ACOPY:
+            case OpCodeImpl::OpCode::AADDR: case OpCodeImpl::OpCode::AADDA:
+            case OpCodeImpl::OpCode::ASUBR: case OpCodeImpl::OpCode::ASUBA:
+            case OpCodeImpl::OpCode::AMULR: case OpCodeImpl::OpCode::AMULA:
+            case OpCodeImpl::OpCode::ASUM: case OpCodeImpl::OpCode::AMIN: case OpCodeImpl::OpCode::AMAX:
+            case OpCodeImpl::OpCode::AFIND: case OpCodeImpl::OpCode::ACMP: {
+                // 地址来自寄存器，校验过的程序也要在运行期检查
+                arrayOp(instr_ptr);
+                break;
+            }
+            case OpCodeImpl::OpCode::MNEW: case OpCodeImpl::OpCode::MGET: case OpCodeImpl::OpCode::MPUT:
+            case OpCodeImpl::OpCode::MDEL: case OpCodeImpl::OpCode::MNEXT: {
+                mapOp(instr_ptr);
+                break;
+            }
+            case OpCodeImpl::OpCode::NEWR: {
+                if constexpr (kChecked) {
+                    if (instr_ptr->imm < 0) throw std::runtime_error("negative record capacity: " + std::to_string(instr_ptr->imm));
+                }
+                auto* record = new LmRecord(root_shape.get(), static_cast<size_t>(instr_ptr->imm));
+                registers[instr_ptr->rd] = static_cast<int64_t>(allocOnHeap(record));
+                break;
+            }
+            case OpCodeImpl::OpCode::GETFIELD: getField(instr_ptr); break;
+            case OpCodeImpl::OpCode::SETFIELD: setField(instr_ptr); break;
+            case OpCodeImpl::OpCode::LDI8: typedLoad<int8_t, kChecked>(instr_ptr, HeapObjType::Int8Array); break;
+            case OpCodeImpl::OpCode::LDI32: typedLoad<int32_t, kChecked>(instr_ptr, HeapObjType::Int32Array); break;
+            case OpCodeImpl::OpCode::LDI64: typedLoad<int64_t, kChecked>(instr_ptr, HeapObjType::Int64Array); break;
+            case OpCodeImpl::OpCode::LDF64: typedLoad<int64_t, kChecked>(instr_ptr, HeapObjType::Float64Array); break;
+            case OpCodeImpl::OpCode::STI8: typedStore<int8_t, kChecked>(instr_ptr, HeapObjType::Int8Array); break;
+            case OpCodeImpl::OpCode::STI32: typedStore<int32_t, kChecked>(instr_ptr, HeapObjType::Int32Array); break;
+            case OpCodeImpl::OpCode::STI64: typedStore<int64_t, kChecked>(instr_ptr, HeapObjType::Int64Array); break;
+            case OpCodeImpl::OpCode::STF64: typedStore<int64_t, kChecked>(instr_ptr, HeapObjType::Float64Array); break;
+            case OpCodeImpl::OpCode::LDX:
+                registers[instr_ptr->rd] = loadIndexed(instr_ptr->rs, instr_ptr->srcOffset);
+                break;
+            case OpCodeImpl::OpCode::STX:
+                storeIndexed(instr_ptr->rd, instr_ptr->dstOffset, registers[instr_ptr->rs]);
+                break;
+            case OpCodeImpl::OpCode::LDC: registers[instr_ptr->rd] = constantAddress<kChecked>(instr_ptr); break;
+            case OpCodeImpl::OpCode::NEWT: {
+                newTypedOnHeap(instr_ptr);
+                break;
+            }
+            case OpCodeImpl::OpCode::ADDF: {
+                registers[instr_ptr->rd] = std::bit_cast<int64_t>(std::bit_cast<double>(registers[instr_ptr->rd])
+                                                                  + std::bit_cast<double>(registers[instr_ptr->rs]));
+                break;
+            }
+            case OpCodeImpl::OpCode::SUBF: {
+                registers[instr_ptr->rd] = std::bit_cast<int64_t>(std::bit_cast<double>(registers[instr_ptr->rd])
+                                                                  - std::bit_cast<double>(registers[instr_ptr->rs]));
+                break;
+            }
+            case OpCodeImpl::OpCode::MULF: {
+                registers[instr_ptr->rd] = std::bit_cast<int64_t>(std::bit_cast<double>(registers[instr_ptr->rd])
+                                                                  * std::bit_cast<double>(registers[instr_ptr->rs]));
+                break;
+            }
+            case OpCodeImpl::OpCode::DIVF: {
+                registers[instr_ptr->rd] = std::bit_cast<int64_t>(std::bit_cast<double>(registers[instr_ptr->rd])
+                                                                  / std::bit_cast<double>(registers[instr_ptr->rs]));
+                break;
+            }
+            case OpCodeImpl::OpCode::CVT: {
+                registers[instr_ptr->rd] = convert(instr_ptr->imm, registers[instr_ptr->rs]);
                 break;
             }
             case OpCodeImpl::OpCode::RET: {
@@ -205,9 +858,58 @@ void RegisterVM::run(const std::vector<OpCodeImpl::Instruction>& program){
         }
 
         instr_ptr++;
+        continue;
+
+    enter_block:
+        // IFRI 与融合比较跳转的条件成立：进入 CallLists[imm]
+        if constexpr (kChecked) {
+            if (instr_ptr->imm < 0 || static_cast<size_t>(instr_ptr->imm) >= CallLists.size()) {
+                throw std::runtime_error("branch target out of range: " + std::to_string(instr_ptr->imm));
+            }
+        }
+        execute<kChecked>(CallLists[instr_ptr->imm]);
+        if (pending_trap != TrapCode::None) [[unlikely]] goto unwind;
+        if (instr_ptr->size == 19000) return; // 与 IFRR 相同的返回标记
+        instr_ptr++;
+        continue;
+
+    unwind:
+        // 处理块不在本帧时返回上一帧继续展开
+        if (trap_handlers.empty() || trap_handlers.back().depth != frame_depth) return;
+        instr_ptr = handleTrap<kChecked>(instr_ptr, end_ptr);
+        // 处理块又出错时从刚找到的 ENDTRY 之后找外层 TRY 的 ENDTRY
+        if (pending_trap != TrapCode::None) goto unwind;
+        if (instr_ptr < end_ptr) instr_ptr++;
     }
 }
 
+void RegisterVM::raiseTrap(TrapCode code) {
+    if (trap_handlers.empty()) throw VmTrap(code);
+    pending_trap = code;
+}
+
+template<bool kChecked>
+const OpCodeImpl::Instruction* RegisterVM::handleTrap(const OpCodeImpl::Instruction* at,
+                                                      const OpCodeImpl::Instruction* end) {
+    const size_t block = trap_handlers.back().block;
+    trap_handlers.pop_back();
+    registers[0] = static_cast<int64_t>(pending_trap);
+    pending_trap = TrapCode::None;
+    execute<kChecked>(CallLists[block]);
+
+    // 从出错位置向后找到与之匹配的 ENDTRY
+    size_t nesting = 0;
+    for (const auto* p = at < end ? at + 1 : end; p < end; ++p) {
+        if (p->op == OpCodeImpl::OpCode::TRY) {
+            ++nesting;
+        } else if (p->op == OpCodeImpl::OpCode::ENDTRY) {
+            if (nesting == 0) return p;
+            --nesting;
+        }
+    }
+    return end;
+}
+
 template<typename T1, typename T2>
 #ifdef __GNUC__
 [[gnu::always_inline]]
@@ -215,40 +917,52 @@ template<typename T1, typename T2>
 inline
 #endif
 bool RegisterVM::cmpIfBool(int8_t bool_cmp, T1 left, T2 right) {
-    if (bool_cmp < 0 || bool_cmp >= 6) {
-        throw std::runtime_error("Unknown bool_cmp");
+    if constexpr (std::is_same_v<T1, int64_t> && std::is_same_v<T2, int64_t>) {
+        if (bool_cmp < 0 || bool_cmp >= 2 * OpCodeImpl::CMP_COUNT) {
+            throw std::runtime_error("Unknown bool_cmp");
+        }
+        return reg_cmp_table[bool_cmp](left, right);
+    } else {
+        if (bool_cmp < 0 || bool_cmp >= OpCodeImpl::CMP_COUNT) {
+            throw std::runtime_error("Unknown bool_cmp");
+        }
+        return cmp_table<T1, T2>[bool_cmp](left, right);
     }
-    return cmp_table<T1, T2>[bool_cmp](left, right);
 }
 
 size_t RegisterVM::newCall(const std::vector<OpCodeImpl::Instruction>& program){
+    verified_entry = nullptr;
     size_t index = CallLists.size();
     CallLists.push_back(program);
     return index;
 }
 
+template<bool kChecked>
 #ifdef __GNUC__
 [[gnu::always_inline]]
 #else
 inline
 #endif
-inline void RegisterVM::funcCalling(const OpCodeImpl::Instruction *instr) {
-    try {
-        LocalState local_state;
-        local_state.saveAllRegisters(registers);
-        for (int i = 3; i <= 15; ++i) {
-            local_state.setRegister(i, registers[i]);
-        }
-        run(FuncLists[instr->imm]);
-        local_state.setReturnValue(registers[0]);
-        local_state.restoreAllRegisters(registers);
-        registers[0] = local_state.getReturnValue();
-    } catch (const std::exception& e) {
-        std::cerr << "VM Error: " << e.what() << std::endl;
+inline void RegisterVM::funcCalling(size_t index, const LmFunction* function, int64_t capture_base) {
+    // 错误直接抛给宿主，陷阱经由 pending_trap 在帧间展开
+    if (pending_func_count != 0 && index < pending_funcs.size() && pending_funcs[index]) [[unlikely]] {
+        loadFunc(index);
+    }
+    LMVM_PROFILE_SCOPE(*this, Profiler::FrameKind::Function, index);
+    LocalState local_state;
+    local_state.saveAllRegisters(registers);
+    for (int i = 3; i <= 15; ++i) {
+        local_state.setRegister(i, registers[i]);
     }
+    // 捕获值在保存寄存器之后写入，返回时与其他寄存器一起恢复
+    if (function != nullptr) std::copy_n(function->captures(), function->capture_count(), registers + capture_base);
+    execute<kChecked>(FuncLists[index]);
+    local_state.setReturnValue(registers[0]);
+    local_state.restoreAllRegisters(registers);
+    registers[0] = local_state.getReturnValue();
 }
 
-inline void RegisterVM::newOnHeap(const OpCodeImpl::Instruction *instr) {
+void RegisterVM::newOnHeap(const OpCodeImpl::Instruction *instr) {
     if(instr->data.empty()) vm_error(*instr);
 
     auto* arr = new LmArray(instr->data.size());
@@ -256,9 +970,307 @@ inline void RegisterVM::newOnHeap(const OpCodeImpl::Instruction *instr) {
         arr->push(TaggedUtil::encode_Smi(byte));
     }
 
+    registers[1] = static_cast<int64_t>(allocOnHeap(arr));
+}
+
+LmArray& RegisterVM::arrayAt(uint8_t reg) {
+    const auto addr = static_cast<uint64_t>(registers[reg]);
+    LmHeapObject* obj = addr < heap.size() ? heap[addr] : nullptr;
+    if (obj == nullptr || obj->get_type() != HeapObjType::Array) {
+        throw std::runtime_error("array operand is not an array: r" + std::to_string(reg) + " = "
+                                 + std::to_string(registers[reg]));
+    }
+    return *static_cast<LmArray*>(obj);
+}
+
+void RegisterVM::arrayOp(const OpCodeImpl::Instruction* instr) {
+    using OpCode = OpCodeImpl::OpCode;
+    auto arith = [&](ArrayOps::Arith op, bool with_array) {
+        LmArray& dst = arrayAt(instr->rd);
+        if (with_array) {
+            const LmArray& src = arrayAt(instr->rs);
+            ArrayOps::arithArray(op, dst.data(), src.data(), std::min(dst.get_size(), src.get_size()));
+        } else {
+            ArrayOps::arithScalar(op, dst.data(), dst.get_size(), registers[instr->rs]);
+        }
+    };
+    auto reduce = [&](ArrayOps::Reduce op) {
+        const LmArray& arr = arrayAt(instr->rs);
+        registers[instr->rd] = ArrayOps::reduce(op, arr.data(), arr.get_size());
+    };
+
+    switch (instr->op) {
+        case OpCode::AFILL: {
+            LmArray& arr = arrayAt(instr->rd);
+            ArrayOps::fill(arr.data(), arr.get_size(), registers[instr->rs]);
+            break;
+        }
+        case OpCode::ACOPY: {
+            const LmArray& src = arrayAt(instr->rs);
+            arrayAt(instr->rd).assign(src.data(), src.get_size());
+            break;
+        }
+        case OpCode::AADDR: arith(ArrayOps::Arith::Add, false); break;
+        case OpCode::AADDA: arith(ArrayOps::Arith::Add, true); break;
+        case OpCode::ASUBR: arith(ArrayOps::Arith::Sub, false); break;
+        case OpCode::ASUBA: arith(ArrayOps::Arith::Sub, true); break;
+        case OpCode::AMULR: arith(ArrayOps::Arith::Mul, false); break;
+        case OpCode::AMULA: arith(ArrayOps::Arith::Mul, true); break;
+        case OpCode::ASUM: reduce(ArrayOps::Reduce::Sum); break;
+        case OpCode::AMIN: reduce(ArrayOps::Reduce::Min); break;
+        case OpCode::AMAX: reduce(ArrayOps::Reduce::Max); break;
+        case OpCode::AFIND: {
+            const LmArray& arr = arrayAt(instr->rs);
+            registers[instr->rd] = ArrayOps::find(arr.data(), arr.get_size(), registers[instr->rd]);
+            break;
+        }
+        case OpCode::ACMP: {
+            const LmArray& left = arrayAt(instr->rd);
+            const LmArray& right = arrayAt(instr->rs);
+            registers[instr->rd] = ArrayOps::mismatch(left.data(), left.get_size(), right.data(), right.get_size());
+            break;
+        }
+        default:
+            throw std::runtime_error("Unknown opcode");
+    }
+}
+
+void RegisterVM::newTypedOnHeap(const OpCodeImpl::Instruction* instr) {
+    if (instr->imm < 0 || instr->imm >= LmTypedArray::KIND_COUNT) {
+        throw std::runtime_error("unknown typed array kind: " + std::to_string(instr->imm));
+    }
+    const HeapObjType type = LmTypedArray::type_of(instr->imm);
+    const size_t width = LmTypedArray::element_width(type);
+    if (instr->data.size() % width != 0) {
+        throw std::runtime_error("typed array data is not a multiple of the element width");
+    }
+    auto* arr = new LmTypedArray(type, instr->data.size() / width);
+    if (!instr->data.empty()) std::memcpy(arr->data(), instr->data.data(), instr->data.size());
+    registers[1] = static_cast<int64_t>(allocOnHeap(arr));
+}
+
+LmMap& RegisterVM::mapAt(uint8_t reg) {
+    const auto addr = static_cast<uint64_t>(registers[reg]);
+    LmHeapObject* obj = addr < heap.size() ? heap[addr] : nullptr;
+    if (obj == nullptr || obj->get_type() != HeapObjType::Map) {
+        throw std::runtime_error("map operand is not a map: r" + std::to_string(reg) + " = "
+                                 + std::to_string(registers[reg]));
+    }
+    return *static_cast<LmMap*>(obj);
+}
+
+TaggedVal RegisterVM::mapKey(const OpCodeImpl::Instruction* instr) {
+    if ((instr->imm & ~(OpCodeImpl::MAP_KEY_STRING | OpCodeImpl::MAP_KEY_REG)) != 0) {
+        throw std::runtime_error("invalid map key operand: " + std::to_string(instr->imm));
+    }
+    const int64_t value = registers[instr->imm & OpCodeImpl::MAP_KEY_REG];
+    if (!(instr->imm & OpCodeImpl::MAP_KEY_STRING)) return TaggedUtil::encode_Smi(value);
+    const auto addr = static_cast<uint64_t>(value);
+    LmHeapObject* obj = addr < heap.size() ? heap[addr] : nullptr;
+    if (obj == nullptr || obj->get_type() != HeapObjType::String) {
+        throw std::runtime_error("map key is not a string: " + std::to_string(value));
+    }
+    return TaggedUtil::encode_HeapObject(obj);
+}
+
+void RegisterVM::mapOp(const OpCodeImpl::Instruction* instr) {
+    using OpCode = OpCodeImpl::OpCode;
+    switch (instr->op) {
+        case OpCode::MNEW: {
+            if (instr->imm < 0) throw std::runtime_error("negative map capacity: " + std::to_string(instr->imm));
+            auto* map = new LmMap(static_cast<size_t>(instr->imm));
+            registers[instr->rd] = static_cast<int64_t>(allocOnHeap(map));
+            break;
+        }
+        case OpCode::MGET: {
+            const LmMap& map = mapAt(instr->rs);
+            if (const int64_t* value = map.find(mapKey(instr))) registers[instr->rd] = *value;
+            break;
+        }
+        case OpCode::MPUT: {
+            LmMap& map = mapAt(instr->rs);
+            map.put(mapKey(instr), registers[instr->rd]);
+            break;
+        }
+        case OpCode::MDEL: {
+            LmMap& map = mapAt(instr->rs);
+            registers[instr->rd] = map.erase(mapKey(instr)) ? 1 : 0;
+            break;
+        }
+        case OpCode::MNEXT: {
+            if (instr->imm < 0 || instr->imm >= NUM_REGS) throw std::runtime_error("Invalid register number");
+            const LmMap& map = mapAt(instr->rs);
+            int64_t& cursor = registers[instr->imm];
+            const size_t slot = cursor < 0 ? map.capacity() : map.next(static_cast<size_t>(cursor));
+            if (slot >= map.capacity()) {
+                cursor = -1;
+                break;
+            }
+            const TaggedVal key = map.key_at(slot);
+            cursor = static_cast<int64_t>(slot + 1);
+            if (TaggedUtil::is_HeapObject(key)) {
+                registers[instr->rd] = static_cast<int64_t>(mapKeySlot(instr, TaggedUtil::decode_HeapObject(key)));
+            } else {
+                registers[instr->rd] = TaggedUtil::decode_Smi(key);
+            }
+            break;
+        }
+        default:
+            throw std::runtime_error("not a map instruction");
+    }
+}
+
+size_t RegisterVM::mapKeySlot(const OpCodeImpl::Instruction* instr, LmHeapObject* key) {
+    if (instr->cache == 0 || instr->cache >= map_key_slots.size()) {
+        if (map_key_slots.empty()) map_key_slots.emplace_back(); // 0 号不用
+        instr->cache = static_cast<uint32_t>(map_key_slots.size());
+        map_key_slots.emplace_back();
+    }
+    MapKeySlot& cached = map_key_slots[instr->cache];
+    key->make_ref();
+    // 槽位被 VMCALL 15 释放或改存其他对象后不再属于本调用点
+    if (cached.slot != 0 && cached.slot < heap.size() && heap[cached.slot] == cached.key) {
+        heap[cached.slot]->del_ref();
+        heap[cached.slot] = key;
+    } else {
+        cached.slot = allocOnHeap(key);
+    }
+    cached.key = key;
+    return cached.slot;
+}
+
+void RegisterVM::fieldCacheMiss(const OpCodeImpl::Instruction* instr, LmRecord& record, bool store) {
+    if (instr->imm < 0) throw std::runtime_error("negative field id: " + std::to_string(instr->imm));
+    const Shape* shape = record.shape();
+    const int64_t offset = shape->offset_of(instr->imm);
+    FieldCache& cache = fieldCache(instr);
+    if (offset >= 0) {
+        cache.insert({shape, shape, static_cast<uint32_t>(offset)});
+        if (store) record.set(static_cast<uint32_t>(offset), registers[instr->rd]);
+        else registers[instr->rd] = record.get(static_cast<uint32_t>(offset));
+    } else if (store) {
+        const Shape* next = shape->transition(instr->imm);
+        cache.insert({shape, next, shape->field_count()});
+        record.add(next, registers[instr->rd]);
+    }
+    // 读取不存在的字段时 r[rd] 不变，也不缓存
+}
+
+void RegisterVM::newFunction(const OpCodeImpl::Instruction* instr) {
+    if (instr->imm < 0 || static_cast<size_t>(instr->imm) >= FuncLists.size()) {
+        throw std::runtime_error("function index out of range: " + std::to_string(instr->imm));
+    }
+    const auto index = static_cast<size_t>(instr->imm);
+    std::vector<int64_t> captures;
+    captures.reserve(instr->data.size());
+    for (int8_t reg : instr->data) {
+        if (reg < 0 || reg >= NUM_REGS) throw std::runtime_error("Invalid register number");
+        captures.push_back(registers[reg]);
+    }
+    if (code_objects.size() <= index) code_objects.resize(FuncLists.size(), nullptr);
+    if (code_objects[index] == nullptr) code_objects[index] = new LmCodeObject(index);
+    registers[instr->rd] = static_cast<int64_t>(allocOnHeap(new LmFunction(code_objects[index], std::move(captures))));
+}
+
+const CallCache& RegisterVM::callCacheMiss(const OpCodeImpl::Instruction* instr, LmHeapObject* obj) {
+    if (obj == nullptr || obj->get_type() != HeapObjType::Function) {
+        throw std::runtime_error("call target is not a function: r" + std::to_string(instr->rs) + " = "
+                                 + std::to_string(registers[instr->rs]));
+    }
+    auto* function = static_cast<LmFunction*>(obj);
+    // 命中时还要比较 imm，检查过的范围随缓存一起记住
+    if (instr->imm < 0 || instr->imm + static_cast<int64_t>(function->capture_count()) > NUM_REGS) {
+        throw std::runtime_error("captured values do not fit from r" + std::to_string(instr->imm));
+    }
+    CallCache& cache = call_caches[instr->cache];
+    function->make_ref();
+    if (cache.function != nullptr) cache.function->del_ref();
+    cache.function = function;
+    cache.index = function->code()->get_func_index();
+    cache.base = instr->imm;
+    return cache;
+}
+
+size_t RegisterVM::enterCallTarget(const OpCodeImpl::Instruction* instr) {
+    const CallCache& target = callTarget(instr);
+    const LmFunction* function = target.function;
+    std::copy_n(function->captures(), function->capture_count(), registers + instr->imm);
+    return target.index;
+}
+
+const SwitchTable& RegisterVM::compileSwitch(const OpCodeImpl::Instruction* instr) {
+    SwitchTable table(instr->data, instr->imm); // 分支列表不合法时抛出
+    if (switch_tables.empty()) switch_tables.push_back({nullptr, SwitchTable({}, -1)}); // 0 号不用
+    instr->cache = static_cast<uint32_t>(switch_tables.size());
+    switch_tables.push_back({instr, std::move(table)});
+    return switch_tables.back().table;
+}
+
+void RegisterVM::heapOp(const OpCodeImpl::Instruction* instr) {
+    using OpCode = OpCodeImpl::OpCode;
+    switch (instr->op) {
+        case OpCode::LDI8: typedLoad<int8_t, false>(instr, HeapObjType::Int8Array); break;
+        case OpCode::LDI32: typedLoad<int32_t, false>(instr, HeapObjType::Int32Array); break;
+        case OpCode::LDI64: typedLoad<int64_t, false>(instr, HeapObjType::Int64Array); break;
+        case OpCode::LDF64: typedLoad<int64_t, false>(instr, HeapObjType::Float64Array); break;
+        case OpCode::STI8: typedStore<int8_t, false>(instr, HeapObjType::Int8Array); break;
+        case OpCode::STI32: typedStore<int32_t, false>(instr, HeapObjType::Int32Array); break;
+        case OpCode::STI64: typedStore<int64_t, false>(instr, HeapObjType::Int64Array); break;
+        case OpCode::STF64: typedStore<int64_t, false>(instr, HeapObjType::Float64Array); break;
+        case OpCode::LDX: registers[instr->rd] = loadIndexed(instr->rs, instr->srcOffset); break;
+        case OpCode::STX: storeIndexed(instr->rd, instr->dstOffset, registers[instr->rs]); break;
+        case OpCode::LDC: registers[instr->rd] = constantAddress<false>(instr); break;
+        case OpCode::NEWT: newTypedOnHeap(instr); break;
+        case OpCode::MNEW: case OpCode::MGET: case OpCode::MPUT: case OpCode::MDEL: case OpCode::MNEXT:
+            mapOp(instr);
+            break;
+        case OpCode::NEWR:
+            registers[instr->rd] = static_cast<int64_t>(allocOnHeap(new LmRecord(root_shape.get(), static_cast<size_t>(instr->imm))));
+            break;
+        case OpCode::GETFIELD: getField(instr); break;
+        case OpCode::SETFIELD: setField(instr); break;
+        case OpCode::NEWF: newFunction(instr); break;
+        default: arrayOp(instr); break;
+    }
+}
+
+size_t RegisterVM::allocOnHeap(LmHeapObject* obj) {
+    while (!free_heap_slots.empty()) {
+        size_t addr = free_heap_slots.back();
+        free_heap_slots.pop_back();
+        // MOVMI/MOVMR/MOVMM 按固定地址写堆，空闲槽位可能已被重新占用
+        if (heap[addr] != nullptr) continue;
+        heap[addr] = obj;
+        return addr;
+    }
     size_t addr = heap.size();
-    heap.push_back(arr);
-    registers[1] = static_cast<int64_t>(addr);
+    if (heap_limit != 0 && addr >= heap_limit) {
+        obj->del_ref();
+        throw std::runtime_error("heap limit exceeded: " + std::to_string(heap_limit) + " slots");
+    }
+    heap.push_back(obj);
+    return addr;
+}
+
+void RegisterVM::setConstants(std::shared_ptr<const ConstantPool> pool) {
+    verified_entry = nullptr;
+    constants = std::move(pool);
+    constant_slots.clear();
+}
+
+size_t RegisterVM::bindConstant(size_t index) {
+    if (constant_slots.size() < constants->size()) constant_slots.resize(constants->size(), 0);
+    // 常量已固定，放入堆中不增加引用计数
+    const size_t addr = allocOnHeap(constants->at(index));
+    constant_slots[index] = addr;
+    return addr;
+}
+
+void RegisterVM::freeOnHeap(size_t addr) {
+    if (addr == 0 || addr >= heap.size() || heap[addr] == nullptr) return;
+    heap[addr]->del_ref();
+    heap[addr] = nullptr;
+    free_heap_slots.push_back(addr);
 }
 
 inline void RegisterVM::registerUnionHandler(const OpCodeImpl::Instruction* instr) {
@@ -7,13 +7,24 @@
 #pragma once
 #include "../opcode.hpp"
 #include "models.hpp"
+#include "hash_map.hpp"
+#include "record.hpp"
+#include "function.hpp"
+#include "switch_table.hpp"
+#include "constant_pool.hpp"
+#include "profiler.hpp"
+#include "../vmcall/file_io.hpp"
+#include <bit>
 #include <iostream>
 #include <functional>
 #include <vector>
+#include <cstdint>
 #include <cstring>
-#include <fstream>
 #include <map>
 #include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
 
 // =========================
 // 定义寄存器数量
@@ -83,6 +94,62 @@ private:
     int64_t return_value;
 };
 
+// =========================
+// 算术陷阱
+// =========================
+enum class TrapCode : int64_t {
+    None = 0,
+    DivideByZero = 1,   // 除数为 0
+    DivideOverflow = 2  // INT64_MIN / -1
+};
+
+/**
+ * 没有陷阱处理块时抛给宿主的异常
+ */
+class VmTrap : public std::runtime_error {
+public:
+    explicit VmTrap(TrapCode code)
+        : std::runtime_error(code == TrapCode::DivideByZero ? "VM Trap: division by zero"
+                                                            : "VM Trap: division overflow"),
+          code_(code) {}
+
+    [[nodiscard]] TrapCode code() const { return code_; }
+private:
+    TrapCode code_;
+};
+
+/**
+ * 没有在 VmTask 中运行时燃料耗尽，抛给宿主；解释帧已经展开，不能继续
+ */
+class VmOutOfFuel : public std::runtime_error {
+public:
+    VmOutOfFuel() : std::runtime_error("VM out of fuel") {}
+};
+
+/**
+ * 解释帧深度超过上限或栈空间将尽：跳转块与函数按解释帧递归，在宿主栈或任务栈溢出之前抛出；解释帧已经展开
+ */
+class VmStackOverflow : public std::runtime_error {
+public:
+    explicit VmStackOverflow(size_t depth)
+        : std::runtime_error("VM stack overflow at frame depth " + std::to_string(depth)) {}
+};
+
+/**
+ * VMCALL 2 请求退出：沿解释帧展开到 run/runVerified，由宿主读取退出码，不再结束整个进程
+ * 不继承 std::exception，VMCALL 实现中按 std::exception 捕获的代码不会把它吞掉
+ */
+class VmExit {
+public:
+    explicit VmExit(int code) : code_(code) {}
+
+    [[nodiscard]] int code() const { return code_; }
+private:
+    int code_;
+};
+
+class VmTask;
+
 // 前向声明HandlerFunction模板
 template<size_t N>
 struct HandlerFunction;
@@ -93,13 +160,16 @@ struct HandlerFunction;
 class RegisterVM {
 public:
     /**
-     * 定义一个析构函数
+     * 析构函数，释放调用点缓存与代码对象持有的引用
      */
-    virtual ~RegisterVM() = default;
+    virtual ~RegisterVM();
     int64_t registers[NUM_REGS]{}; // r0 ~ r14
     std::vector<LmHeapObject*> heap;    // 堆
 
     static std::map<uint8_t, std::function<void(const OpCodeImpl::Instruction*)>> vm_call_handlers; // VM调用分发器
+#ifdef LMVM_PROFILE
+    Profiler profiler; // 执行剖析器
+#endif
     /**
      * 初始化所有寄存器为 0
      */
@@ -113,6 +183,18 @@ public:
      * @param program
      */
     void run(const std::vector<OpCodeImpl::Instruction>& program);
+    /**
+     * 加载期校验入口程序与所有函数/跳转块，失败抛出 VerifyError
+     * @param entry
+     * @return void
+     */
+    void verify(const std::vector<OpCodeImpl::Instruction>& entry);
+    /**
+     * 无检查快速执行，program 必须先通过 verify，且校验后入口程序与函数/跳转块都没有被修改，否则抛出
+     * @param program
+     * @return void
+     */
+    void runVerified(const std::vector<OpCodeImpl::Instruction>& program);
     /**
      * 通过统一分发器注册VMCALL/SYSCALL调用
      * @param instr
@@ -124,16 +206,234 @@ public:
      * @return size_t
      */
     size_t newFunc(const std::vector<OpCodeImpl::Instruction>& program);
+    /**
+     * 延迟加载函数的解码回调，参数为本批函数内的下标
+     */
+    using FuncLoader = std::function<std::vector<OpCodeImpl::Instruction>(size_t)>;
+    /**
+     * 登记一批延迟加载的函数，下标接在已有函数之后，首次 CALL 时才由 loader 解码；
+     * 已校验的程序加载时单独校验新函数
+     * @param count
+     * @param loader
+     * @return size_t 第一个函数的下标
+     */
+    size_t newLazyFuncs(size_t count, FuncLoader loader);
+    /**
+     * 加载全部尚未加载的函数，优化与保存快照前需要完整的函数表
+     * @return void
+     */
+    void loadAllFuncs();
+    /**
+     * 尚未加载的函数个数
+     * @return size_t
+     */
+    [[nodiscard]] size_t pendingFuncCount() const { return pending_func_count; }
+    /**
+     * 函数总数（含尚未加载的）
+     * @return size_t
+     */
+    [[nodiscard]] size_t funcCount() const { return FuncLists.size(); }
     /**
      * 新建控制流跳转
      * @param program
      * @return size_t
      */
     size_t newCall(const std::vector<OpCodeImpl::Instruction>& program);
+    /**
+     * 将对象放入堆中
+     * @param obj
+     * @return size_t 堆地址
+     */
+    size_t allocOnHeap(LmHeapObject* obj);
+    /**
+     * 释放堆槽位，槽位会被后续分配复用；脚本经 VMCALL 15 调用
+     * @param addr
+     * @return void
+     */
+    void freeOnHeap(size_t addr);
+    /**
+     * 设置堆槽位上限，0 表示不限制，超出时分配抛出 std::runtime_error
+     * @param slots
+     * @return void
+     */
+    void setHeapLimit(size_t slots) { heap_limit = slots; }
+    /**
+     * 已执行的指令条数（含函数与跳转块内的指令）
+     * @return uint64_t
+     */
+    [[nodiscard]] uint64_t instructionsRetired() const { return instructions_retired; }
+    /**
+     * 堆槽位峰值，堆只增不减，槽位数即峰值
+     * @return size_t
+     */
+    [[nodiscard]] size_t peakHeapSlots() const { return heap.size(); }
+    /**
+     * 设置 LDC 使用的常量池，运行同一镜像的虚拟机可以共用一个池；已校验的程序需要重新校验
+     * @param pool
+     * @return void
+     */
+    void setConstants(std::shared_ptr<const ConstantPool> pool);
+    /**
+     * 当前常量池，未设置时为空
+     * @return const std::shared_ptr<const ConstantPool>&
+     */
+    [[nodiscard]] const std::shared_ptr<const ConstantPool>& constantPool() const { return constants; }
+    /**
+     * 不限制燃料
+     */
+    static constexpr int64_t UNLIMITED_FUEL = INT64_MAX;
+    /**
+     * 设置燃料（指令预算）。燃料只在进入跳转块（循环的回边）、调用函数与 TAILCALL 时按整个程序的长度预扣，
+     * 热循环内不逐条检查；耗尽时在 VmTask 中挂起，否则抛出 VmOutOfFuel。AOT 模块不消耗燃料
+     * @param fuel
+     * @return void
+     */
+    void setFuel(int64_t fuel) { this->fuel = fuel; }
+    /**
+     * 剩余燃料，挂起时为负，表示已预扣但尚未补足的部分
+     * @return int64_t
+     */
+    [[nodiscard]] int64_t fuelLeft() const { return fuel; }
+    static constexpr size_t STACK_RESERVE = 64 << 10; // 栈底留给 VMCALL、异常展开与宿主自身的空间
+    /**
+     * 不限制帧深度，只按所在栈的实际边界报错
+     */
+    static constexpr size_t UNLIMITED_FRAME_DEPTH = SIZE_MAX;
+    /**
+     * 设置解释帧深度上限，进入更深的跳转块或函数时抛出 VmStackOverflow。默认不限制：
+     * 解释帧接近所在栈（宿主线程栈或任务栈）的底部、只剩 STACK_RESERVE 时同样抛出
+     * @param depth
+     * @return void
+     */
+    void setMaxFrameDepth(size_t depth) { max_frame_depth = depth; }
+    /**
+     * 当前解释帧深度上限
+     * @return size_t
+     */
+    [[nodiscard]] size_t maxFrameDepth() const { return max_frame_depth; }
+    /**
+     * 最近一次运行中 VMCALL 2 请求的退出码，没有请求退出时为空
+     * @return std::optional<int>
+     */
+    [[nodiscard]] std::optional<int> exitStatus() const { return exit_status; }
 private:
+    friend class FileIO;
+    friend class Verifier;
+    friend class Optimizer;
+    friend class Snapshot;
+    friend class AotCompiler;
+    friend class AotModule;
+    friend class VmTask;
     int64_t heap_ptr = 1;        // 堆指针
-    std::map<int64_t, std::shared_ptr<std::fstream>> file_descriptors; // 文件描述符映射
-    int64_t next_file_descriptor = 1; // 下一个文件描述符
+    FileTable file_descriptors; // 文件描述符表
+    std::vector<size_t> free_heap_slots; // 空闲堆槽位
+    size_t heap_limit = 0; // 堆槽位上限，0 为不限制
+    uint64_t instructions_retired = 0; // 已执行指令数，帧退出时累加
+    const std::vector<OpCodeImpl::Instruction>* verified_entry = nullptr; // 已通过校验的入口程序
+    uint64_t verified_hash = 0; // 校验时全部程序的指纹，runVerified 比对，校验后被原地修改的程序不会以无检查模式运行
+    std::vector<const std::function<void(const OpCodeImpl::Instruction*)>*> vm_call_table; // 校验后展开的VMCALL表
+    FuncLoader func_loader;            // 延迟加载函数的解码回调
+    size_t lazy_func_base = 0;         // 延迟加载的第一个函数下标
+    std::vector<uint8_t> pending_funcs; // 按函数下标标记尚未加载的函数
+    size_t pending_func_count = 0;
+    std::shared_ptr<const Shape> root_shape = std::make_shared<const Shape>(nullptr, 0); // 空记录的 Shape，转移树的根
+    std::vector<FieldCache> field_caches; // GETFIELD/SETFIELD 的内联缓存，下标为 Instruction::cache
+    std::vector<CallCache> call_caches; // CALLR 的调用点缓存，下标为 Instruction::cache
+    std::vector<LmCodeObject*> code_objects; // 按函数下标缓存的代码对象，NEWF 首次用到时创建
+    // SWITCH 的跳转表及编译它的指令；编号存在指令里，别的虚拟机分配的编号可能指向本虚拟机中别的指令的表
+    struct SwitchCache {
+        const OpCodeImpl::Instruction* source;
+        SwitchTable table;
+    };
+    std::vector<SwitchCache> switch_tables; // 下标为 Instruction::cache，首次执行时编译
+    // MNEXT 放字符串键的堆槽位及其中的键，同一调用点每次迭代复用
+    struct MapKeySlot {
+        size_t slot = 0;
+        const LmHeapObject* key = nullptr;
+    };
+    std::vector<MapKeySlot> map_key_slots; // 下标为 Instruction::cache
+    std::shared_ptr<const ConstantPool> constants; // LDC 的常量池
+    std::vector<size_t> constant_slots; // 各常量在本虚拟机堆上的地址，0 为尚未放入，首次 LDC 时放入
+    int64_t fuel = UNLIMITED_FUEL; // 剩余燃料
+    VmTask* task = nullptr; // 正在运行本虚拟机的任务，燃料耗尽时在其中挂起
+    std::optional<int> exit_status; // VMCALL 2 的退出码
+
+    /**
+     * 燃料耗尽：在任务中挂起直到燃料补足，不在任务中时抛出 VmOutOfFuel
+     * @return void
+     */
+    void outOfFuel();
+
+    /**
+     * 首次调用时解码函数，程序已校验时一并校验
+     * @param index
+     * @return void
+     */
+    void loadFunc(size_t index);
+
+    /**
+     * 预留程序静态引用的堆槽位，超出堆上限时抛出
+     * @param static_heap_slots
+     * @return void
+     */
+    void reserveStaticHeap(size_t static_heap_slots);
+
+    /**
+     * 记录入口程序已通过校验：预留静态堆槽位并展开 VMCALL 表
+     * @param entry
+     * @param static_heap_slots 程序静态引用的堆槽位数（最大地址 + 1）
+     * @return void
+     */
+    void markVerified(const std::vector<OpCodeImpl::Instruction>& entry, size_t static_heap_slots);
+
+    /**
+     * 入口程序与全部函数/跳转块的指纹；各程序按所在表与下标单独计算后异或，延迟加载的函数可以单独替换
+     * @param entry
+     * @return uint64_t
+     */
+    [[nodiscard]] uint64_t programsHash(const std::vector<OpCodeImpl::Instruction>& entry) const;
+
+    // 陷阱处理块，depth 为安装它的解释帧深度
+    struct TrapHandler {
+        size_t block;
+        size_t depth;
+    };
+    std::vector<TrapHandler> trap_handlers; // 陷阱处理栈
+    TrapCode pending_trap = TrapCode::None; // 正在展开的陷阱
+    size_t frame_depth = 0; // 当前解释帧深度
+    size_t max_frame_depth = UNLIMITED_FRAME_DEPTH; // 解释帧深度上限
+    uintptr_t stack_floor = 0; // 解释帧不能越过的栈地址（栈向下增长），由 run/runVerified 或 VmTask 设置，0 为不检查
+
+    /**
+     * 检查除法是否会触发陷阱
+     * @param dividend
+     * @param divisor
+     * @return TrapCode
+     */
+    static TrapCode divideTrap(int64_t dividend, int64_t divisor) {
+        // 一次无符号比较同时筛掉 0 与 -1 以外的除数
+        if (static_cast<uint64_t>(divisor) + 1 > 1) return TrapCode::None;
+        if (divisor == 0) return TrapCode::DivideByZero;
+        return dividend == INT64_MIN ? TrapCode::DivideOverflow : TrapCode::None;
+    }
+
+    /**
+     * 触发陷阱，没有处理块时直接抛出 VmTrap
+     * @param code
+     * @return void
+     */
+    void raiseTrap(TrapCode code);
+
+    /**
+     * 在当前帧内处理陷阱：执行处理块并返回 at 之后匹配的 ENDTRY，没有时返回 end
+     * 处理块中再次出错并由本帧外层的 TRY 处理时，以返回的 ENDTRY 作为下一次的 at
+     * @tparam kChecked
+     * @param at 出错的指令
+     * @param end
+     * @return const OpCodeImpl::Instruction*
+     */
+    template<bool kChecked>
+    const OpCodeImpl::Instruction* handleTrap(const OpCodeImpl::Instruction* at, const OpCodeImpl::Instruction* end);
 protected:
     /**
       * 虚拟机报错
@@ -141,7 +441,7 @@ protected:
       */
     static void vm_error(const OpCodeImpl::Instruction& instr);
     /**
-    * if判断
+    * if判断，两侧都是寄存器（int64_t）时比较码可以加上 CMP_FLOAT 按 double 比较
     * @tparam T1 模板参数
     * @tparam T2 模板参数
     * @param bool_cmp
@@ -153,18 +453,215 @@ protected:
     static bool cmpIfBool(int8_t bool_cmp, T1 left, T2 right);
     std::vector<std::vector<OpCodeImpl::Instruction>> FuncLists; // 函数列表
     std::vector<std::vector<OpCodeImpl::Instruction>> CallLists; // 控制流跳转所用的，避免与FuncLists混淆
+    /**
+     * 解释执行
+     * @tparam kChecked 为 false 时去掉运行期检查，仅用于已校验的程序
+     * @param program
+     * @return void
+     */
+    template<bool kChecked>
+    void execute(const std::vector<OpCodeImpl::Instruction>& program);
     /**
      * 函数调用指令实现封装
+     * @tparam kChecked
+     * @param index FuncLists 中的下标
+     * @param function CALLR 调用的函数对象，CALL 为 nullptr
+     * @param capture_base 捕获值写入的第一个寄存器
+     * @return void
+     */
+    template<bool kChecked>
+    void funcCalling(size_t index, const LmFunction* function, int64_t capture_base);
+    /**
+     * NEWF：新建函数对象，捕获 data 中列出的寄存器，地址写入 r[rd]
      * @param instr
      * @return void
      */
-    void funcCalling(const OpCodeImpl::Instruction* instr);
+    void newFunction(const OpCodeImpl::Instruction* instr);
+    /**
+     * CALLR 的调用目标：先查调用点缓存，命中时只比较函数对象指针
+     * @param instr
+     * @return const CallCache&
+     */
+    const CallCache& callTarget(const OpCodeImpl::Instruction* instr);
+    /**
+     * 调用点缓存未命中：检查 r[rs] 是函数对象且捕获值放得下，再填入缓存
+     * @param instr
+     * @param obj r[rs] 指向的堆对象，可能为 nullptr
+     * @return const CallCache&
+     */
+    const CallCache& callCacheMiss(const OpCodeImpl::Instruction* instr, LmHeapObject* obj);
+    /**
+     * AOT 模块的 CALLR：解析调用目标并把捕获值写入寄存器，返回函数下标，program 已校验
+     * @param instr
+     * @return size_t
+     */
+    size_t enterCallTarget(const OpCodeImpl::Instruction* instr);
+    /**
+     * SWITCH 的跳转块：按指令的跳转表查 r[rd]，没有匹配分支且没有默认块时返回 -1
+     * @param instr
+     * @return int64_t
+     */
+    int64_t switchTarget(const OpCodeImpl::Instruction* instr);
+    /**
+     * 首次执行 SWITCH（或编号不属于这条指令）时编译跳转表并记下编号
+     * @param instr
+     * @return const SwitchTable&
+     */
+    const SwitchTable& compileSwitch(const OpCodeImpl::Instruction* instr);
     /**
      * 向堆新分配内存
      * @param instr
      * @return void
      */
     void newOnHeap(const OpCodeImpl::Instruction* instr);
+    /**
+     * 批量数组指令（AFILL ~ ACMP），寄存器中的地址不是数组时抛出 std::runtime_error
+     * @param instr
+     * @return void
+     */
+    void arrayOp(const OpCodeImpl::Instruction* instr);
+    /**
+     * 取寄存器中的地址指向的数组
+     * @param reg
+     * @return LmArray&
+     */
+    LmArray& arrayAt(uint8_t reg);
+    /**
+     * 哈希表指令（MNEW ~ MNEXT），地址不是表、键不是字符串时抛出 std::runtime_error
+     * @param instr
+     * @return void
+     */
+    void mapOp(const OpCodeImpl::Instruction* instr);
+    /**
+     * 取寄存器中的地址指向的哈希表
+     * @param reg
+     * @return LmMap&
+     */
+    LmMap& mapAt(uint8_t reg);
+    /**
+     * 把 MNEXT 取出的字符串键放到本调用点的堆槽位上；槽位仍存放上一次的键时原地替换，否则新分配
+     * @param instr
+     * @param key
+     * @return size_t 堆地址
+     */
+    size_t mapKeySlot(const OpCodeImpl::Instruction* instr, LmHeapObject* key);
+    /**
+     * 哈希表指令的键：imm 指定的寄存器编码为 Smi，带 MAP_KEY_STRING 时取其中地址指向的字符串
+     * @param instr
+     * @return TaggedVal
+     */
+    TaggedVal mapKey(const OpCodeImpl::Instruction* instr);
+    /**
+     * 取寄存器中的地址指向的记录
+     * @param reg
+     * @return LmRecord&
+     */
+    LmRecord& recordAt(uint8_t reg);
+    /**
+     * LDX：按基址寄存器中的对象类型读取第 index 个元素，类型不支持或下标越界时抛出 std::runtime_error
+     * 数组元素须为 Smi，紧凑数组按元素宽度符号扩展，LmBuffer 按无符号字节读取（0~255）
+     * @param base 存放对象地址的寄存器
+     * @param index
+     * @return int64_t
+     */
+    int64_t loadIndexed(uint8_t base, int64_t index);
+    /**
+     * STX：按基址寄存器中的对象类型写入第 index 个元素，数组写入 Smi，紧凑数组与 LmBuffer 截断为元素宽度
+     * @param base
+     * @param index
+     * @param value
+     * @return void
+     */
+    void storeIndexed(uint8_t base, int64_t index, int64_t value);
+    /**
+     * LDC：常量的堆地址，常量首次用到时放入堆中，之后只比较槽位；kChecked 时检查下标
+     * @tparam kChecked
+     * @param instr
+     * @return int64_t
+     */
+    template<bool kChecked>
+    int64_t constantAddress(const OpCodeImpl::Instruction* instr);
+    /**
+     * 把常量放入堆中并记下地址
+     * @param index
+     * @return size_t
+     */
+    size_t bindConstant(size_t index);
+    /**
+     * 指令的内联缓存，首次执行时分配
+     * @param instr
+     * @return FieldCache&
+     */
+    FieldCache& fieldCache(const OpCodeImpl::Instruction* instr);
+    /**
+     * GETFIELD：先查内联缓存，命中时只比较 Shape 再按偏移读取
+     * @param instr
+     * @return void
+     */
+    void getField(const OpCodeImpl::Instruction* instr);
+    /**
+     * SETFIELD：先查内联缓存，命中时只比较 Shape 再按偏移写入或追加
+     * @param instr
+     * @return void
+     */
+    void setField(const OpCodeImpl::Instruction* instr);
+    /**
+     * 内联缓存未命中：沿 Shape 链查找偏移并填入缓存
+     * @param instr
+     * @param record
+     * @param store 为 true 时处理 SETFIELD
+     * @return void
+     */
+    void fieldCacheMiss(const OpCodeImpl::Instruction* instr, LmRecord& record, bool store);
+    /**
+     * 由 data 中的原始字节新建紧凑数组，地址写入 r1
+     * @param instr
+     * @return void
+     */
+    void newTypedOnHeap(const OpCodeImpl::Instruction* instr);
+    /**
+     * 取紧凑数组元素的地址：数组在 r[rs]，下标在 r[imm]，类型不符或下标越界时抛出 std::runtime_error
+     * @tparam kChecked
+     * @tparam kStore 为写入取地址，数组是常量时抛出
+     * @param instr
+     * @param type 操作码对应的数组类型
+     * @return uint8_t*
+     */
+    template<bool kChecked, bool kStore>
+    uint8_t* typedElement(const OpCodeImpl::Instruction* instr, HeapObjType type);
+    /**
+     * 紧凑数组读取，整数按符号扩展，f64 按 int64_t 取原始位
+     * @tparam T 元素的存储类型
+     * @tparam kChecked
+     * @param instr
+     * @param type
+     * @return void
+     */
+    template<typename T, bool kChecked>
+    void typedLoad(const OpCodeImpl::Instruction* instr, HeapObjType type);
+    /**
+     * 紧凑数组写入，整数截断为元素宽度
+     * @tparam T 元素的存储类型
+     * @tparam kChecked
+     * @param instr
+     * @param type
+     * @return void
+     */
+    template<typename T, bool kChecked>
+    void typedStore(const OpCodeImpl::Instruction* instr, HeapObjType type);
+    /**
+     * 访问堆对象的指令（批量数组与紧凑数组），供 AOT 模块回调，program 已校验
+     * @param instr
+     * @return void
+     */
+    void heapOp(const OpCodeImpl::Instruction* instr);
+    /**
+     * CVT 的转换，mode 不是 CvtMode 时抛出 std::runtime_error
+     * @param mode
+     * @param value 寄存器的位
+     * @return int64_t
+     */
+    static int64_t convert(int64_t mode, int64_t value);
 
 
     template<typename T1, typename T2>
@@ -225,6 +722,17 @@ protected:
      */
     static bool cmpLe(T1 left, T2 right) { return left <= right; }
 
+    template<bool (*Cmp)(double, double)>
+    /**
+     * 把寄存器中的位按 double 比较，有 NaN 时只有 != 成立
+     * @param left
+     * @param right
+     * @return bool
+     */
+    static bool cmpF64Bits(int64_t left, int64_t right) {
+        return Cmp(std::bit_cast<double>(left), std::bit_cast<double>(right));
+    }
+
 #ifdef __GNUC__
     template<typename T1, typename T2>
     static constexpr CmpFunc<T1, T2> cmp_table[] = {
@@ -249,4 +757,13 @@ protected:
         cmpLe<T1, T2>    // 5
     };
 #endif
+
+    // IFRR 使用的比较表，下标为比较码
+    static constexpr CmpFunc<int64_t, int64_t> reg_cmp_table[] = {
+        cmpEq<int64_t, int64_t>, cmpNe<int64_t, int64_t>, cmpGt<int64_t, int64_t>,
+        cmpLt<int64_t, int64_t>, cmpGe<int64_t, int64_t>, cmpLe<int64_t, int64_t>,
+        // CMP_FLOAT 起
+        cmpF64Bits<cmpEq<double, double>>, cmpF64Bits<cmpNe<double, double>>, cmpF64Bits<cmpGt<double, double>>,
+        cmpF64Bits<cmpLt<double, double>>, cmpF64Bits<cmpGe<double, double>>, cmpF64Bits<cmpLe<double, double>>
+    };
 };
@@ -6,7 +6,144 @@
 ********************************************************/
 #include "console_io.hpp"
 #include "../vm/handler.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <string>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 暂存区最小大小
+constexpr size_t STDIN_STAGING_SIZE = 1 << 20;
+
+namespace {
+    /**
+     * 从标准输入读取一次，有多少返回多少，出错按 EOF 处理
+     */
+    size_t readStdin(uint8_t* dst, size_t count) {
+#ifdef _WIN32
+        const int n = ::_read(0, dst, static_cast<unsigned int>(std::min<size_t>(count, INT32_MAX)));
+#else
+        ssize_t n;
+        do {
+            n = ::read(STDIN_FILENO, dst, count);
+        } while (n < 0 && errno == EINTR);
+#endif
+        return n > 0 ? static_cast<size_t>(n) : 0;
+    }
+}
+
+StdinStream& StdinStream::instance() {
+    static StdinStream stream;
+    return stream;
+}
+
+StdinStream::StdinStream() {
+#ifndef _WIN32
+    struct stat st{};
+    if (::fstat(STDIN_FILENO, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        // 从当前位置开始映射，兼容已被部分消费的标准输入
+        off_t pos = ::lseek(STDIN_FILENO, 0, SEEK_CUR);
+        if (pos >= 0 && pos < st.st_size) {
+            void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+            if (addr != MAP_FAILED) {
+                ::madvise(addr, st.st_size, MADV_SEQUENTIAL);
+                mapped_ = static_cast<const uint8_t*>(addr);
+                mapped_size_ = static_cast<size_t>(st.st_size);
+                begin_ = static_cast<size_t>(pos);
+                end_ = mapped_size_;
+                eof_ = true;
+            }
+        }
+    }
+#endif
+}
+
+StdinStream::~StdinStream() {
+#ifndef _WIN32
+    if (mapped_) ::munmap(const_cast<uint8_t*>(mapped_), mapped_size_);
+#endif
+}
+
+size_t StdinStream::fill(size_t want) {
+    if (mapped_ || eof_ || end_ - begin_ >= want) return end_ - begin_;
+    // 压缩暂存区并按需扩容
+    if (begin_ > 0) {
+        std::memmove(staging_.data(), staging_.data() + begin_, end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+    }
+    if (staging_.size() < std::max(want, STDIN_STAGING_SIZE)) {
+        staging_.resize(std::max(want, STDIN_STAGING_SIZE));
+    }
+    const size_t n = readStdin(staging_.data() + end_, staging_.size() - end_);
+    if (n == 0) eof_ = true;
+    end_ += n;
+    return end_;
+}
+
+size_t StdinStream::readChunk(uint8_t* dst, size_t capacity) {
+    size_t taken = std::min(end_ - begin_, capacity);
+    if (taken > 0) {
+        std::memcpy(dst, pending(), taken);
+        begin_ += taken;
+        return taken;
+    }
+    // 暂存区已清空，直接读入目标缓冲区
+    if (eof_ || capacity == 0) return 0;
+    taken = readStdin(dst, capacity);
+    if (taken == 0) eof_ = true;
+    return taken;
+}
+
+bool StdinStream::readLine(std::string& line) {
+    line.clear();
+    size_t scanned = 0;
+    while (true) {
+        const size_t avail = end_ - begin_;
+        const auto* src = pending();
+        const auto* newline = avail > scanned ? static_cast<const uint8_t*>(std::memchr(src + scanned, '\n', avail - scanned)) : nullptr;
+        if (newline != nullptr || eof_) {
+            const size_t length = newline != nullptr ? static_cast<size_t>(newline - src) : avail;
+            line.assign(reinterpret_cast<const char*>(src), length);
+            begin_ += newline != nullptr ? length + 1 : length;
+            return newline != nullptr || length > 0;
+        }
+        scanned = avail;
+        fill(avail + 1);
+    }
+}
+
+size_t StdinStream::readLines(uint8_t* dst, size_t capacity, size_t& lines) {
+    lines = 0;
+    if (capacity == 0) return 0;
+    // 只等到有一个完整行（或暂存满 capacity、EOF）为止，逐行写入的管道不会被阻塞
+    size_t avail = end_ - begin_;
+    while (avail < capacity && !eof_ && (avail == 0 || std::memchr(pending(), '\n', avail) == nullptr)) avail = fill(avail + 1);
+    if (avail == 0) return 0;
+
+    const uint8_t* src = pending();
+    size_t taken = std::min(avail, capacity);
+    // 输入末尾的残行直接交出，否则只交出完整行
+    if (!(eof_ && taken == avail)) {
+        const uint8_t* last = src + taken;
+        while (last > src && last[-1] != '\n') --last;
+        if (last > src) taken = static_cast<size_t>(last - src);
+    }
+    std::memcpy(dst, src, taken);
+    begin_ += taken;
+
+    lines = static_cast<size_t>(std::count(dst, dst + taken, '\n'));
+    if (taken > 0 && dst[taken - 1] != '\n') lines++;
+    return taken;
+}
 void ConsoleIO::vmCallPrint() {
     RegisterVM::vm_call_handlers[0] = [](const OpCodeImpl::Instruction*) {
         RegisterVM* vm = Handler::current_vm;
@@ -52,16 +189,16 @@ void ConsoleIO::vmCallInput() {
             }
         }
         fputs(prompt.c_str(), stdout);
+        std::fflush(stdout);
+        // 与块读取共用同一个流，混用时输入不会丢失或重复
         std::string input;
-        std::getline(std::cin, input);
+        StdinStream::instance().readLine(input);
         auto* arr = new LmArray(input.length() + 1);
         for (size_t i = 0; i < input.length(); ++i) {
             arr->push(TaggedUtil::encode_Smi(input[i]));
         }
         arr->push(TaggedUtil::encode_Smi(0));
-        size_t output_addr = vm->heap.size();
-        vm->heap.push_back(arr);
-        vm->registers[0] = static_cast<int64_t>(output_addr);
+        vm->registers[0] = static_cast<int64_t>(vm->allocOnHeap(arr));
     };
 }
 
@@ -81,6 +218,49 @@ void ConsoleIO::vmCallExit() {
                 }
             }
         }
-        std::exit(exit_code);
+        // 由宿主决定如何结束，多个租户共用进程时不能直接退出
+        throw VmExit(exit_code);
+    };
+}
+
+void ConsoleIO::vmCallReadChunk() {
+    RegisterVM::vm_call_handlers[11] = [](const OpCodeImpl::Instruction*) {
+        RegisterVM* vm = Handler::current_vm;
+        if (!vm) return;
+
+        const int64_t addr = vm->registers[9];
+        LmBuffer* buf = addr > 0 && static_cast<size_t>(addr) < vm->heap.size()
+                            ? dynamic_cast<LmBuffer*>(vm->heap[addr]) : nullptr;
+        // 常量池中的只读常量不能作为读入缓冲区
+        if (!buf || buf->is_pinned()) {
+            vm->registers[0] = -1;
+            return;
+        }
+        size_t count = buf->get_capacity();
+        if (vm->registers[10] > 0) count = std::min(count, static_cast<size_t>(vm->registers[10]));
+        size_t n = StdinStream::instance().readChunk(buf->data(), count);
+        buf->set_read_size(n);
+        vm->registers[0] = static_cast<int64_t>(n);
+    };
+}
+
+void ConsoleIO::vmCallReadLines() {
+    RegisterVM::vm_call_handlers[12] = [](const OpCodeImpl::Instruction*) {
+        RegisterVM* vm = Handler::current_vm;
+        if (!vm) return;
+
+        const int64_t addr = vm->registers[9];
+        LmBuffer* buf = addr > 0 && static_cast<size_t>(addr) < vm->heap.size()
+                            ? dynamic_cast<LmBuffer*>(vm->heap[addr]) : nullptr;
+        // 常量池中的只读常量不能作为读入缓冲区
+        if (!buf || buf->is_pinned()) {
+            vm->registers[0] = -1;
+            return;
+        }
+        size_t lines = 0;
+        size_t n = StdinStream::instance().readLines(buf->data(), buf->get_capacity(), lines);
+        buf->set_read_size(n);
+        vm->registers[0] = static_cast<int64_t>(n);
+        vm->registers[1] = static_cast<int64_t>(lines);
     };
 }
@@ -5,7 +5,72 @@
 -     This project is followed GPL-3.0 license
 ********************************************************/
 #pragma once
-#include <iostream>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * 标准输入块读取流，所有读取标准输入的 VMCALL 都经过它，已暂存的数据不会丢失或重复
+ * 标准输入为普通文件时整体 mmap，否则经由暂存区读取；管道与终端按 read 的短读返回，不等待凑满一块
+ */
+class StdinStream {
+public:
+    /**
+     * 获取进程唯一实例
+     * @return StdinStream&
+     */
+    static StdinStream& instance();
+
+    /**
+     * 读取一块数据，管道与终端上可能少于 capacity
+     * @param dst
+     * @param capacity
+     * @return size_t 读取字节数，0 表示 EOF
+     */
+    size_t readChunk(uint8_t* dst, size_t capacity);
+
+    /**
+     * 读取一行，不含换行符
+     * @param line
+     * @return bool EOF 且没有数据时返回 false
+     */
+    bool readLine(std::string& line);
+
+    /**
+     * 读取已到达的完整行，至少等到一行（单行超过容量时截断返回）
+     * @param dst
+     * @param capacity
+     * @param lines 输出行数
+     * @return size_t 读取字节数，0 表示 EOF
+     */
+    size_t readLines(uint8_t* dst, size_t capacity, size_t& lines);
+
+    ~StdinStream();
+    StdinStream(const StdinStream&) = delete;
+    StdinStream& operator=(const StdinStream&) = delete;
+private:
+    StdinStream();
+
+    /**
+     * 暂存区不足 want 字节时读取一次（可能短读）
+     * @param want
+     * @return size_t 可用字节数
+     */
+    size_t fill(size_t want);
+
+    /**
+     * 未消费数据的起点
+     * @return const uint8_t*
+     */
+    [[nodiscard]] const uint8_t* pending() const { return (mapped_ ? mapped_ : staging_.data()) + begin_; }
+
+    const uint8_t* mapped_ = nullptr; // mmap 的标准输入
+    size_t mapped_size_ = 0;
+    std::vector<uint8_t> staging_; // 暂存区
+    size_t begin_ = 0; // 未消费数据起点
+    size_t end_ = 0; // 未消费数据终点
+    bool eof_ = false;
+};
 
 class ConsoleIO{
 public:
@@ -26,4 +91,16 @@ public:
      * @return void
      */
     static void vmCallExit();
+
+    /**
+     * 块读取标准输入 r9:缓冲区堆地址 r10:字节数 -> r0:读取字节数
+     * @return void
+     */
+    static void vmCallReadChunk();
+
+    /**
+     * 按行批量读取标准输入 r9:缓冲区堆地址 -> r0:读取字节数 r1:行数
+     * @return void
+     */
+    static void vmCallReadLines();
 };
\ No newline at end of file
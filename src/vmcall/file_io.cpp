@@ -0,0 +1,413 @@
+/******************************************************
+-     Date:  2026.10.19 10:12
+-     File:  file_io.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "file_io.hpp"
+#include "../vm/handler.hpp"
+#include <algorithm>
+#include <fcntl.h>
+#include <string>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    int nativeOpen(const char* path, int flags) { return ::_open(path, flags | _O_BINARY, 0644); }
+    int nativeClose(int handle) { return ::_close(handle); }
+    int64_t nativeRead(int handle, uint8_t* dst, size_t count) {
+        return ::_read(handle, dst, static_cast<unsigned int>(count));
+    }
+    int64_t nativeWrite(int handle, const uint8_t* src, size_t count) {
+        return ::_write(handle, src, static_cast<unsigned int>(count));
+    }
+    int64_t nativeSeek(int handle, int64_t offset, int whence) { return ::_lseeki64(handle, offset, whence); }
+    int64_t nativePread(int handle, uint8_t* dst, size_t count, int64_t offset) {
+        OVERLAPPED ov{};
+        ov.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD got = 0;
+        auto h = reinterpret_cast<HANDLE>(::_get_osfhandle(handle));
+        if (!::ReadFile(h, dst, static_cast<DWORD>(count), &got, &ov)) {
+            return ::GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+        }
+        return got;
+    }
+#else
+    int nativeOpen(const char* path, int flags) { return ::open(path, flags, 0644); }
+    int nativeClose(int handle) { return ::close(handle); }
+    int64_t nativeRead(int handle, uint8_t* dst, size_t count) { return ::read(handle, dst, count); }
+    int64_t nativeWrite(int handle, const uint8_t* src, size_t count) { return ::write(handle, src, count); }
+    int64_t nativeSeek(int handle, int64_t offset, int whence) { return ::lseek(handle, offset, whence); }
+    int64_t nativePread(int handle, uint8_t* dst, size_t count, int64_t offset) {
+        return ::pread(handle, dst, count, offset);
+    }
+#endif
+
+    /**
+     * 循环读取直到读满或 EOF
+     */
+    int64_t readFull(int handle, uint8_t* dst, size_t count, int64_t offset) {
+        size_t total = 0;
+        while (total < count) {
+            int64_t n = offset < 0 ? nativeRead(handle, dst + total, count - total)
+                                   : nativePread(handle, dst + total, count - total, offset + total);
+            if (n < 0) return total > 0 ? static_cast<int64_t>(total) : -1;
+            if (n == 0) break;
+            total += static_cast<size_t>(n);
+        }
+        return static_cast<int64_t>(total);
+    }
+
+    /**
+     * 从堆对象中取出以 0 结尾的字符串（LmArray 或 LmBuffer）
+     */
+    bool heapString(RegisterVM* vm, int64_t addr, std::string& out) {
+        if (addr <= 0 || static_cast<size_t>(addr) >= vm->heap.size() || vm->heap[addr] == nullptr) return false;
+        LmHeapObject* obj = vm->heap[addr];
+        if (auto* arr = dynamic_cast<LmArray*>(obj)) {
+            for (size_t i = 0; i < arr->get_size(); ++i) {
+                TaggedVal val = arr->get(i);
+                if (TaggedUtil::get_tagged_type(val) != TaggedType::Smi) continue;
+                char c = static_cast<char>(TaggedUtil::decode_Smi(val));
+                if (c == 0) break;
+                out += c;
+            }
+            return true;
+        }
+        if (auto* buf = dynamic_cast<LmBuffer*>(obj)) {
+            const auto* p = reinterpret_cast<const char*>(buf->data());
+            out.assign(p, std::find(p, p + buf->get_size(), '\0'));
+            return true;
+        }
+        return false;
+    }
+
+    LmBuffer* heapBuffer(RegisterVM* vm, int64_t addr) {
+        if (addr <= 0 || static_cast<size_t>(addr) >= vm->heap.size()) return nullptr;
+        return dynamic_cast<LmBuffer*>(vm->heap[addr]);
+    }
+
+    // 读入的目标缓冲区，常量池中的只读常量不能被写入
+    LmBuffer* readBuffer(RegisterVM* vm, int64_t addr) {
+        LmBuffer* buf = heapBuffer(vm, addr);
+        return buf != nullptr && !buf->is_pinned() ? buf : nullptr;
+    }
+
+    size_t clampCount(int64_t requested, size_t limit) {
+        if (requested <= 0) return limit;
+        return std::min(static_cast<size_t>(requested), limit);
+    }
+}
+
+FileTable::FileTable() {
+    // 预置标准输入/输出/错误，不由表关闭
+    descriptors_.resize(3);
+    for (int i = 0; i < 3; ++i) {
+        descriptors_[i].handle = i;
+        descriptors_[i].owned = false;
+    }
+}
+
+FileTable::~FileTable() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    queue_cv_.notify_all();
+    for (auto& worker : workers_) worker.join();
+    for (auto& req : requests_) {
+        if (req.in_use && req.buffer) req.buffer->del_ref();
+    }
+    for (auto& desc : descriptors_) {
+        if (desc.owned && desc.handle >= 0) nativeClose(desc.handle);
+    }
+    // 工作线程已退出，推迟关闭的句柄不会再被读取
+    for (int handle : deferred_closes_) nativeClose(handle);
+}
+
+int FileTable::nativeHandle(int64_t fd) const {
+    if (fd < 0 || static_cast<size_t>(fd) >= descriptors_.size()) return -1;
+    return descriptors_[fd].handle;
+}
+
+int64_t FileTable::open(const char* path, int64_t mode) {
+    int flags = 0;
+    const bool want_read = mode & MODE_READ;
+    const bool want_write = mode & (MODE_WRITE | MODE_APPEND);
+    if (want_read && want_write) flags |= O_RDWR;
+    else if (want_write) flags |= O_WRONLY;
+    else flags |= O_RDONLY;
+    if (mode & MODE_CREATE) flags |= O_CREAT;
+    if (mode & MODE_TRUNC) flags |= O_TRUNC;
+    if (mode & MODE_APPEND) flags |= O_APPEND;
+
+    int handle = nativeOpen(path, flags);
+    if (handle < 0) return -1;
+
+    int64_t fd;
+    if (!free_descriptors_.empty()) {
+        fd = free_descriptors_.back();
+        free_descriptors_.pop_back();
+    } else {
+        fd = static_cast<int64_t>(descriptors_.size());
+        descriptors_.emplace_back();
+    }
+    descriptors_[fd].handle = handle;
+    descriptors_[fd].owned = true;
+    return fd;
+}
+
+int64_t FileTable::close(int64_t fd) {
+    int handle = nativeHandle(fd);
+    if (handle < 0) return -1;
+    Descriptor& desc = descriptors_[fd];
+    int rc = 0;
+    if (desc.owned) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (readPending(handle)) deferred_closes_.push_back(handle);
+        else rc = nativeClose(handle);
+    }
+    desc.handle = -1;
+    desc.owned = false;
+    free_descriptors_.push_back(fd);
+    return rc < 0 ? -1 : 0;
+}
+
+int64_t FileTable::read(int64_t fd, uint8_t* dst, size_t count) {
+    int handle = nativeHandle(fd);
+    if (handle < 0) return -1;
+    return readFull(handle, dst, count, -1);
+}
+
+int64_t FileTable::write(int64_t fd, const uint8_t* src, size_t count) {
+    int handle = nativeHandle(fd);
+    if (handle < 0) return -1;
+    size_t total = 0;
+    while (total < count) {
+        int64_t n = nativeWrite(handle, src + total, count - total);
+        if (n <= 0) return total > 0 ? static_cast<int64_t>(total) : -1;
+        total += static_cast<size_t>(n);
+    }
+    return static_cast<int64_t>(total);
+}
+
+int64_t FileTable::seek(int64_t fd, int64_t offset, int64_t whence) {
+    int handle = nativeHandle(fd);
+    if (handle < 0 || whence < 0 || whence > 2) return -1;
+    static constexpr int whence_table[] = {SEEK_SET, SEEK_CUR, SEEK_END};
+    return nativeSeek(handle, offset, whence_table[whence]);
+}
+
+int64_t FileTable::submitRead(int64_t fd, LmBuffer* buffer, size_t count, int64_t offset) {
+    int handle = nativeHandle(fd);
+    if (handle < 0 || buffer == nullptr) return -1;
+    count = std::min(count, buffer->get_capacity());
+    if (offset < 0) {
+        // 使用当前位置并提前推进，后续读写不会与本次请求重叠
+        offset = nativeSeek(handle, 0, SEEK_CUR);
+        if (offset < 0) return -1;
+        nativeSeek(handle, static_cast<int64_t>(count), SEEK_CUR);
+    }
+
+    startWorkers();
+    buffer->make_ref();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t id;
+    if (!free_requests_.empty()) {
+        id = free_requests_.back();
+        free_requests_.pop_back();
+    } else {
+        id = static_cast<int64_t>(requests_.size());
+        requests_.emplace_back();
+    }
+    AsyncRequest& req = requests_[id];
+    req.handle = handle;
+    req.buffer = buffer;
+    req.count = count;
+    req.offset = offset;
+    req.result = 0;
+    req.done = false;
+    req.in_use = true;
+    queue_.push_back(id);
+    queue_cv_.notify_one();
+    return id;
+}
+
+int64_t FileTable::await(int64_t request) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (request < 0 || static_cast<size_t>(request) >= requests_.size() || !requests_[request].in_use) return -1;
+    done_cv_.wait(lock, [&] { return requests_[request].done; });
+
+    AsyncRequest& req = requests_[request];
+    int64_t result = req.result;
+    LmBuffer* buffer = req.buffer;
+    req.buffer = nullptr;
+    req.in_use = false;
+    free_requests_.push_back(request);
+    lock.unlock();
+
+    // 引用计数不是线程安全的，只在 VM 线程上释放
+    if (result >= 0) buffer->set_read_size(static_cast<size_t>(result));
+    buffer->del_ref();
+    return result;
+}
+
+bool FileTable::readPending(int handle) const {
+    return std::any_of(requests_.begin(), requests_.end(),
+                       [&](const AsyncRequest& req) { return req.in_use && !req.done && req.handle == handle; });
+}
+
+void FileTable::startWorkers() {
+    if (!workers_.empty()) return;
+    unsigned int count = std::clamp(std::thread::hardware_concurrency(), 2u, 4u);
+    for (unsigned int i = 0; i < count; ++i) {
+        workers_.emplace_back(&FileTable::workerLoop, this);
+    }
+}
+
+void FileTable::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        queue_cv_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+        if (stopping_) return;
+        int64_t id = queue_.front();
+        queue_.pop_front();
+        // 请求表可能在提交时扩容，先拷出参数再解锁
+        int handle = requests_[id].handle;
+        uint8_t* dst = requests_[id].buffer->data();
+        size_t count = requests_[id].count;
+        int64_t offset = requests_[id].offset;
+        lock.unlock();
+
+        int64_t result = readFull(handle, dst, count, offset);
+
+        lock.lock();
+        requests_[id].result = result;
+        requests_[id].done = true;
+        // 描述符已关闭且这是句柄上最后一个请求
+        auto deferred = std::find(deferred_closes_.begin(), deferred_closes_.end(), handle);
+        if (deferred != deferred_closes_.end() && !readPending(handle)) {
+            deferred_closes_.erase(deferred);
+            nativeClose(handle);
+        }
+        done_cv_.notify_all();
+    }
+}
+
+void FileIO::vmCallOpen() {
+    RegisterVM::vm_call_handlers[3] = [](const OpCodeImpl::Instruction*) {
+        RegisterVM* vm = Handler::current_vm;
+        if (!vm) return;
+
+        std::string path;
+        if (!heapString(vm, vm->registers[9], path)) {
+            vm->registers[0] = -1;
+            return;
+        }
+        vm->registers[0] = vm->file_descriptors.open(path.c_str(), vm->registers[10]);
+    };
+}
+
+void FileIO::vmCallClose() {
+    RegisterVM::vm_call_handlers[4] = [](const OpCodeImpl::Instruction*) {
+        RegisterVM* vm = Handler::current_vm;
+        if (!vm) return;
+
+        vm->registers[0] = vm->file_descriptors.close(vm->registers[9]);
+    };
+}
+
+void FileIO::vmCallRead() {
+    RegisterVM::vm_call_handlers[5] = [](const OpCodeImpl::Instruction*) {
+        RegisterVM* vm = Handler::current_vm;
+        if (!vm) return;
+
+        LmBuffer* buf = readBuffer(vm, vm->registers[10]);
+        if (!buf) {
+            vm->registers[0] = -1;
+            return;
+        }
+        size_t count = clampCount(vm->registers[11], buf->get_capacity());
+        int64_t n = vm->file_descriptors.read(vm->registers[9], buf->data(), count);
+        buf->set_read_size(n > 0 ? static_cast<size_t>(n) : 0);
+        vm->registers[0] = n;
+    };
+}
+
+void FileIO::vmCallWrite() {
+    RegisterVM::vm_call_handlers[6] = [](const OpCodeImpl::Instruction*) {
+        RegisterVM* vm = Handler::current_vm;
+        if (!vm) return;
+
+        const int64_t addr = vm->registers[10];
+        if (LmBuffer* buf = heapBuffer(vm, addr)) {
+            size_t count = clampCount(vm->registers[11], buf->get_size());
+            vm->registers[0] = vm->file_descriptors.write(vm->registers[9], buf->data(), count);
+            return;
+        }
+        // 兼容 NEW 创建的字节数组
+        std::string str;
+        if (!heapString(vm, addr, str)) {
+            vm->registers[0] = -1;
+            return;
+        }
+        size_t count = clampCount(vm->registers[11], str.size());
+        vm->registers[0] = vm->file_descriptors.write(vm->registers[9],
+                                                       reinterpret_cast<const uint8_t*>(str.data()), count);
+    };
+}
+
+void FileIO::vmCallSeek() {
+    RegisterVM::vm_call_handlers[7] = [](const OpCodeImpl::Instruction*) {
+        RegisterVM* vm = Handler::current_vm;
+        if (!vm) return;
+
+        vm->registers[0] = vm->file_descriptors.seek(vm->registers[9], vm->registers[10], vm->registers[11]);
+    };
+}
+
+void FileIO::vmCallAsyncRead() {
+    RegisterVM::vm_call_handlers[8] = [](const OpCodeImpl::Instruction*) {
+        RegisterVM* vm = Handler::current_vm;
+        if (!vm) return;
+
+        LmBuffer* buf = readBuffer(vm, vm->registers[10]);
+        if (!buf) {
+            vm->registers[0] = -1;
+            return;
+        }
+        size_t count = clampCount(vm->registers[11], buf->get_capacity());
+        vm->registers[0] = vm->file_descriptors.submitRead(vm->registers[9], buf, count, vm->registers[12]);
+    };
+}
+
+void FileIO::vmCallAwait() {
+    RegisterVM::vm_call_handlers[9] = [](const OpCodeImpl::Instruction*) {
+        RegisterVM* vm = Handler::current_vm;
+        if (!vm) return;
+
+        vm->registers[0] = vm->file_descriptors.await(vm->registers[9]);
+    };
+}
+
+void FileIO::vmCallBufferNew() {
+    RegisterVM::vm_call_handlers[10] = [](const OpCodeImpl::Instruction*) {
+        RegisterVM* vm = Handler::current_vm;
+        if (!vm) return;
+
+        const int64_t capacity = vm->registers[9];
+        if (capacity < 0) {
+            vm->registers[0] = -1;
+            return;
+        }
+        vm->registers[0] = static_cast<int64_t>(vm->allocOnHeap(new LmBuffer(static_cast<size_t>(capacity))));
+    };
+}
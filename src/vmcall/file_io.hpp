@@ -0,0 +1,203 @@
+/******************************************************
+-     Date:  2026.10.19 10:12
+-     File:  file_io.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class LmBuffer;
+
+/**
+ * 平坦文件描述符表
+ * 描述符即下标，0/1/2 预置为标准输入/输出/错误，关闭后的槽位会被复用
+ */
+class FileTable {
+public:
+    // 打开模式位（VMCALL 中 r10 的取值）
+    static constexpr int64_t MODE_READ = 1 << 0;
+    static constexpr int64_t MODE_WRITE = 1 << 1;
+    static constexpr int64_t MODE_CREATE = 1 << 2;
+    static constexpr int64_t MODE_TRUNC = 1 << 3;
+    static constexpr int64_t MODE_APPEND = 1 << 4;
+
+    FileTable();
+    ~FileTable();
+    FileTable(const FileTable&) = delete;
+    FileTable& operator=(const FileTable&) = delete;
+
+    /**
+     * 打开文件
+     * @param path
+     * @param mode
+     * @return int64_t 描述符，失败返回 -1
+     */
+    int64_t open(const char* path, int64_t mode);
+
+    /**
+     * 关闭描述符，描述符立即可复用；仍有异步读取在进行时原生句柄推迟到最后一个请求完成后关闭，
+     * 避免句柄被新打开的文件复用后工作线程读错文件
+     * @param fd
+     * @return int64_t 成功返回 0，失败返回 -1
+     */
+    int64_t close(int64_t fd);
+
+    /**
+     * 同步读取，直接写入目标内存
+     * @param fd
+     * @param dst
+     * @param count
+     * @return int64_t 读取字节数，失败返回 -1
+     */
+    int64_t read(int64_t fd, uint8_t* dst, size_t count);
+
+    /**
+     * 同步写入
+     * @param fd
+     * @param src
+     * @param count
+     * @return int64_t 写入字节数，失败返回 -1
+     */
+    int64_t write(int64_t fd, const uint8_t* src, size_t count);
+
+    /**
+     * 移动文件位置
+     * @param fd
+     * @param offset
+     * @param whence 0:SET 1:CUR 2:END
+     * @return int64_t 新位置，失败返回 -1
+     */
+    int64_t seek(int64_t fd, int64_t offset, int64_t whence);
+
+    /**
+     * 提交异步读取，数据直接落入 buffer，期间持有 buffer 的引用
+     * @param fd
+     * @param buffer
+     * @param count
+     * @param offset 文件偏移，小于 0 时使用当前位置
+     * @return int64_t 请求号，失败返回 -1
+     */
+    int64_t submitRead(int64_t fd, LmBuffer* buffer, size_t count, int64_t offset);
+
+    /**
+     * 等待异步读取完成并回收请求
+     * @param request
+     * @return int64_t 读取字节数，失败返回 -1
+     */
+    int64_t await(int64_t request);
+
+    /**
+     * 获取原生句柄
+     * @param fd
+     * @return int 不存在时返回 -1
+     */
+    [[nodiscard]] int nativeHandle(int64_t fd) const;
+
+private:
+    struct Descriptor {
+        int handle = -1;    // 原生句柄
+        bool owned = false; // 是否由表负责关闭
+    };
+
+    struct AsyncRequest {
+        int handle = -1;
+        LmBuffer* buffer = nullptr;
+        size_t count = 0;
+        int64_t offset = 0;
+        int64_t result = 0;
+        bool done = false;
+        bool in_use = false;
+    };
+
+    std::vector<Descriptor> descriptors_; // 描述符表
+    std::vector<int64_t> free_descriptors_; // 可复用的描述符
+    std::vector<AsyncRequest> requests_; // 异步请求表
+    std::vector<int64_t> free_requests_; // 可复用的请求号
+    std::vector<int> deferred_closes_; // 等待异步读取完成后关闭的原生句柄
+
+    // 线程池后备实现（无 io_uring 时使用）
+    std::vector<std::thread> workers_;
+    std::deque<int64_t> queue_;
+    std::mutex mutex_;
+    std::condition_variable queue_cv_;
+    std::condition_variable done_cv_;
+    bool stopping_ = false;
+
+    /**
+     * 按需启动工作线程
+     * @return void
+     */
+    void startWorkers();
+
+    /**
+     * 工作线程主循环
+     * @return void
+     */
+    void workerLoop();
+
+    /**
+     * 句柄上是否还有未完成的异步读取，调用时须持有 mutex_
+     * @param handle
+     * @return bool
+     */
+    [[nodiscard]] bool readPending(int handle) const;
+};
+
+class FileIO {
+public:
+    /**
+     * 打开文件 r9:路径堆地址 r10:模式 -> r0:描述符
+     * @return void
+     */
+    static void vmCallOpen();
+
+    /**
+     * 关闭文件 r9:描述符 -> r0
+     * @return void
+     */
+    static void vmCallClose();
+
+    /**
+     * 读取 r9:描述符 r10:缓冲区堆地址 r11:字节数 -> r0:读取字节数
+     * @return void
+     */
+    static void vmCallRead();
+
+    /**
+     * 写入 r9:描述符 r10:缓冲区堆地址 r11:字节数 -> r0:写入字节数
+     * @return void
+     */
+    static void vmCallWrite();
+
+    /**
+     * 定位 r9:描述符 r10:偏移 r11:起点 -> r0:新位置
+     * @return void
+     */
+    static void vmCallSeek();
+
+    /**
+     * 异步读取 r9:描述符 r10:缓冲区堆地址 r11:字节数 r12:文件偏移 -> r0:请求号
+     * @return void
+     */
+    static void vmCallAsyncRead();
+
+    /**
+     * 等待异步读取 r9:请求号 -> r0:读取字节数
+     * @return void
+     */
+    static void vmCallAwait();
+
+    /**
+     * 新建字节缓冲区 r9:容量 -> r0:堆地址
+     * @return void
+     */
+    static void vmCallBufferNew();
+};
@@ -0,0 +1,23 @@
+/******************************************************
+-     Date:  2026.10.28 10:00
+-     File:  heap_ops.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "heap_ops.hpp"
+#include "../vm/handler.hpp"
+
+void HeapOps::vmCallRelease() {
+    RegisterVM::vm_call_handlers[15] = [](const OpCodeImpl::Instruction*) {
+        RegisterVM* vm = Handler::current_vm;
+        if (!vm) return;
+
+        const int64_t addr = vm->registers[9];
+        if (addr <= 0 || static_cast<size_t>(addr) >= vm->heap.size() || vm->heap[addr] == nullptr) {
+            vm->registers[0] = -1;
+            return;
+        }
+        vm->freeOnHeap(static_cast<size_t>(addr));
+        vm->registers[0] = 0;
+    };
+}
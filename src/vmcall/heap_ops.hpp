@@ -0,0 +1,17 @@
+/******************************************************
+-     Date:  2026.10.28 10:00
+-     File:  heap_ops.hpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#pragma once
+
+class HeapOps {
+public:
+    /**
+     * 释放堆对象 r9:堆地址 -> r0：成功为 0，地址无效时为 -1
+     * 槽位进入空闲列表，之后的分配会复用它；对象仍被数组、映射等持有时只减少引用
+     * @return void
+     */
+    static void vmCallRelease();
+};
@@ -0,0 +1,395 @@
+/******************************************************
+-     Date:  2026.10.28 14:00
+-     File:  differential_test.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "../src/vm/aot.hpp"
+#include "../src/vm/optimizer.hpp"
+#include "../src/vm/vm.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * 差分测试：同一个随机程序分别经 checked、verified、optimized 与 AOT 执行，
+ * 寄存器、静态堆槽位与陷阱结果必须一致。程序带陷阱、TRY、函数调用、条件跳转与堆操作数，
+ * 跳转块只进入下标更大的块、函数只调用下标更大的函数，保证一定结束
+ */
+
+namespace {
+    using OpCode = OpCodeImpl::OpCode;
+    using Instruction = OpCodeImpl::Instruction;
+
+    constexpr size_t PROGRAMS = 300;     // 解释器各档比较的程序数
+    constexpr size_t AOT_PROGRAMS = 6;   // 另外经 AOT 比较的程序数，每个都要调用一次编译器
+    constexpr size_t FUNCS = 3;
+    constexpr size_t BLOCKS = 6;
+    constexpr uint8_t REGS = 8;          // 只用低 8 个寄存器，提高寄存器之间的依赖
+    constexpr int64_t HEAP_SLOTS = 3;    // 静态堆地址 1..HEAP_SLOTS
+
+    int failures = 0;
+
+    void check(bool ok, const std::string& what) {
+        if (ok) return;
+        ++failures;
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+    }
+
+    Instruction make(OpCode op, uint8_t rd = 0, uint8_t rs = 0, int64_t imm = 0, int64_t mem = 0) {
+        Instruction instr;
+        instr.op = op;
+        instr.rd = rd;
+        instr.rs = rs;
+        instr.imm = imm;
+        instr.mem = mem;
+        return instr;
+    }
+
+    // 一个完整的程序：入口、函数表与跳转块表
+    struct Spec {
+        std::vector<Instruction> entry;
+        std::vector<std::vector<Instruction>> funcs;
+        std::vector<std::vector<Instruction>> blocks;
+    };
+
+    class Generator {
+    public:
+        explicit Generator(uint64_t seed) : rng_(seed) {}
+
+        Spec generate() {
+            Spec spec;
+            for (size_t i = 0; i < BLOCKS; ++i) spec.blocks.push_back(body(Where::Block, i, pick(1, 6), 1));
+            for (size_t i = 0; i < FUNCS; ++i) {
+                spec.funcs.push_back(body(Where::Func, i, pick(2, 10), 2));
+                if (pick(0, 3) != 0) spec.funcs.back().push_back(make(OpCode::RET));
+            }
+            spec.entry = body(Where::Entry, 0, pick(4, 24), 2);
+            return spec;
+        }
+
+    private:
+        enum class Where { Entry, Func, Block };
+
+        std::mt19937_64 rng_;
+
+        int64_t pick(int64_t lo, int64_t hi) { return std::uniform_int_distribution<int64_t>(lo, hi)(rng_); }
+        uint8_t reg() { return static_cast<uint8_t>(pick(0, REGS - 1)); }
+
+        // 偏向 0、±1 与边界值，让除法陷阱与溢出足够常见
+        int64_t value() {
+            switch (pick(0, 9)) {
+                case 0: return 0;
+                case 1: return -1;
+                case 2: return INT64_MIN;
+                case 3: return static_cast<int64_t>(rng_());
+                default: return pick(-5, 5);
+            }
+        }
+
+        // 跳转块只能进入下标更大的块，入口与函数可以进入任何块
+        bool blockTarget(Where where, size_t index, int64_t& target) {
+            const size_t first = where == Where::Block ? index + 1 : 0;
+            if (first >= BLOCKS) return false;
+            target = pick(static_cast<int64_t>(first), BLOCKS - 1);
+            return true;
+        }
+
+        std::vector<Instruction> body(Where where, size_t index, int64_t length, int try_depth) {
+            std::vector<Instruction> out;
+            for (int64_t n = 0; n < length; ++n) {
+                int64_t target = 0;
+                switch (pick(0, 15)) {
+                    case 0: case 1:
+                        out.push_back(make(OpCode::MOVRI, reg(), 0, value()));
+                        break;
+                    case 2:
+                        out.push_back(make(OpCode::MOVRR, reg(), reg()));
+                        break;
+                    case 3: {
+                        static constexpr OpCode ops[] = {OpCode::ADDR, OpCode::SUBR, OpCode::MULR, OpCode::DIVR};
+                        out.push_back(make(ops[pick(0, 3)], reg(), reg()));
+                        break;
+                    }
+                    case 4: {
+                        static constexpr OpCode ops[] = {OpCode::ADDI, OpCode::SUBI, OpCode::MULI, OpCode::DIVI};
+                        out.push_back(make(ops[pick(0, 3)], reg(), 0, value()));
+                        break;
+                    }
+                    case 5: {
+                        const int64_t mem = pick(1, HEAP_SLOTS);
+                        switch (pick(0, 2)) {
+                            case 0: out.push_back(make(OpCode::MOVMI, 0, 0, value(), mem)); break;
+                            case 1: out.push_back(make(OpCode::MOVMR, 0, reg(), 0, mem)); break;
+                            default: out.push_back(make(OpCode::MOVMM, 0, 0, reg(), mem)); break;
+                        }
+                        break;
+                    }
+                    case 6: {
+                        static constexpr OpCode ops[] = {OpCode::ADDM, OpCode::SUBM, OpCode::MULM, OpCode::DIVM};
+                        out.push_back(make(ops[pick(0, 3)], reg(), 0, 0, pick(1, HEAP_SLOTS)));
+                        break;
+                    }
+                    case 7: case 8:
+                        if (blockTarget(where, index, target)) {
+                            Instruction branch = make(OpCode::IFRR, reg(), reg(), target);
+                            branch.data = {static_cast<int8_t>(pick(0, OpCodeImpl::CMP_COUNT - 1))};
+                            out.push_back(branch);
+                        }
+                        break;
+                    case 9:
+                        if (blockTarget(where, index, target)) {
+                            Instruction branch = make(OpCode::IFRI, reg(), 0, target);
+                            branch.data = {static_cast<int8_t>(pick(0, OpCodeImpl::CMP_COUNT - 1))};
+                            branch.srcOffset = static_cast<int32_t>(pick(-3, 3));
+                            out.push_back(branch);
+                        }
+                        break;
+                    case 10:
+                        if (blockTarget(where, index, target)) {
+                            const bool with_imm = pick(0, 1) != 0;
+                            Instruction branch = make(OpCodeImpl::fusedBranch(static_cast<int8_t>(pick(0, OpCodeImpl::CMP_COUNT - 1)), with_imm),
+                                                      reg(), with_imm ? 0 : reg(), target);
+                            if (with_imm) branch.srcOffset = static_cast<int32_t>(pick(-3, 3));
+                            out.push_back(branch);
+                        }
+                        break;
+                    case 11: {
+                        // 跳转块不调用函数：函数可以进入任何块，否则可能无限递归
+                        if (where == Where::Block) break;
+                        const size_t first = where == Where::Func ? index + 1 : 0;
+                        if (first < FUNCS) out.push_back(make(OpCode::CALL, 0, 0, pick(static_cast<int64_t>(first), FUNCS - 1)));
+                        break;
+                    }
+                    case 12:
+                        if (try_depth > 0 && blockTarget(where, index, target)) {
+                            out.push_back(make(OpCode::TRY, 0, 0, target));
+                            for (auto& instr : body(where, index, pick(1, 6), try_depth - 1)) out.push_back(std::move(instr));
+                            out.push_back(make(OpCode::ENDTRY));
+                        }
+                        break;
+                    default:
+                        out.push_back(make(OpCode::ADDR, reg(), reg()));
+                        break;
+                }
+            }
+            return out;
+        }
+    };
+
+    // 一次执行的可观察结果
+    struct Outcome {
+        bool trapped = false;
+        TrapCode trap = TrapCode::None;
+        int64_t registers[NUM_REGS]{};
+        int64_t heap[HEAP_SLOTS + 1]{};
+
+        [[nodiscard]] std::string describe() const {
+            std::string text = trapped ? "trap " + std::to_string(static_cast<int64_t>(trap)) : "ok";
+            text += " regs";
+            for (int64_t r : registers) text += " " + std::to_string(r);
+            text += " heap";
+            for (int64_t h = 1; h <= HEAP_SLOTS; ++h) text += " " + std::to_string(heap[h]);
+            return text;
+        }
+    };
+
+    /**
+     * 比较两次执行。未捕获的陷阱把控制交还宿主，优化器不保证此时的寄存器，只比较陷阱与堆
+     */
+    bool same(const Outcome& a, const Outcome& b) {
+        if (a.trapped != b.trapped || a.trap != b.trap) return false;
+        for (int64_t h = 1; h <= HEAP_SLOTS; ++h) {
+            if (a.heap[h] != b.heap[h]) return false;
+        }
+        if (a.trapped) return true;
+        return std::equal(std::begin(a.registers), std::end(a.registers), std::begin(b.registers));
+    }
+
+    class TestVM : public RegisterVM {
+    public:
+        explicit TestVM(const Spec& spec) {
+            for (const auto& func : spec.funcs) newFunc(func);
+            for (const auto& block : spec.blocks) newCall(block);
+        }
+    };
+
+    Outcome observe(RegisterVM& vm, const std::function<void()>& run) {
+        Outcome outcome;
+        try {
+            run();
+        } catch (const VmTrap& e) {
+            outcome.trapped = true;
+            outcome.trap = e.code();
+        }
+        std::copy(std::begin(vm.registers), std::end(vm.registers), std::begin(outcome.registers));
+        for (int64_t h = 1; h <= HEAP_SLOTS; ++h) {
+            // 空槽位、非数组与非 Smi 各用一个不会出现在 Smi 中的标记
+            outcome.heap[h] = INT64_MIN;
+            if (static_cast<size_t>(h) >= vm.heap.size() || vm.heap[h] == nullptr) continue;
+            auto* arr = dynamic_cast<LmArray*>(vm.heap[h]);
+            if (arr == nullptr || arr->get_size() == 0) {
+                outcome.heap[h] = INT64_MIN + 1;
+                continue;
+            }
+            const TaggedVal val = arr->get(0);
+            outcome.heap[h] = TaggedUtil::get_tagged_type(val) == TaggedType::Smi ? TaggedUtil::decode_Smi(val) : INT64_MIN + 2;
+        }
+        return outcome;
+    }
+
+    Outcome runChecked(const Spec& spec) {
+        TestVM vm(spec);
+        std::vector<Instruction> entry = spec.entry;
+        // 先校验以预留静态堆槽位，与其余各档看到同样大小的堆
+        vm.verify(entry);
+        return observe(vm, [&] { vm.run(entry); });
+    }
+
+    Outcome runVerified(const Spec& spec) {
+        TestVM vm(spec);
+        std::vector<Instruction> entry = spec.entry;
+        vm.verify(entry);
+        return observe(vm, [&] { vm.runVerified(entry); });
+    }
+
+    Outcome runOptimized(const Spec& spec) {
+        TestVM vm(spec);
+        std::vector<Instruction> entry = spec.entry;
+        Optimizer::optimizeVM(vm, entry);
+        vm.verify(entry);
+        return observe(vm, [&] { vm.runVerified(entry); });
+    }
+
+    Outcome runAot(const Spec& spec, const std::string& module) {
+        TestVM vm(spec);
+        std::vector<Instruction> entry = spec.entry;
+        vm.verify(entry);
+        AotCompiler::compile(vm, entry, module);
+        AotModule aot(module);
+        aot.bind(vm, entry);
+        return observe(vm, [&] { aot.run(); });
+    }
+
+    // TRY 保护区内被“后续写入覆盖”的寄存器在陷阱时仍对处理块可见
+    void trapHandlerSeesRegisters() {
+        auto handlerResult = [](bool optimize) {
+            Spec spec;
+            spec.blocks.push_back({make(OpCode::MOVRR, 6, 5)});
+            spec.entry = {make(OpCode::TRY, 0, 0, 0), make(OpCode::MOVRI, 5, 0, 1), make(OpCode::MOVRI, 2, 0, 0),
+                          make(OpCode::DIVR, 1, 2), make(OpCode::MOVRI, 5, 0, 2), make(OpCode::MOVRI, 2, 0, 9),
+                          make(OpCode::ENDTRY)};
+            return optimize ? runOptimized(spec) : runVerified(spec);
+        };
+        check(handlerResult(false).registers[6] == 1, "trap handler reads r5 = 1 before optimization");
+        check(handlerResult(true).registers[6] == 1, "trap handler reads r5 = 1 after optimization");
+    }
+
+    // 内层处理块再次出错时由同一帧外层的 TRY 处理，之后从外层 ENDTRY 之后继续
+    Spec nestedHandlerTrap() {
+        Spec spec;
+        spec.blocks.push_back({make(OpCode::MOVRI, 2, 0, 7)});
+        spec.blocks.push_back({make(OpCode::DIVR, 6, 7)});
+        spec.entry = {make(OpCode::MOVRI, 7, 0, 0), make(OpCode::TRY, 0, 0, 0), make(OpCode::TRY, 0, 0, 1),
+                      make(OpCode::DIVR, 6, 7), make(OpCode::ENDTRY), make(OpCode::ENDTRY), make(OpCode::MOVRI, 1, 0, 42)};
+        return spec;
+    }
+
+    void checkNestedHandlerTrap(const Outcome& outcome, const std::string& engine) {
+        check(!outcome.trapped && outcome.registers[2] == 7 && outcome.registers[1] == 42,
+              engine + ": trap in a handler resumes after the outer ENDTRY\n  " + outcome.describe());
+    }
+
+    // 未校验程序中超出 0..63 的 SHLI 按 64 取模，解释执行与常量折叠结果相同
+    void shiftAmountWraps() {
+        auto shifted = [](bool optimize) {
+            RegisterVM vm;
+            std::vector<Instruction> entry = {make(OpCode::MOVRI, 1, 0, 3), make(OpCode::SHLI, 1, 0, 65)};
+            if (optimize) Optimizer::optimize(entry, Optimizer::ProgramKind::Entry);
+            vm.run(entry);
+            return vm.registers[1];
+        };
+        check(shifted(false) == 6, "checked SHLI r1,65 shifts by 1, r1 = " + std::to_string(shifted(false)));
+        check(shifted(true) == 6, "folded SHLI r1,65 shifts by 1, r1 = " + std::to_string(shifted(true)));
+    }
+
+    // 融合比较跳转的常量在源偏移里，只差常量的程序不能绑定同一个 AOT 模块
+    void aotFingerprintCoversOffsets(const std::string& module) {
+        auto spec = [](int32_t constant) {
+            Spec s;
+            s.blocks.push_back({make(OpCode::MOVRI, 0, 0, 1)});
+            Instruction branch = make(OpCode::JLTI, 1, 0, 0);
+            branch.srcOffset = constant;
+            s.entry = {make(OpCode::MOVRI, 1, 0, 6), branch};
+            return s;
+        };
+        const Spec built = spec(5);
+        TestVM vm(built);
+        std::vector<Instruction> entry = built.entry;
+        vm.verify(entry);
+        AotCompiler::compile(vm, entry, module);
+
+        const Spec other = spec(7);
+        TestVM other_vm(other);
+        std::vector<Instruction> other_entry = other.entry;
+        other_vm.verify(other_entry);
+        AotModule aot(module);
+        bool rejected = false;
+        try {
+            aot.bind(other_vm, other_entry);
+        } catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        check(rejected, "AOT module built for JLTI r1,5 must not bind to JLTI r1,7");
+    }
+}
+
+int main() {
+    trapHandlerSeesRegisters();
+    shiftAmountWraps();
+    checkNestedHandlerTrap(runChecked(nestedHandlerTrap()), "checked");
+    checkNestedHandlerTrap(runVerified(nestedHandlerTrap()), "verified");
+    checkNestedHandlerTrap(runOptimized(nestedHandlerTrap()), "optimized");
+
+    size_t trapped = 0;
+    for (uint64_t seed = 1; seed <= PROGRAMS; ++seed) {
+        const Spec spec = Generator(seed).generate();
+        const Outcome checked = runChecked(spec);
+        trapped += checked.trapped;
+        const Outcome verified = runVerified(spec);
+        const Outcome optimized = runOptimized(spec);
+        check(same(checked, verified), "seed " + std::to_string(seed) + ": verified differs from checked\n  checked  "
+                                           + checked.describe() + "\n  verified " + verified.describe());
+        check(same(checked, optimized), "seed " + std::to_string(seed) + ": optimized differs from checked\n  checked   "
+                                            + checked.describe() + "\n  optimized " + optimized.describe());
+    }
+
+    // AOT 依赖运行时调用编译器，编译失败时跳过而不是报错
+    const auto dir = std::filesystem::temp_directory_path();
+    const std::string module = (dir / "lmvm_differential_test.so").string();
+    size_t aot_checked = 0;
+    try {
+        aotFingerprintCoversOffsets(module);
+        checkNestedHandlerTrap(runAot(nestedHandlerTrap(), module), "AOT");
+        for (uint64_t seed = 1; seed <= AOT_PROGRAMS; ++seed) {
+            const Spec spec = Generator(seed).generate();
+            const Outcome checked = runChecked(spec);
+            const Outcome aot = runAot(spec, module);
+            check(same(checked, aot), "seed " + std::to_string(seed) + ": AOT differs from checked\n  checked " + checked.describe()
+                                          + "\n  aot     " + aot.describe());
+            ++aot_checked;
+        }
+    } catch (const std::exception& e) {
+        std::printf("AOT skipped: %s\n", e.what());
+    }
+    std::filesystem::remove(module);
+    std::filesystem::remove(module + ".cpp");
+
+    std::printf("%zu programs (%zu trapped), %zu through AOT, %d failures\n", static_cast<size_t>(PROGRAMS), trapped, aot_checked,
+                failures);
+    return failures == 0 ? 0 : 1;
+}
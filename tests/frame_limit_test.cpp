@@ -0,0 +1,134 @@
+/******************************************************
+-     Date:  2026.10.28 16:00
+-     File:  frame_limit_test.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "../bench/programs.hpp"
+#include "../src/vm/task.hpp"
+#include <cstdio>
+#include <pthread.h>
+#include <string>
+
+/**
+ * 解释帧的栈空间检查：跳转块自递归的循环接近任务栈或宿主栈底部、或超过设置的帧深度上限时抛出 VmStackOverflow，
+ * 而不是让栈溢出；栈放得下的递归照常结束。抛出后虚拟机状态完整，可以继续运行
+ */
+
+using namespace benchprog;
+
+namespace {
+    int failures = 0;
+
+    void check(bool ok, const std::string& what) {
+        if (ok) return;
+        ++failures;
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+    }
+
+    /**
+     * 在任务中按时间片运行到结束，返回是否因帧深度上限结束
+     */
+    bool sliced(BenchVM& vm, const std::vector<Instruction>& entry, int64_t slice) {
+        try {
+            VmTask task(vm, entry);
+            while (task.resume(slice) == VmTask::State::Suspended) {}
+        } catch (const VmStackOverflow&) {
+            return true;
+        }
+        return false;
+    }
+
+    // 默认大小的任务栈上，十万层的跳转块递归在栈溢出之前报错
+    void deepLoopInTask() {
+        BenchVM vm;
+        const std::vector<Instruction> entry = countLoop(vm, 100000);
+        vm.verify(entry);
+        check(sliced(vm, entry, 100000), "countLoop(100000) in a task raises VmStackOverflow");
+        check(vm.maxFrameDepth() == RegisterVM::UNLIMITED_FRAME_DEPTH, "task leaves the VM frame depth limit unchanged");
+
+        // 上限以内的循环照常结束
+        const std::vector<Instruction> shallow = countLoop(vm, 1000);
+        vm.verify(shallow);
+        check(!sliced(vm, shallow, 64), "countLoop(1000) in a task finishes");
+        check(vm.registers[3] == 1000 * 1001 / 2, "countLoop(1000) in a task sums to 500500");
+    }
+
+    // 小任务栈按它自己的栈底报错
+    void smallTaskStack() {
+        BenchVM vm;
+        const std::vector<Instruction> entry = countLoop(vm, 10000);
+        vm.verify(entry);
+        bool overflow = false;
+        try {
+            VmTask task(vm, entry, 256 << 10);
+            while (task.resume(RegisterVM::UNLIMITED_FUEL) == VmTask::State::Suspended) {}
+        } catch (const VmStackOverflow&) {
+            overflow = true;
+        }
+        check(overflow, "countLoop(10000) on a 256 KiB task stack raises VmStackOverflow");
+    }
+
+    // 宿主线程按线程栈的实际边界报错：64 MiB 栈的线程上两万层递归照常结束，更深时报错
+    void bigHostStack() {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr, 64 << 20);
+        pthread_t thread;
+        const int rc = pthread_create(&thread, &attr, [](void*) -> void* {
+            BenchVM vm;
+            const std::vector<Instruction> fits = countLoop(vm, 20000);
+            vm.run(fits);
+            check(vm.registers[3] == 20000LL * 20001 / 2, "countLoop(20000) on a 64 MiB thread sums to 200010000");
+
+            const std::vector<Instruction> deep = countLoop(vm, 10000000);
+            bool overflow = false;
+            try {
+                vm.run(deep);
+            } catch (const VmStackOverflow&) {
+                overflow = true;
+            }
+            check(overflow, "countLoop(10000000) on a 64 MiB thread raises VmStackOverflow");
+            return nullptr;
+        }, nullptr);
+        pthread_attr_destroy(&attr);
+        check(rc == 0, "create a thread with a 64 MiB stack");
+        if (rc == 0) pthread_join(thread, nullptr);
+    }
+
+    // 宿主主线程同样按栈边界报错，调低上限后更早报错
+    void hostThread() {
+        BenchVM vm;
+        const std::vector<Instruction> entry = countLoop(vm, 10000000);
+        bool overflow = false;
+        try {
+            vm.run(entry);
+        } catch (const VmStackOverflow&) {
+            overflow = true;
+        }
+        check(overflow, "countLoop(10000000) on the host thread raises VmStackOverflow");
+
+        vm.setMaxFrameDepth(100);
+        const std::vector<Instruction> limited = countLoop(vm, 200);
+        overflow = false;
+        try {
+            vm.run(limited);
+        } catch (const VmStackOverflow&) {
+            overflow = true;
+        }
+        check(overflow, "countLoop(200) with a 100 frame limit raises VmStackOverflow");
+
+        const std::vector<Instruction> fits = countLoop(vm, 50);
+        vm.run(fits);
+        check(vm.registers[3] == 50 * 51 / 2, "countLoop(50) with a 100 frame limit sums to 1275");
+    }
+}
+
+int main() {
+    deepLoopInTask();
+    smallTaskStack();
+    bigHostStack();
+    hostThread();
+    std::printf("%d failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
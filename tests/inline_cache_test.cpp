@@ -0,0 +1,112 @@
+/******************************************************
+-     Date:  2026.10.29 10:00
+-     File:  inline_cache_test.cpp
+-     CopyRight Lamina Team
+-     This project is followed GPL-3.0 license
+********************************************************/
+#include "../src/vm/switch_table.hpp"
+#include "../src/vm/vm.hpp"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * 调用点缓存与 SWITCH 跳转表的编号存在 Instruction::cache 中，同一程序在另一个虚拟机上运行时编号由别的虚拟机分配，
+ * 可能与本虚拟机中其他调用点的缓存重号；命中缓存前必须确认缓存确实属于这条指令
+ */
+
+namespace {
+    using OpCode = OpCodeImpl::OpCode;
+    using Instruction = OpCodeImpl::Instruction;
+
+    int failures = 0;
+
+    void check(bool ok, const std::string& what) {
+        if (ok) return;
+        ++failures;
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+    }
+
+    Instruction make(OpCode op, uint8_t rd = 0, uint8_t rs = 0, int64_t imm = 0) {
+        Instruction instr;
+        instr.op = op;
+        instr.rd = rd;
+        instr.rs = rs;
+        instr.imm = imm;
+        instr.mem = 0;
+        return instr;
+    }
+
+    // CALLR 命中别的调用点留下的缓存时，捕获值不能越过寄存器末尾
+    void callCacheChecksCaptureBase() {
+        RegisterVM a;
+        RegisterVM b;
+        for (RegisterVM* vm : {&a, &b}) vm->newFunc({make(OpCode::RET)});
+
+        // b 中用 imm=0 调用捕获 16 个值的函数，缓存编号 1 记住该函数；返回后 r1 仍是函数地址
+        Instruction capture_all = make(OpCode::NEWF, 1, 0, 0);
+        for (int8_t r = 0; r < NUM_REGS; ++r) capture_all.data.push_back(r);
+        std::vector<Instruction> fill = {capture_all, make(OpCode::CALLR, 0, 1, 0)};
+        b.run(fill);
+        const size_t heap_size = b.peakHeapSlots();
+
+        // 同一条 imm=12 的 CALLR 先在 a 上运行，分到缓存编号 1（a 中 r1 不是函数，调用失败）
+        std::vector<Instruction> shifted = {make(OpCode::CALLR, 0, 1, 12)};
+        try {
+            a.run(shifted);
+        } catch (const std::runtime_error&) {
+        }
+        check(shifted[0].cache == fill[1].cache, "both CALLR sites share cache index");
+
+        // 再在 b 上以同一个函数对象运行：编号 1 的缓存属于 imm=0 的调用点，不能命中
+        bool rejected = false;
+        try {
+            b.run(shifted);
+        } catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        check(rejected, "CALLR imm=12 with 16 captures is rejected");
+        check(b.peakHeapSlots() == heap_size, "registers past r15 are not written");
+    }
+
+    // SWITCH 不能用别的指令编译的跳转表
+    void switchTableBelongsToInstruction() {
+        RegisterVM a;
+        RegisterVM b;
+        for (RegisterVM* vm : {&a, &b}) {
+            vm->newCall({make(OpCode::MOVRI, 1, 0, 100)});
+            vm->newCall({make(OpCode::MOVRI, 1, 0, 200)});
+        }
+        auto dispatch = [](int32_t block) {
+            Instruction instr = make(OpCode::SWITCH, 0, 0, -1);
+            instr.data = SwitchTable::encode({{0, block}});
+            return std::vector<Instruction>{instr};
+        };
+
+        // b 中 {0 -> 0} 分到编号 1，a 中另一条 {0 -> 1} 也分到编号 1
+        std::vector<Instruction> to_first = dispatch(0);
+        b.run(to_first);
+        std::vector<Instruction> to_second = dispatch(1);
+        a.run(to_second);
+        check(to_first[0].cache == to_second[0].cache, "both SWITCH sites share cache index");
+
+        b.registers[0] = 0;
+        b.run(to_second);
+        check(b.registers[1] == 200, "SWITCH {0 -> 1} run on another VM enters block 1, r1 = " + std::to_string(b.registers[1]));
+
+        // 同一虚拟机中复制的指令用自己的表
+        std::vector<Instruction> copy = to_second;
+        copy[0].data = SwitchTable::encode({{0, 0}});
+        b.registers[0] = 0;
+        b.run(copy);
+        check(b.registers[1] == 100, "copied SWITCH with new cases enters block 0, r1 = " + std::to_string(b.registers[1]));
+    }
+}
+
+int main() {
+    callCacheChecksCaptureBase();
+    switchTableBelongsToInstruction();
+    std::printf("%d failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
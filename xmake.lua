@@ -2,10 +2,35 @@ add_rules("mode.debug", "mode.release")
 set_languages("c++20")
 set_optimize("fastest")
 
+option("profiler")
+    set_default(false)
+    set_description("Enable per-opcode execution profiler")
+    add_defines("LMVM_PROFILE")
+option_end()
+
 target("LMVMCPP")
     set_kind("binary")
+    add_options("profiler")
+    add_defines("LMVM_AOT_INCLUDE=\"$(projectdir)/src\"")
     add_files("src/*.cpp")
     add_files("src/vm/*.cpp")
+    add_files("src/vmcall/*.cpp")
+    if is_plat("linux", "bsd") then
+        add_syslinks("pthread", "dl")
+    end
+
+target("lmvm_bench")
+    set_kind("binary")
+    set_default(false)
+    add_options("profiler")
+    add_defines("LMVM_AOT_INCLUDE=\"$(projectdir)/src\"")
+    add_files("bench/*.cpp")
+    add_files("src/*.cpp|main.cpp")
+    add_files("src/vm/*.cpp")
+    add_files("src/vmcall/*.cpp")
+    if is_plat("linux", "bsd") then
+        add_syslinks("pthread", "dl")
+    end
 
 --target("test_file_generator")
     --set_kind("binary")